@@ -0,0 +1,50 @@
+int counter;
+
+int bump()
+{
+    counter = counter + 1;
+    return counter;
+}
+
+int overwrite(int *p, int *q)
+{
+    *p = 1;
+    *q = 2;
+    return *p;
+}
+
+int f()
+{
+    int a[3][4];
+    int b[3][4];
+    int x[4];
+    int i;
+    int j;
+    int total = 0;
+
+    for (i = 0; i < 3; i++) {
+        for (j = 0; j < 4; j++) {
+            a[i][j] = i + j;
+            b[i][j] = i * j;
+        }
+    }
+    for (i = 0; i < 3; i++) {
+        for (j = 0; j < 4; j++) {
+            a[i][j] = a[i][j] + b[i][j];
+            total = total + a[i][j] * (i + j) + (i + j);
+        }
+    }
+
+    for (i = 0; i < 4; i++) {
+        x[i] = i;
+        x[i] += a[2][i];
+        x[i] *= x[i];
+    }
+    total = total * 10 + x[3] + x[1];
+
+    counter = 5;
+    j = counter;
+    bump();
+    total = total + j * 100 + counter;
+    return total * 10 + overwrite(&i, &i) + overwrite(&i, &j);
+}
@@ -0,0 +1,54 @@
+int sum(int *a, int n)
+{
+    int i;
+    int total = 0;
+
+    for (i = 0; i < n; i++) {
+        total = total + a[i];
+    }
+    return total;
+}
+
+int count(char *s, int n)
+{
+    int i = n;
+    int found = 0;
+
+    while (i != 0) {
+        i--;
+        if (s[i] == 'a') {
+            found++;
+        }
+    }
+    return found;
+}
+
+int f()
+{
+    int grid[4][6];
+    int row[6];
+    char letters[8];
+    int i;
+    int j;
+    int total;
+
+    for (i = 0; i < 4; i++) {
+        for (j = 0; j < 6; j++) {
+            grid[i][j] = i * 10 + j;
+        }
+        row[i] = i * 10 + 20;
+        row[i + 2] = i + 20;
+    }
+    i = 0;
+    while (i < 8) {
+        letters[i] = 'a' + (i % 3);
+        i = i + 2;
+        letters[i - 1] = 'b';
+    }
+
+    total = sum(row, 6) + sum(row, 0) + sum(row, -3);
+    for (i = 1; i < 4; i++) {
+        total = total + 100 * grid[i][i];
+    }
+    return (total * 10 + count(letters, 8)) * 10 + i;
+}
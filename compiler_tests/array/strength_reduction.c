@@ -0,0 +1,24 @@
+int f(int x)
+{
+    int grid[5][3];
+    unsigned u;
+    int i;
+    int j;
+    int total = 0;
+
+    for (i = 0; i < 5; i++) {
+        for (j = 0; j < 3; j++) {
+            grid[i][j] = i * 7 + j * 10;
+        }
+    }
+    for (i = 0; i < 5; i++) {
+        for (j = 0; j < 3; j++) {
+            total = total + grid[i][j] * -6;
+        }
+    }
+
+    u = x;
+    total = total + x / 3 + x % 7 + x / -4 + x % 8;
+    total = total + (0 - x) / 8 + x / 1000 + x % 100;
+    return total + (u / 16) % 1024 + u % 32;
+}
@@ -0,0 +1,6 @@
+int f(int x);
+
+int main()
+{
+    return !(f(-12345) + f(6789) == -3356);
+}
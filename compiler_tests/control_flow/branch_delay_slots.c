@@ -0,0 +1,21 @@
+int g(int x)
+{
+    return x * 2;
+}
+
+int f(int n)
+{
+    int total = 0;
+    int i = 0;
+    int flag;
+    while (i < n) {
+        flag = (i > 2 && i != 5) || i == 0;
+        if (flag) {
+            total = total + g(i);
+        } else {
+            total = total - 1;
+        }
+        i++;
+    }
+    return total;
+}
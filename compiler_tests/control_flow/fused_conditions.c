@@ -0,0 +1,22 @@
+int f(int n, float x)
+{
+    int count = 0;
+    int i = -3;
+    while (i <= n) {
+        if (i < 0 || i > 4) {
+            count = count + 1;
+        }
+        if (!(i >= -1) && i != -3) {
+            count = count + 10;
+        }
+        if (i == 0) {
+            count = count + 100;
+        }
+        if (x > 1.5f) {
+            count = count + 1000;
+        }
+        x = x - 1.0f;
+        i++;
+    }
+    return count + (n > 2 && n < 32768) + (x <= -4.0f || 0);
+}
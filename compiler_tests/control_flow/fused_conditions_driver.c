@@ -0,0 +1,6 @@
+int f(int n, float x);
+
+int main()
+{
+    return !(f(6, 3.0f) == 2117);
+}
@@ -0,0 +1,33 @@
+int g;
+int table[4];
+
+int bump()
+{
+    g = g + 1;
+    return g;
+}
+
+int loops(int *p)
+{
+    int i;
+    int s = 0;
+    int local = 3;
+    int *q = &local;
+
+    g = 2;
+    table[2] = 5;
+    for (i = 0; i < 4; i++) {
+        s = s + g * table[2] + (i * 100000);
+        *p = *p + 1;
+        *q = *q + g;
+    }
+    for (i = 0; i < 3; i++) {
+        s = s + g + bump();
+    }
+    return s + local;
+}
+
+int f()
+{
+    return loops(&g);
+}
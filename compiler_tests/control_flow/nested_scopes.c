@@ -0,0 +1,31 @@
+int f()
+{
+    int total = 0;
+    int i = 0;
+    while (i < 5) {
+        int x = i;
+        int *p = &x;
+        {
+            int y = 10;
+            int *q = &y;
+            total = total + *q;
+        }
+        {
+            int z = 1;
+            int *r = &z;
+            while (1) {
+                int w = *p + *r;
+                if (w > 3) {
+                    break;
+                }
+                total = total + w;
+                z++;
+            }
+        }
+        i++;
+        if (i == 4) {
+            return total + x;
+        }
+    }
+    return 0;
+}
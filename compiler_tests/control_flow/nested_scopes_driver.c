@@ -0,0 +1,7 @@
+
+int f();
+
+int main()
+{
+    return !(f() == 57);
+}
@@ -0,0 +1,19 @@
+int f(int n)
+{
+    unsigned x;
+    int count = 0;
+    x = n;
+    if (x <= 0xffffffff) {
+        count = count + 1;
+    }
+    if (x > 0xffffffff) {
+        count = count + 10;
+    }
+    if (x < 0xffffffff) {
+        count = count + 100;
+    }
+    if (x >= 0xffffffff) {
+        count = count + 1000;
+    }
+    return count;
+}
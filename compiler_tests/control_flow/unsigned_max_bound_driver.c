@@ -0,0 +1,6 @@
+int f(int n);
+
+int main()
+{
+    return !(f(5) == 101 && f(-1) == 1001);
+}
@@ -0,0 +1,44 @@
+int count;
+
+int bump(int n)
+{
+    count = count + n;
+    return count;
+}
+
+double half(double x)
+{
+    count = count + 1;
+    return x / 2.0;
+}
+
+int f()
+{
+    int a[6];
+    int *p;
+    int i;
+    int j;
+    double d;
+
+    i = 0;
+    j = 10;
+    for(p = a; p < a + 6; p++){
+        *p = i;
+        i++;
+        j--;
+    }
+    bump(i);
+    bump(j);
+    d = 3.0;
+    half(d);
+    p = a;
+    p++;
+    p--;
+    i = 0;
+    while(i < 6){
+        count = count * 3 + *p;
+        p++;
+        i++;
+    }
+    return count;
+}
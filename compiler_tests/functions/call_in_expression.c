@@ -0,0 +1,10 @@
+int g(int x)
+{
+    return x;
+}
+
+int f()
+{
+    int a = 3;
+    return g(1) + (g(2) * (g(3) + (g(4) - (g(5) + (g(6) + (g(7) + (g(8) + (g(9) + (g(10) + (g(11) + a * g(12)))))))))));
+}
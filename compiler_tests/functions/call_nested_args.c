@@ -0,0 +1,24 @@
+double scale(double x, float y)
+{
+    return x * 2.0 + y;
+}
+
+int mixed(int a, double b, int c, int d, int e)
+{
+    if (b > 10.0) {
+        return (a + c * d) - e;
+    }
+    return (a - c) + d * e;
+}
+
+int add(int a, int b)
+{
+    return a + b;
+}
+
+int f(int n)
+{
+    int x = add(n, add(n + 1, 2));
+    int y = mixed(x, scale(2.5, 3.0f), add(x, 1), n, add(n, n));
+    return add(y, mixed(1, 1.0, 2, 3, 4));
+}
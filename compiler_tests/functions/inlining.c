@@ -0,0 +1,57 @@
+int later(int x, int y);
+
+int clamp(int x, int low, int high)
+{
+    if (x < low) {
+        return low;
+    }
+    if (x > high) {
+        return high;
+    }
+    return x;
+}
+
+double scale(double x)
+{
+    return x * 2.5;
+}
+
+void increment(int *p, char step)
+{
+    *p = *p + step;
+}
+
+int gcd(int a, int b)
+{
+    if (b == 0) {
+        return a;
+    }
+    return gcd(b, a % b);
+}
+
+int twice(int x)
+{
+    return later(x, x);
+}
+
+int f()
+{
+    int i;
+    int total = 0;
+    double d;
+
+    for (i = -3; i < 12; i++) {
+        total = total + clamp(i * 3, 0, 20);
+        increment(&total, 1);
+    }
+    d = scale(scale(4.0));
+    if (d == 25.0) {
+        total = total + 1000;
+    }
+    return twice(total) + gcd(84, 36) * 10000;
+}
+
+int later(int x, int y)
+{
+    return x + y * 2;
+}
@@ -0,0 +1,38 @@
+int sum5(int a, int b, int c, int d, int e)
+{
+    int total = a + b;
+    int i;
+    for (i = 0; i < e; i++) {
+        total = total + c * d;
+    }
+    return total;
+}
+
+double blend(double x, double y, int n)
+{
+    double r = x;
+    while (n > 0) {
+        r = r + y;
+        n--;
+    }
+    return r;
+}
+
+int table(int i)
+{
+    int values[4];
+    values[0] = 3;
+    values[1] = 5;
+    values[2] = 7;
+    values[3] = 11;
+    return values[i];
+}
+
+int f()
+{
+    int x = sum5(1, 2, 3, 4, 5);
+    if (blend(0.5, 1.5, 3) == 5.0) {
+        x = x + table(2);
+    }
+    return x + table(3);
+}
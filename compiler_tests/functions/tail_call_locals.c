@@ -0,0 +1,16 @@
+int read(int* p, int n);
+
+int f(int n)
+{
+    int x;
+    int a[4];
+    int i;
+    x = n;
+    for (i = 0; i < 4; i++) {
+        a[i] = n + i;
+    }
+    if (n > 10) {
+        return read(&x, 1);
+    }
+    return read(a, 4);
+}
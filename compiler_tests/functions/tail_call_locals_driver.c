@@ -0,0 +1,27 @@
+int f(int n);
+
+int clobber(int n)
+{
+    int junk[16];
+    int i;
+    for (i = 0; i < 16; i++) {
+        junk[i] = -1;
+    }
+    return junk[n];
+}
+
+int read(int* p, int n)
+{
+    int total = 0;
+    int i;
+    clobber(0);
+    for (i = 0; i < n; i++) {
+        total = total + p[i];
+    }
+    return total;
+}
+
+int main()
+{
+    return !(f(20) == 20 && f(1) == 10);
+}
@@ -0,0 +1,51 @@
+int count(int n, int acc)
+{
+    if (n == 0) {
+        return acc;
+    }
+    return count(n - 1, acc + (n % 7));
+}
+
+int gcd(int a, int b)
+{
+    if (b == 0) {
+        return a;
+    }
+    return gcd(b, a % b);
+}
+
+int isOdd(int n);
+
+int isEven(int n)
+{
+    if (n == 0) {
+        return 1;
+    }
+    return isOdd(n - 1);
+}
+
+int isOdd(int n)
+{
+    if (n == 0) {
+        return 0;
+    }
+    return isEven(n - 1);
+}
+
+double halve(double x, int n)
+{
+    if (n == 0) {
+        return x;
+    }
+    return halve(x * 0.5, n - 1);
+}
+
+int f()
+{
+    int x = count(200000, 0);
+    x = x + gcd(1071, 462) * isEven(100001) + isOdd(100001);
+    if (halve(1024.0, 8) == 4.0) {
+        x = x + 1;
+    }
+    return x;
+}
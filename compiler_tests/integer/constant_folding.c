@@ -0,0 +1,15 @@
+enum shift { ONE = 1, TWO, FOUR = 4 };
+
+int g = (3 * 4) + (1 << FOUR);
+
+int f(int x)
+{
+    int y = 5;
+    int z = ((x * 1) + 0) | (0 ^ (x - 0));
+    z = z + ((-7 / 2) * (TWO + ONE));
+    z = z + ((y++) * 0);
+    if (!!(FOUR - 4) || (x && 0)) {
+        return 0;
+    }
+    return z + y + g + (~0 & -1) + (10 % -3);
+}
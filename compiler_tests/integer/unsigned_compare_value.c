@@ -0,0 +1,13 @@
+int f(int a, int b)
+{
+    unsigned u;
+    unsigned v;
+    int r;
+    u = a;
+    v = b;
+    r = (u < v);
+    r = r + (u <= v) * 10;
+    r = r + (u > v) * 100;
+    r = r + (u >= v) * 1000;
+    return r;
+}
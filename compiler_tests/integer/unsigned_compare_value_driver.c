@@ -0,0 +1,6 @@
+int f(int a, int b);
+
+int main()
+{
+    return !(f(-2, 3) == 1100 && f(3, -2) == 11 && f(4, 4) == 1010);
+}
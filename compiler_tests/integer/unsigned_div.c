@@ -0,0 +1,8 @@
+int f(int x, int y)
+{
+    unsigned a;
+    unsigned b;
+    a = x;
+    b = y;
+    return (a / b) % 1000 + (a % b) + ((a / 16) % 32);
+}
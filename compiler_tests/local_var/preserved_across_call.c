@@ -0,0 +1,31 @@
+int g(int n)
+{
+    int a = n;
+    int b = n + 1;
+    int c = n + 2;
+    int d = n + 3;
+    int e = n + 4;
+    int f = n + 5;
+    int h = n + 6;
+    int i = n + 7;
+    int j = n + 8;
+    double x = 0.5;
+    return a + (b + (c + (d + (e + (f + (h + (i + j)))))));
+}
+
+int f()
+{
+    int total = 0;
+    int i = 0;
+    int k = 2;
+    int *p = &k;
+    double scale = 2.0;
+    while (i < 4) {
+        total = total + g(i) * *p;
+        i++;
+    }
+    if (scale == 2.0) {
+        return total;
+    }
+    return 0;
+}
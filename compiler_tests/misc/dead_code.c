@@ -0,0 +1,50 @@
+int g;
+
+int pick(int which, int x)
+{
+    if (which == 0) {
+        return x + 1;
+    }
+    if (which == 1) {
+        return x * 2;
+    }
+    return x;
+    g = 100;
+    return 0;
+}
+
+int store(int *p)
+{
+    *p = 7;
+    *p = 8;
+    return *p;
+}
+
+int f()
+{
+    int unused[4];
+    int kept[2];
+    int i;
+    int total = 0;
+
+    i = 0;
+    while (i < 4) {
+        unused[i] = i * 3;
+        i++;
+        if (i == 3) {
+            continue;
+            total = total + 1000;
+        }
+        total + i;
+        kept[i & 1] = i;
+        kept[0] = kept[i & 1] + total;
+    }
+    g = 1;
+    g = 2;
+    while (i) {
+        total = total + pick(0, 5) + pick(1, 5) + pick(2, 5);
+        break;
+        total = 0;
+    }
+    return total * 100 + store(&kept[1]) * 10 + g + kept[0];
+}
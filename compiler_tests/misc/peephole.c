@@ -0,0 +1,22 @@
+double scale(double x, double y)
+{
+    double a = x;
+    double b = a * y;
+    return b + a;
+}
+
+int mix(int a, int b, int c)
+{
+    return a + b * c;
+}
+
+int f(int n)
+{
+    int x = n;
+    int y = x;
+    int z = mix(x, mix(y, 2, 3), y + 0);
+    if (scale(1.5, 2.0) == 4.5) {
+        z = z + 1;
+    }
+    return z;
+}
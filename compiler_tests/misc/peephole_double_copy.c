@@ -0,0 +1,10 @@
+double g(float a, double b);
+
+double f(float s, double d)
+{
+    double x;
+    float t;
+    x = d;
+    t = s;
+    return g(t, x) + x;
+}
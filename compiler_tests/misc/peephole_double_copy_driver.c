@@ -0,0 +1,11 @@
+double f(float s, double d);
+
+double g(float a, double b)
+{
+    return b * 2.0;
+}
+
+int main()
+{
+    return !(f(1.5f, 2.25) == 6.75);
+}
@@ -0,0 +1,49 @@
+int twice(int x)
+{
+    return x * 2;
+}
+
+double scale(double x, int n)
+{
+    int i;
+    for (i = 0; i < n; i++) {
+        x = x * 1.5;
+    }
+    return x;
+}
+
+int f()
+{
+    int a = 1;
+    int b = 2;
+    int t;
+    int i;
+    int s = 0;
+    i = 0;
+    while (i < 10) {
+        i++;
+        t = a;
+        a = b;
+        b = t;
+        if (i == 8) {
+            break;
+        }
+        if ((i % 3) == 1) {
+            continue;
+        }
+        s = s + twice(a) + b;
+    }
+    switch (s) {
+        case 18:
+            s = s + 1;
+        case 19:
+            s = s + 2;
+            break;
+        default:
+            s = 0;
+    }
+    if (scale(2.0, 3) == 6.75) {
+        s = s + 100;
+    }
+    return s * 10 + a;
+}
@@ -0,0 +1,37 @@
+int dense(int t)
+{
+    int x = 0;
+    switch (t) {
+        case 3:
+            x = 30;
+            break;
+        case 4:
+            x = 40;
+        default:
+            x = x + 1;
+            break;
+        case 6:
+            x = 60;
+            break;
+        case 7:
+            x = 70;
+            break;
+        case 9:
+            return 90;
+    }
+    return x;
+}
+
+int sparse(int t)
+{
+    switch (t) {
+        case 1: return 1;
+        case 10: return 2;
+        case 200: return 3;
+        case 3000: return 4;
+        case 40000: return 5;
+        case 500000: return 6;
+        case 6000000: return 7;
+    }
+    return 0;
+}
@@ -0,0 +1,12 @@
+int dense(int t);
+int sparse(int t);
+
+int main()
+{
+    int sum = 0;
+    int i;
+    for (i = -1; i < 12; i++) {
+        sum = sum + dense(i);
+    }
+    return !(sum == 299 && sparse(200) + sparse(6000000) + sparse(40000) + sparse(2) + sparse(1) == 16);
+}
@@ -0,0 +1,32 @@
+typedef int a_t;
+typedef a_t b_t;
+typedef b_t c_t;
+typedef char letter_t;
+typedef unsigned int count_t;
+typedef a_t *a_ptr_t;
+typedef a_ptr_t also_a_ptr_t;
+typedef int a_rather_long_integer_type_name;
+
+c_t twice(b_t x)
+{
+    return x + x;
+}
+
+int f()
+{
+    a_rather_long_integer_type_name total;
+    letter_t c;
+    count_t n;
+    a_t value;
+    a_ptr_t p;
+    also_a_ptr_t q;
+
+    c = 'A';
+    n = 3;
+    value = 7;
+    p = &value;
+    q = p;
+    *q = *p + 1;
+    total = twice(value) + c + n;
+    return total;
+}
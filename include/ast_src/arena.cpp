@@ -0,0 +1,22 @@
+#include "arena.hpp"
+
+const std::size_t Arena::chunkSize = 64 * 1024;
+
+char* Arena::next = nullptr;
+char* Arena::end = nullptr;
+
+void* Arena::allocate(std::size_t size) {
+    const std::size_t alignment = alignof(std::max_align_t);
+    size = (size + alignment - 1) / alignment * alignment;
+
+    if (size > chunkSize / 4) {
+        return new char[size];
+    }
+    if ((std::size_t)(end - next) < size) {
+        next = new char[chunkSize];
+        end = next + chunkSize;
+    }
+    char* result = next;
+    next += size;
+    return result;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+
+/*
+    Bump pointer allocator for the AST nodes, their types and the frames of a translation unit.
+
+    Allocation moves a pointer through chunks of chunkSize bytes, bigger objects get a chunk of
+    their own. Nothing is given back: nodes share subtrees, types and frames freely, so they all
+    stay alive until the compiler exits, which releases the chunks with the rest of the process.
+*/
+class Arena
+{
+public:
+    static void* allocate(std::size_t size);
+
+private:
+    static const std::size_t chunkSize;
+
+    // free part of the current chunk
+    static char* next;
+    static char* end;
+};
@@ -0,0 +1,510 @@
+#include "assembly.hpp"
+
+#include <set>
+
+static std::string trim(const std::string &s) {
+    size_t start = s.find_first_not_of(" \t\r");
+    if (start == std::string::npos) {
+        return "";
+    }
+    size_t end = s.find_last_not_of(" \t\r");
+    return s.substr(start, end - start + 1);
+}
+
+std::string AsmLine::toString() const {
+    switch (kind) {
+        case Kind::LABEL:
+            return text + ":";
+        case Kind::INSTRUCTION:
+        {
+            std::string out = op;
+            for (size_t i = 0; i < args.size(); i++) {
+                out += (i == 0 ? " " : ", ") + args[i];
+            }
+            return out;
+        }
+        default:
+            return text;
+    }
+}
+
+std::vector<AsmLine> parseAssembly(std::istream &assemblyIn) {
+    std::vector<AsmLine> lines;
+    std::string raw;
+    while (std::getline(assemblyIn, raw)) {
+        AsmLine line;
+        line.text = trim(raw);
+        if (line.text.empty()) {
+            line.kind = AsmLine::Kind::EMPTY;
+        } else if (line.text[0] == '#') {
+            line.kind = AsmLine::Kind::COMMENT;
+        } else if (line.text[0] == '.') {
+            line.kind = AsmLine::Kind::DIRECTIVE;
+        } else if (line.text.back() == ':') {
+            line.kind = AsmLine::Kind::LABEL;
+            line.text.pop_back();
+        } else {
+            line.kind = AsmLine::Kind::INSTRUCTION;
+            size_t split = line.text.find_first_of(" \t");
+            line.op = line.text.substr(0, split);
+            if (split != std::string::npos) {
+                std::string rest = line.text.substr(split);
+                size_t pos = 0;
+                while (pos != std::string::npos) {
+                    size_t comma = rest.find(',', pos);
+                    line.args.push_back(trim(rest.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos)));
+                    pos = comma == std::string::npos ? comma : comma + 1;
+                }
+            }
+        }
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+void printAssembly(std::ostream &assemblyOut, const std::vector<AsmLine> &lines) {
+    for (const AsmLine &line : lines) {
+        assemblyOut << line.toString() << std::endl;
+    }
+}
+
+// doubles use pairs of floating point registers, both are named by the even one
+static std::string normaliseReg(const std::string &reg) {
+    if (reg.size() > 2 && reg[1] == 'f' && isdigit(reg[2])) {
+        return "$f" + std::to_string(std::stoi(reg.substr(2)) & ~1);
+    }
+    return reg;
+}
+
+// base register of a memory operand such as -8($fp), "" if it is not of that form
+static std::string baseReg(const std::string &operand) {
+    size_t open = operand.find('(');
+    size_t close = operand.find(')');
+    if (open == std::string::npos || close == std::string::npos || close < open) {
+        return "";
+    }
+    return operand.substr(open + 1, close - open - 1);
+}
+
+static bool contains(const std::vector<std::string> &regs, const std::string &reg) {
+    return std::find(regs.begin(), regs.end(), reg) != regs.end();
+}
+
+static const std::set<std::string> threeRegOps = {
+    "addu", "subu", "add", "sub", "and", "or", "xor", "nor", "slt", "sltu", "sllv", "srlv", "srav", "mul"
+};
+static const std::set<std::string> immOps = {
+    "addiu", "addi", "andi", "ori", "xori", "slti", "sltiu", "sll", "srl", "sra"
+};
+static const std::set<std::string> loadOps = {
+    "lw", "lb", "lbu", "lh", "lhu", "l.s", "l.d", "lwc1", "ldc1"
+};
+static const std::set<std::string> storeOps = {
+    "sw", "sb", "sh", "s.s", "s.d", "swc1", "sdc1"
+};
+static const std::set<std::string> floatThreeRegOps = {
+    "add.s", "add.d", "sub.s", "sub.d", "mul.s", "mul.d", "div.s", "div.d"
+};
+static const std::set<std::string> floatTwoRegOps = {
+    "mov.s", "mov.d", "neg.s", "neg.d", "abs.s", "abs.d"
+};
+
+/*
+    Positions in args of the registers an instruction reads and writes
+    (memory operands such as -8($fp) are reads of their base register)
+    and registers that are used without appearing in args.
+*/
+static bool operandRoles(const AsmLine &line, std::vector<int> &readArgs, std::vector<int> &writeArgs,
+    std::vector<std::string> &implicitReads, std::vector<std::string> &implicitWrites) {
+    const std::string &op = line.op;
+    const std::vector<std::string> &args = line.args;
+    readArgs.clear();
+    writeArgs.clear();
+    implicitReads.clear();
+    implicitWrites.clear();
+
+    if (op == "nop") {
+        return true;
+    } else if ((threeRegOps.count(op) || floatThreeRegOps.count(op)) && args.size() == 3) {
+        writeArgs = {0}; readArgs = {1, 2};
+    } else if (immOps.count(op) && args.size() == 3) {
+        writeArgs = {0}; readArgs = {1};
+    } else if ((op == "move" || floatTwoRegOps.count(op) || op.rfind("cvt.", 0) == 0 || op.rfind("trunc.", 0) == 0) && args.size() == 2) {
+        writeArgs = {0}; readArgs = {1};
+    } else if ((op == "li" || op == "la" || op == "lui") && args.size() == 2) {
+        writeArgs = {0};
+    } else if ((op == "mflo" || op == "mfhi") && args.size() == 1) {
+        writeArgs = {0}; implicitReads = {op == "mflo" ? "$lo" : "$hi"};
+    } else if ((op == "div" || op == "divu" || op == "mult" || op == "multu") && args.size() == 2) {
+        readArgs = {0, 1}; implicitWrites = {"$hi", "$lo"};
+    } else if (loadOps.count(op) && args.size() == 2 && baseReg(args[1]) != "") {
+        writeArgs = {0}; readArgs = {1};
+    } else if (storeOps.count(op) && args.size() == 2 && baseReg(args[1]) != "") {
+        readArgs = {0, 1};
+    } else if (op.rfind("c.", 0) == 0 && args.size() == 2) {
+        readArgs = {0, 1}; implicitWrites = {"$fcc"};
+    } else if (op == "mtc1" && args.size() == 2) {
+        // both have the integer register first
+        readArgs = {0}; writeArgs = {1};
+    } else if (op == "mfc1" && args.size() == 2) {
+        writeArgs = {0}; readArgs = {1};
+    } else if ((op == "beq" || op == "bne") && args.size() == 3) {
+        readArgs = {0, 1};
+    } else if ((op == "blez" || op == "bgtz" || op == "bltz" || op == "bgez" || op == "beqz" || op == "bnez") && args.size() == 2) {
+        readArgs = {0};
+    } else if ((op == "bc1t" || op == "bc1f") && args.size() == 1) {
+        implicitReads = {"$fcc"};
+    } else if ((op == "j" || op == "b") && args.size() == 1) {
+        // no registers
+    } else if (op == "jal" && args.size() == 1) {
+        // arguments are read by the callee, after the delay slot
+        implicitWrites = {"$31"};
+    } else if (op == "jr" && args.size() == 1) {
+        readArgs = {0};
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool instructionRegisters(const AsmLine &line, std::vector<std::string> &reads, std::vector<std::string> &writes) {
+    std::vector<int> readArgs, writeArgs;
+    if (!operandRoles(line, readArgs, writeArgs, reads, writes)) {
+        return false;
+    }
+    for (int arg : readArgs) {
+        std::string base = baseReg(line.args[arg]);
+        reads.push_back(normaliseReg(base != "" ? base : line.args[arg]));
+    }
+    for (int arg : writeArgs) {
+        writes.push_back(normaliseReg(line.args[arg]));
+    }
+
+    // $0 is never changed
+    writes.erase(std::remove(writes.begin(), writes.end(), "$0"), writes.end());
+    return true;
+}
+
+// format of the floating point value in an argument: 'd' for doubles, 's' for everything else
+static char argFormat(const std::string &op, int arg) {
+    if (op == "l.d" || op == "ldc1" || op == "s.d" || op == "sdc1") {
+        return 'd';
+    } else if (op.rfind("cvt.", 0) == 0 || op.rfind("trunc.", 0) == 0) {
+        // cvt.<result>.<operand>
+        return arg == 0 ? op[op.find('.') + 1] : op.back();
+    } else if (op.size() > 2 && op[op.size() - 2] == '.') {
+        return op.back();
+    }
+    return 's';
+}
+
+// a double argument is both registers of its pair
+static void addHalves(std::vector<std::string> &regs, const std::string &op, int arg, const std::string &reg) {
+    regs.push_back(reg);
+    if (reg.size() > 2 && reg[1] == 'f' && isdigit(reg[2]) && argFormat(op, arg) == 'd') {
+        regs.push_back("$f" + std::to_string(std::stoi(reg.substr(2)) + 1));
+    }
+}
+
+bool instructionHalves(const AsmLine &line, std::vector<std::string> &reads, std::vector<std::string> &writes) {
+    std::vector<int> readArgs, writeArgs;
+    if (!operandRoles(line, readArgs, writeArgs, reads, writes)) {
+        return false;
+    }
+    for (int arg : readArgs) {
+        std::string base = baseReg(line.args[arg]);
+        if (base != "") {
+            reads.push_back(base);
+        } else {
+            addHalves(reads, line.op, arg, line.args[arg]);
+        }
+    }
+    for (int arg : writeArgs) {
+        addHalves(writes, line.op, arg, line.args[arg]);
+    }
+    writes.erase(std::remove(writes.begin(), writes.end(), "$0"), writes.end());
+    return true;
+}
+
+bool replaceReads(AsmLine &line, const std::string &from, const std::string &to) {
+    std::vector<int> readArgs, writeArgs;
+    std::vector<std::string> implicitReads, implicitWrites;
+    if (!operandRoles(line, readArgs, writeArgs, implicitReads, implicitWrites) || contains(implicitReads, normaliseReg(from))) {
+        return false;
+    }
+
+    // check everything can be replaced before changing anything
+    for (int arg : readArgs) {
+        std::string base = baseReg(line.args[arg]);
+        std::string reg = base != "" ? base : line.args[arg];
+        if (reg != from && normaliseReg(reg) == normaliseReg(from)) {
+            return false;
+        }
+    }
+    for (int arg : readArgs) {
+        std::string &operand = line.args[arg];
+        std::string base = baseReg(operand);
+        if (base == from) {
+            operand = operand.substr(0, operand.find('(') + 1) + to + ")";
+        } else if (base == "" && operand == from) {
+            operand = to;
+        }
+    }
+    return true;
+}
+
+bool replaceWrite(AsmLine &line, const std::string &from, const std::string &to) {
+    std::vector<int> readArgs, writeArgs;
+    std::vector<std::string> implicitReads, implicitWrites;
+    if (!operandRoles(line, readArgs, writeArgs, implicitReads, implicitWrites)
+        || writeArgs.size() != 1 || !implicitWrites.empty() || line.args[writeArgs[0]] != from) {
+        return false;
+    }
+    line.args[writeArgs[0]] = to;
+    return true;
+}
+
+bool isBranch(const AsmLine &line) {
+    static const std::set<std::string> branchOps = {
+        "beq", "bne", "blez", "bgtz", "bltz", "bgez", "beqz", "bnez", "bc1t", "bc1f", "j", "b", "jal", "jr", "jalr"
+    };
+    return line.kind == AsmLine::Kind::INSTRUCTION && branchOps.count(line.op) > 0;
+}
+
+static int targetArg(const AsmLine &line) {
+    if (line.op == "jr" || line.op == "jalr") {
+        return -1;
+    }
+    return (int)line.args.size() - 1;
+}
+
+std::string branchTarget(const AsmLine &line) {
+    int arg = targetArg(line);
+    return arg < 0 ? "" : line.args[arg];
+}
+
+static bool isInstruction(const std::vector<AsmLine> &lines, int i) {
+    return i >= 0 && i < (int)lines.size() && lines[i].kind == AsmLine::Kind::INSTRUCTION;
+}
+
+static bool isBranchAt(const std::vector<AsmLine> &lines, int i) {
+    return isInstruction(lines, i) && isBranch(lines[i]);
+}
+
+int nextLine(const std::vector<AsmLine> &lines, int i, bool skipLabels) {
+    i++;
+    while (i < (int)lines.size() && (lines[i].kind == AsmLine::Kind::EMPTY || lines[i].kind == AsmLine::Kind::COMMENT
+        || (skipLabels && lines[i].kind == AsmLine::Kind::LABEL))) {
+        i++;
+    }
+    return i;
+}
+
+int prevLine(const std::vector<AsmLine> &lines, int i, bool skipLabels) {
+    i--;
+    while (i >= 0 && (lines[i].kind == AsmLine::Kind::EMPTY || lines[i].kind == AsmLine::Kind::COMMENT
+        || (skipLabels && lines[i].kind == AsmLine::Kind::LABEL))) {
+        i--;
+    }
+    return i;
+}
+
+static int findLabel(const std::vector<AsmLine> &lines, const std::string &label) {
+    for (int i = 0; i < (int)lines.size(); i++) {
+        if (lines[i].kind == AsmLine::Kind::LABEL && lines[i].text == label) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// a delay slot must hold a single machine instruction
+static bool fitsDelaySlot(const AsmLine &line) {
+    std::vector<std::string> reads, writes;
+    if (!instructionRegisters(line, reads, writes) || isBranch(line) || line.op == "nop" || line.op == "la") {
+        return false;
+    }
+    if (line.op == "li") {
+        try {
+            long long value = std::stoll(line.args[1], nullptr, 0);
+            return value >= -32768 && value <= 65535;
+        } catch (const std::exception &) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// instructions that can be executed on a path they were not on, as long as the register they write is not used
+static bool isSpeculationSafe(const AsmLine &line) {
+    static const std::set<std::string> safeOps = {
+        "addu", "subu", "and", "or", "xor", "nor", "slt", "sltu", "sllv", "srlv", "srav",
+        "addiu", "andi", "ori", "xori", "slti", "sltiu", "sll", "srl", "sra",
+        "move", "li", "lui", "mflo", "mfhi", "mfc1", "mtc1", "mov.s", "mov.d"
+    };
+    std::vector<std::string> reads, writes;
+    if (!fitsDelaySlot(line) || safeOps.count(line.op) == 0 || !instructionRegisters(line, reads, writes)) {
+        return false;
+    }
+    return writes.size() == 1 && writes[0] != "$sp" && writes[0] != "$fp" && writes[0] != "$31";
+}
+
+static bool isCallerSaved(const std::string &reg) {
+    if (reg == "$hi" || reg == "$lo" || reg == "$fcc" || reg == "$v1" || reg.rfind("$t", 0) == 0 || reg.rfind("$a", 0) == 0) {
+        return true;
+    }
+    // $f0 holds the return value, $f20-$f30 are callee saved
+    if (reg.size() > 2 && reg[1] == 'f' && isdigit(reg[2])) {
+        int n = std::stoi(reg.substr(2));
+        return n >= 2 && n < 20;
+    }
+    return false;
+}
+
+// arguments are passed in $a and $f12/$f14 which are caller saved as well
+static bool isFreeAfterCall(const std::string &reg) {
+    return isCallerSaved(reg) && reg.rfind("$a", 0) != 0 && normaliseReg(reg) != "$f12" && normaliseReg(reg) != "$f14";
+}
+
+bool isDeadAt(const std::vector<AsmLine> &lines, int i, std::vector<std::string> regs) {
+    std::vector<std::string> reads, writes;
+    for (; i < (int)lines.size(); i++) {
+        const AsmLine &line = lines[i];
+        if (line.kind == AsmLine::Kind::EMPTY || line.kind == AsmLine::Kind::COMMENT || line.kind == AsmLine::Kind::LABEL) {
+            continue;
+        }
+        if (line.kind != AsmLine::Kind::INSTRUCTION || !instructionHalves(line, reads, writes)) {
+            return false;
+        }
+        // a jump out of the function is a tail call
+        if (line.op == "jal" || (line.op == "j" && findLabel(lines, line.args[0]) < 0)) {
+            return std::all_of(regs.begin(), regs.end(), isFreeAfterCall);
+        }
+        if (line.op == "jr") {
+            return line.args[0] == "$31" && std::all_of(regs.begin(), regs.end(), isCallerSaved);
+        }
+        for (const std::string &reg : regs) {
+            if (contains(reads, reg)) {
+                return false;
+            }
+        }
+        // only dead once every register holding it is written
+        for (const std::string &reg : writes) {
+            regs.erase(std::remove(regs.begin(), regs.end(), reg), regs.end());
+        }
+        if (regs.empty()) {
+            return true;
+        }
+        if (isBranch(line)) {
+            return false;
+        }
+    }
+    return false;
+}
+
+// moves the instruction before the branch at i into its delay slot
+static bool fillFromBefore(std::vector<AsmLine> &lines, int &i) {
+    int p = prevLine(lines, i, false);
+    // p can't be moved if it is itself in a delay slot
+    if (!isInstruction(lines, p) || !fitsDelaySlot(lines[p]) || isBranchAt(lines, prevLine(lines, p, true))) {
+        return false;
+    }
+
+    std::vector<std::string> reads, writes, branchReads, branchWrites;
+    instructionRegisters(lines[p], reads, writes);
+    instructionRegisters(lines[i], branchReads, branchWrites);
+    for (const std::string &reg : writes) {
+        if (contains(branchReads, reg) || contains(branchWrites, reg)) {
+            return false;
+        }
+    }
+    for (const std::string &reg : reads) {
+        if (contains(branchWrites, reg)) {
+            return false;
+        }
+    }
+
+    lines[i + 1] = lines[p];
+    lines.erase(lines.begin() + p);
+    i--;
+    return true;
+}
+
+// copies the first instruction at the target of the branch at i into its delay slot and branches past it
+static bool fillFromTarget(std::vector<AsmLine> &lines, int &i, bool conditional) {
+    int target = findLabel(lines, branchTarget(lines[i]));
+    if (target < 0) {
+        return false;
+    }
+    int t = nextLine(lines, target, true);
+    if (!isInstruction(lines, t) || !fitsDelaySlot(lines[t]) || isBranchAt(lines, prevLine(lines, t, true))) {
+        return false;
+    }
+    // the instruction is also executed when a conditional branch is not taken
+    if (conditional) {
+        std::vector<std::string> reads, writes;
+        instructionHalves(lines[t], reads, writes);
+        if (!isSpeculationSafe(lines[t]) || !isDeadAt(lines, i + 2, writes)) {
+            return false;
+        }
+    }
+
+    lines[i + 1] = lines[t];
+
+    // branch to the line after the copied instruction
+    std::string label;
+    if (t + 1 < (int)lines.size() && lines[t + 1].kind == AsmLine::Kind::LABEL) {
+        label = lines[t + 1].text;
+    } else {
+        AsmLine newLabel;
+        newLabel.kind = AsmLine::Kind::LABEL;
+        newLabel.text = generateUniqueLabel("delaySlot");
+        label = newLabel.text;
+        lines.insert(lines.begin() + t + 1, newLabel);
+        if (t + 1 <= i) {
+            i++;
+        }
+    }
+    lines[i].args[targetArg(lines[i])] = label;
+    return true;
+}
+
+// moves the first instruction after a conditional branch into its delay slot
+static bool fillFromFallThrough(std::vector<AsmLine> &lines, int i) {
+    int f = nextLine(lines, i + 1, false);
+    if (!isInstruction(lines, f) || !isSpeculationSafe(lines[f])) {
+        return false;
+    }
+    int target = findLabel(lines, branchTarget(lines[i]));
+    std::vector<std::string> reads, writes;
+    instructionHalves(lines[f], reads, writes);
+    if (target < 0 || !isDeadAt(lines, target + 1, writes)) {
+        return false;
+    }
+
+    lines[i + 1] = lines[f];
+    lines.erase(lines.begin() + f);
+    return true;
+}
+
+void fillDelaySlots(std::vector<AsmLine> &lines) {
+    for (int i = 0; i < (int)lines.size(); i++) {
+        if (!isBranch(lines[i]) || !isInstruction(lines, i + 1) || lines[i + 1].op != "nop") {
+            continue;
+        }
+
+        if (fillFromBefore(lines, i)) {
+            continue;
+        }
+
+        const std::string &op = lines[i].op;
+        if (op == "jal" || op == "jr" || op == "jalr") {
+            continue;
+        }
+        if (op == "j" || op == "b") {
+            fillFromTarget(lines, i, false);
+        } else if (!fillFromFallThrough(lines, i)) {
+            fillFromTarget(lines, i, true);
+        }
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "ast.hpp"
+
+/*
+    Post processing of the assembly generated for a function.
+
+    The code of a function is first written to a buffer, split into lines,
+    optimised and then written to the output.
+*/
+struct AsmLine
+{
+    enum struct Kind {
+        EMPTY,
+        COMMENT,
+        LABEL,
+        DIRECTIVE,
+        INSTRUCTION
+    };
+
+    Kind kind;
+
+    // text of the line, label name without ':' for labels
+    std::string text;
+
+    // only used by instructions
+    std::string op;
+    std::vector<std::string> args;
+
+    // instructions are printed from op and args so they can be modified
+    std::string toString() const;
+};
+
+std::vector<AsmLine> parseAssembly(std::istream &assemblyIn);
+void printAssembly(std::ostream &assemblyOut, const std::vector<AsmLine> &lines);
+
+/*
+    Registers read and written by an instruction.
+    The condition flag of the fpu is "$fcc", hi and lo are "$hi" and "$lo".
+    Floating point registers are named by the even register of their pair.
+    Returns false for instructions that are not known, which are never moved.
+*/
+bool instructionRegisters(const AsmLine &line, std::vector<std::string> &reads, std::vector<std::string> &writes);
+
+/*
+    Same with the registers named exactly: both registers of a pair for doubles,
+    only the one that is used for singles.
+*/
+bool instructionHalves(const AsmLine &line, std::vector<std::string> &reads, std::vector<std::string> &writes);
+
+/*
+    Replaces the register from with to wherever the instruction reads it.
+    Returns false without changing anything if that is not possible
+    (e.g. the register is read implicitly or as half of a double).
+*/
+bool replaceReads(AsmLine &line, const std::string &from, const std::string &to);
+
+// same for the destination, only works for instructions writing a single register
+bool replaceWrite(AsmLine &line, const std::string &from, const std::string &to);
+
+bool isBranch(const AsmLine &line);
+
+/*
+    Whether the registers holding a value (named as by instructionHalves) are all written
+    before any of them is read when execution continues at line i.
+    Conservative: gives up at branches other than calls and returns.
+*/
+bool isDeadAt(const std::vector<AsmLine> &lines, int i, std::vector<std::string> regs);
+
+// index of the line after/before i, skipping comments and empty lines (and labels if skipLabels is set)
+int nextLine(const std::vector<AsmLine> &lines, int i, bool skipLabels);
+int prevLine(const std::vector<AsmLine> &lines, int i, bool skipLabels);
+
+// label a branch or jump goes to, "" for jr
+std::string branchTarget(const AsmLine &line);
+
+/*
+    Replaces the nop after branches and jumps (the code is generated with .set noreorder)
+    with useful instructions. In order of preference:
+    * the instruction before the branch if the branch does not depend on it
+    * the first instruction of the target for unconditional jumps, the jump then skips it
+    * for conditional branches, the first instruction of one of the paths
+      if it only writes a register that is not used on the other path
+*/
+void fillDelaySlots(std::vector<AsmLine> &lines);
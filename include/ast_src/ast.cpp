@@ -1,4 +1,5 @@
 #include "ast.hpp"
+#include "ir.hpp"
 
 void AST::generateFrames(Frame* _frame){
     throw std::runtime_error("AST: generateFrames Not implemented yet by child class.\n");
@@ -8,10 +9,64 @@ void AST::compile(std::ostream &assemblyOut) {
     throw std::runtime_error("AST: compile Not implemented yet by child class.\n");
 }
 
+void AST::compileToReg(std::ostream &assemblyOut, const std::string &reg) {
+    throw std::runtime_error("AST: compileToReg Not implemented yet by child class.\n");
+}
+
+int AST::getRegNeed() {
+    return 1;
+}
+
+bool AST::hasSideEffects() {
+    return true;
+}
+
+void AST::compileAndDiscard(std::ostream &assemblyOut) {
+    std::string reg = allocateReg(usesFloatReg(this));
+    resultUnused = true;
+    compileToReg(assemblyOut, reg);
+    resultUnused = false;
+    freeReg(reg);
+}
+
+void AST::compileBranch(std::ostream &assemblyOut, const std::string &label, bool jumpIf) {
+    std::string reg = allocateReg(false);
+    compileCondToReg(assemblyOut, this, reg);
+    freeReg(reg);
+
+    assemblyOut << (jumpIf ? "bne " : "beq ") << reg << ", $0, " << label << std::endl;
+    assemblyOut << "nop" << std::endl;
+}
+
+AST* AST::fold() {
+    return this;
+}
+
 void AST::updateVariable(std::ostream &assemblyOut, Frame* currentFrame, std::string reg) {
     throw std::runtime_error("AST: updateVariable Not implemented by child class.\n");
 }
 
+void AST::lower(IRBuilder &builder) {
+    lowerToValue(builder);
+}
+
+IRInstr* AST::lowerToValue(IRBuilder &builder) {
+    throw IRUnsupported("AST: lowerToValue Not implemented by child class.\n");
+}
+
+void AST::lowerBranch(IRBuilder &builder, IRBlock* trueBlock, IRBlock* falseBlock) {
+    IRInstr* value = lowerToValue(builder);
+    // like compileCondToReg, floating point values are tested on their bits
+    if (value->type == IRType::FLOAT || value->type == IRType::DOUBLE) {
+        value = builder.emit(IROp::FBITS, IRType::WORD, {value});
+    }
+    builder.branch(value, trueBlock, falseBlock);
+}
+
+void AST::lowerUpdate(IRBuilder &builder, IRInstr* value) {
+    throw IRUnsupported("AST: lowerUpdate Not implemented by child class.\n");
+}
+
 AST* AST::deepCopy(){
     throw std::runtime_error("AST: deepCopy Not implemented by child class.\n");
 }
@@ -21,16 +76,38 @@ void AST::setType(std::string newType) {
 }
 
 AST* AST::getType(){
+    if (cachedType == nullptr) {
+        cachedType = computeType();
+    }
+    return cachedType;
+}
+
+const std::string& AST::getTypeName(){
+    if (!hasTypeName) {
+        cachedTypeName = computeTypeName();
+        hasTypeName = true;
+    }
+    return cachedTypeName;
+}
+
+TypeKind AST::getTypeKind(){
+    if (!hasTypeKind) {
+        cachedTypeKind = AST_Type::kindOf(getTypeName());
+        hasTypeKind = true;
+    }
+    return cachedTypeKind;
+}
+
+AST* AST::computeType(){
     std::cerr << "AST::getType: Not implemented by child class: Returning default type int" << std::endl;
-    std::string typeName = "int";
-    return new AST_Type(&typeName);
+    return AST_Type::get(TypeKind::INT);
 }
 
 int AST::getBytes(){
     throw std::runtime_error("AST: getBytes Not implemented by child class.\n");
 }
 
-std::string AST::getTypeName(){
+std::string AST::computeTypeName(){
     std::cerr << "AST::getTypeName: Not implemented by child class: Returning default type int" << std::endl;
     return "int";
 }
@@ -63,20 +140,18 @@ double AST::getDoubleValue() {
     throw std::runtime_error("AST: getDoubleValue Not implemented by child class.\n");
 }
 
-AST::~AST() {
-    delete frame;
-}
-
 Frame::Frame(Frame* _parentFrame) :
     parentFrame(_parentFrame)
-{}
-
-Frame::~Frame() {
-    delete parentFrame;
+{
+    // nested scopes place their variables after the ones of the enclosing scope
+    if (parentFrame != nullptr && !parentFrame->isGlobal) {
+        memOcc = parentFrame->memOcc;
+        memSize = memOcc;
+    }
 }
 
 int Frame::getVarPos(const std::string &variableName) const{
-    auto variableBinding = variableBindings.find(variableName);
+    auto variableBinding = variableBindings.find(Symbols::intern(variableName));
     if (variableBinding != variableBindings.end()) {
         return variableBinding->second;
     }
@@ -84,50 +159,136 @@ int Frame::getVarPos(const std::string &variableName) const{
 }
 
 std::pair<int, int> Frame::getVarAddress(const std::string &variableName) {
-    int depth = 0;
-    Frame* frame = this;
-    int pos = frame->getVarPos(variableName);
-    while(pos == -1){
-        depth++;
-        frame = frame->parentFrame;
+    const std::string* key = Symbols::intern(variableName);
+    Frame* frame = findVarFrame(key);
+    if (frame == nullptr) {
+        return {-1,-1};
+    }
+    return {0, frame->variableBindings[key]};
+}
 
-        if (frame->isGlobal) {
-            return {-1,-1};
+AST* Frame::getVarType(const std::string& variableName) const{
+    const std::string* key = Symbols::intern(variableName);
+    for (const Frame* frame = this; ; frame = frame->parentFrame) {
+        auto it = frame->variableType.find(key);
+        if(it != frame->variableType.end()) {
+            return it->second;
         }
+    }
+}
 
-        pos = frame->getVarPos(variableName);
+Frame* Frame::findVarFrame(const std::string* key) {
+    Frame* frame = this;
+    while (!frame->isGlobal) {
+        if (frame->variableBindings.count(key) != 0) {
+            return frame;
+        }
+        frame = frame->parentFrame;
     }
-    return {depth, pos};
+    return nullptr;
 }
 
-AST* Frame::getVarType(const std::string& variableName) const{
-    auto it = variableType.find(variableName);
-    if(it != variableType.end()) {
-        return it->second;
+Frame* Frame::getVarFrame(const std::string& variableName) {
+    return findVarFrame(Symbols::intern(variableName));
+}
+
+std::string Frame::getVarReg(const std::string& variableName) {
+    const std::string* key = Symbols::intern(variableName);
+    Frame* frame = findVarFrame(key);
+    if (frame == nullptr) {
+        return "";
     }
-    else {
-        return parentFrame->getVarType(variableName);
+    auto it = frame->variableRegisters.find(key);
+    if (it != frame->variableRegisters.end()) {
+        return it->second;
     }
+    return "";
+}
+
+void Frame::setVarReg(const std::string& variableName, const std::string& reg) {
+    variableRegisters[Symbols::intern(variableName)] = reg;
+}
+
+void Frame::setAddressTaken(const std::string& variableName) {
+    addressTaken.insert(Symbols::intern(variableName));
+}
+
+bool Frame::isAddressTaken(const std::string& variableName) const {
+    return addressTaken.count(Symbols::intern(variableName)) != 0;
 }
 
 void Frame::addVariable(const std::string &variableName, AST* type, int byteSize) {
-    variableBindings[variableName] = memOcc;
-    variableType[variableName] = type;
+    // parameters are added to the function frame once the body is done,
+    // so they must not overlap with any of the nested scopes
+    if (fn != nullptr) {
+        memOcc = memSize;
+    }
+
+    const std::string* key = Symbols::intern(variableName);
+    variableBindings[key] = memOcc;
+    variableType[key] = type;
+    if (RegisterAllocator::current != nullptr) {
+        RegisterAllocator::current->addVariable(this, variableName);
+    }
     memOcc += byteSize + 8 - 1 - (byteSize + 8 - 1)%8;
+
+    // the function frame has to be large enough for all of its scopes
+    for (Frame* frame = this; frame != nullptr && !frame->isGlobal; frame = frame->parentFrame) {
+        frame->memSize = std::max(frame->memSize, memOcc);
+    }
 }
 
 void Frame::addFunction(const std::string &name, AST* fn){
-    functions[name] = fn;
+    functions[Symbols::intern(name)] = fn;
 }
 
 AST* Frame::getFunction(const std::string &name){
-    auto it = functions.find(name);
-    if(it != functions.end()) {
-        return it->second;
+    const std::string* key = Symbols::intern(name);
+    for (Frame* frame = this; ; frame = frame->parentFrame) {
+        auto it = frame->functions.find(key);
+        if(it != frame->functions.end()) {
+            return it->second;
+        }
+    }
+}
+
+Frame* Frame::findFunctionFrame(const std::string* key) {
+    Frame* frame = this;
+    while (frame->functions.count(key) == 0 && frame->parentFrame != nullptr) {
+        frame = frame->parentFrame;
     }
-    else {
-        return parentFrame->getFunction(name);
+    return frame;
+}
+
+void Frame::addCall(const std::string& name) {
+    const std::string* key = Symbols::intern(name);
+    findFunctionFrame(key)->callCounts[key]++;
+}
+
+int Frame::getCallCount(const std::string& name) {
+    const std::string* key = Symbols::intern(name);
+    Frame* frame = findFunctionFrame(key);
+    auto it = frame->callCounts.find(key);
+    return it == frame->callCounts.end() ? 0 : it->second;
+}
+
+void Frame::addEnumConstant(const std::string& name, int value) {
+    enumConstants[Symbols::intern(name)] = value;
+}
+
+bool Frame::getEnumConstant(const std::string& name, int& value) {
+    const std::string* key = Symbols::intern(name);
+    for (Frame* frame = this; frame != nullptr; frame = frame->parentFrame) {
+        auto it = frame->enumConstants.find(key);
+        if (it != frame->enumConstants.end()) {
+            value = it->second;
+            return true;
+        }
+        if (frame->variableType.find(key) != frame->variableType.end()) {
+            return false;
+        }
     }
+    return false;
 }
 
 int Frame::getStoreSize() const {
@@ -135,7 +296,7 @@ int Frame::getStoreSize() const {
 }
 
 int Frame::getVarStoreSize() const {
-    return memOcc;
+    return memSize;
 }
 
 void Frame::setLoopLabelNames(std::string _startLoopLabelName, std::string _endLoopLabelName) {
@@ -161,6 +322,24 @@ std::pair<int, AST*> Frame::getFnInfo(){
     return {i, frame->fn};
 }
 
+Frame* Frame::getFnFrame(){
+    Frame* frame = this;
+    while(frame->fn == nullptr){
+        frame = frame->parentFrame;
+    }
+    return frame;
+}
+
+void Frame::addSavedRegister(const std::string& reg) {
+    savedRegisters.push_back({reg, memSize});
+    memSize += 8;
+    memOcc = memSize;
+}
+
+const std::vector<std::pair<std::string, int>>& Frame::getSavedRegisters() const {
+    return savedRegisters;
+}
+
 std::pair<std::string, int> Frame::getStartLoopLabelName(std::ostream &assemblyOut) {
     int i = 0;
     Frame* frame = this;
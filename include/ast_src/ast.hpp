@@ -7,8 +7,25 @@
 #include <unordered_map>
 #include <map>
 #include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+#include <sstream>
+#include <set>
+
+#include "arena.hpp"
+#include "symbols.hpp"
 
 class Frame;
+class IRFunction;
+class IRBuilder;
+class IRInstr;
+class IRBlock;
+
+/*
+    What code generation needs to know about a type, every type name belongs to one kind
+    (see AST_Type::kindOf). Pointers and arrays are POINTER.
+*/
+enum class TypeKind { INT, UNSIGNED, CHAR, FLOAT, DOUBLE, VOID, POINTER, STRUCT };
 
 /*
     Base class for all ast nodes
@@ -16,11 +33,14 @@ class Frame;
 class AST
 {
 public:
-    Frame* frame;
+    Frame* frame = nullptr;
     bool isVar = false;
     bool returnPtr = false;
 
-    virtual ~AST();
+    // nodes live in the Arena until the compiler exits
+    static void* operator new(std::size_t size) { return Arena::allocate(size); }
+    static void operator delete(void* node) {}
+    virtual ~AST() = default;
     
     /*
         Generates frames and creates context for them
@@ -32,9 +52,64 @@ public:
     */
     virtual void compile(std::ostream &assemblyOut);
 
+    /*
+        Code generation for expressions.
+        Writes MIPS assembly that leaves the value of the expression in reg
+        (see util.hpp for the register pool).
+    */
+    virtual void compileToReg(std::ostream &assemblyOut, const std::string &reg);
+
+    /*
+        Sethi-Ullman number of the expression.
+        Number of registers (including the destination) needed to evaluate it without spilling.
+    */
+    virtual int getRegNeed();
+
+    /*
+        Whether evaluating the expression can change program state.
+        Operands with side effects are always evaluated left to right.
+    */
+    virtual bool hasSideEffects();
+
+    /*
+        Used by expressions to implement compile (expression statements).
+        Evaluates the expression into a temporary register and discards the result.
+        resultUnused is set meanwhile, so compileToReg can leave out the work that only
+        produces the value, like copying the result of a call or keeping the old value of i++.
+    */
+    void compileAndDiscard(std::ostream &assemblyOut);
+    bool resultUnused = false;
+
+    /*
+        Code generation for conditions (if, while, &&, ||).
+        Jumps to label if the truth value of the expression is jumpIf, falls through otherwise.
+        By default the value is evaluated into a register and compared to 0.
+    */
+    virtual void compileBranch(std::ostream &assemblyOut, const std::string &label, bool jumpIf);
+
+    /*
+        Constant folding and algebraic simplification.
+        Runs after generateFrames and before compile.
+        Returns the node that should take the place of this one in the tree (this if nothing changed).
+        Replaced nodes are not deleted since they share their frame with the rest of the tree.
+    */
+    virtual AST* fold();
+
     // overriden by AST_Variable
     virtual void updateVariable(std::ostream &assemblyOut, Frame* currentFrame, std::string reg);
 
+    /*
+        Lowering to the intermediate representation (see ir.hpp), the counterparts of
+        compile, compileToReg, compileBranch and updateVariable.
+        lowerToValue returns the value of the expression and lowerBranch continues in
+        trueBlock or falseBlock depending on its truth value.
+        Nodes that can't be lowered throw IRUnsupported.
+    */
+    virtual void lower(IRBuilder &builder);
+    virtual IRInstr* lowerToValue(IRBuilder &builder);
+    virtual void lowerBranch(IRBuilder &builder, IRBlock* trueBlock, IRBlock* falseBlock);
+    virtual void lowerUpdate(IRBuilder &builder, IRInstr* value);
+
     /*
         This function is only required for source translation of things like short hand assignements
         Deep copy does not currently copy:
@@ -48,12 +123,18 @@ public:
         These function is required whenever the type of a node is needed
 
         Only implemented by Expressions and children of expressions
-        (constants, variables, operators, etc.)
+        (constants, variables, operators, etc.) through computeType and computeTypeName.
+        getType and getTypeName compute the type the first time they are called, which must be
+        after generateFrames, and return the same result for the node afterwards.
     */
-    virtual AST* getType();
+    AST* getType();
     virtual int getBytes();
 
-    virtual std::string getTypeName();
+    const std::string& getTypeName();
+    TypeKind getTypeKind();
+
+    virtual AST* computeType();
+    virtual std::string computeTypeName();
 
     virtual std::string getName();
 
@@ -66,6 +147,14 @@ public:
     virtual int getIntValue();
     virtual float getFloatValue();
     virtual double getDoubleValue();
+
+private:
+    // set by getType, getTypeName and getTypeKind
+    AST* cachedType = nullptr;
+    std::string cachedTypeName;
+    bool hasTypeName = false;
+    TypeKind cachedTypeKind;
+    bool hasTypeKind = false;
 };
 
 /*
@@ -78,18 +167,44 @@ private:
     /* 
         map of variable names to memory address relative to frame pointer
         retrieve using 'lw ${destinationReg} {variableBindings[variableName]}($fp)'
+        the maps of names are keyed on the interned name (see symbols.hpp), so looking
+        a name up in every enclosing scope only hashes the string once
     */ 
-    std::unordered_map<std::string, int> variableBindings;
-    std::unordered_map<std::string, AST*> variableType;
-    std::unordered_map<std::string, AST*> functions;
+    std::unordered_map<const std::string*, int> variableBindings;
+    std::unordered_map<const std::string*, AST*> variableType;
+    std::unordered_map<const std::string*, AST*> functions;
+    // number of calls of the functions declared in this scope
+    std::unordered_map<const std::string*, int> callCounts;
+
+    // values of enum constants declared in this scope
+    std::unordered_map<const std::string*, int> enumConstants;
+
+    /*
+        map of variable names to the register holding them (see regalloc.hpp)
+        variables not in this map live in memory
+    */
+    std::unordered_map<const std::string*, std::string> variableRegisters;
+
+    // variables of this scope whose address is taken
+    std::set<const std::string*> addressTaken;
+
+    /*
+        callee saved registers used by the function and their memory address relative to the frame pointer
+        only used in the frame of a function body
+    */
+    std::vector<std::pair<std::string, int>> savedRegisters;
 
     // information about how much memory is needed to preserve previous stack
     // currently only stores state of $fp and $31
     int storeSize = 16;
     
     // information about current memory occupied by variables
+    // all scopes of a function share its frame, scopes that don't overlap reuse the same memory
     int memOcc = 0;
 
+    // memory needed by the variables of this scope and all nested scopes
+    int memSize = 0;
+
     /*
         Must be a normal map to preserve ordering.
         Especially important to guarantee that default only appears at end.
@@ -102,6 +217,10 @@ private:
     */
     std::map<std::string, int> caseLabelValueMapping;
 
+    // getVarFrame and the frame addCall counts in for an interned name
+    Frame* findVarFrame(const std::string* key);
+    Frame* findFunctionFrame(const std::string* key);
+
 public:
     /*
         Pointer to the parent frame.
@@ -117,7 +236,9 @@ public:
 
     Frame(Frame* _parentFrame = nullptr);
 
-    ~Frame();
+    // frames live in the Arena like the nodes they belong to
+    static void* operator new(std::size_t size) { return Arena::allocate(size); }
+    static void operator delete(void* frame) {}
 
     /*
         First tries to find variable in current frame.
@@ -125,11 +246,30 @@ public:
         and so on.
         
         Returns {-1,-1} if the global frame is reached.
+        Otherwise the second element is the position relative to the frame pointer of the function
+        (all scopes of a function share a single frame so the first element is always 0).
     */
     int getVarPos(const std::string& variableName) const;
     std::pair<int, int> getVarAddress(const std::string &variableName);
     AST* getVarType(const std::string& variableName) const;
 
+    /*
+        Frame the variable has been declared in.
+        Returns nullptr for global variables.
+    */
+    Frame* getVarFrame(const std::string& variableName);
+
+    /*
+        Register the variable is kept in.
+        Returns "" if the variable lives in memory.
+    */
+    std::string getVarReg(const std::string& variableName);
+    void setVarReg(const std::string& variableName, const std::string& reg);
+
+    // set by RegisterAllocator::allocate in the frame the variable is declared in
+    void setAddressTaken(const std::string& variableName);
+    bool isAddressTaken(const std::string& variableName) const;
+
     /*
         Does not check if variable already exists.
         If the variable name already exists, it will be overriden.
@@ -142,6 +282,21 @@ public:
     void addFunction(const std::string &name, AST* fn);
     AST* getFunction(const std::string& name);
 
+    /*
+        Counts the calls of a function in the scope it is declared in,
+        calls of functions that aren't declared are counted in the outermost frame.
+    */
+    void addCall(const std::string& name);
+    int getCallCount(const std::string& name);
+
+    /*
+        Enum constants are also added as variables, this only records their value.
+        getEnumConstant returns false if the name is not an enum constant in this scope
+        (including when it is shadowed by a variable).
+    */
+    void addEnumConstant(const std::string& name, int value);
+    bool getEnumConstant(const std::string& name, int& value);
+
     /*
         Used for moving '$sp' pointer when creating new stack frame.
         Is how much memory is required to preserve previous frames state.
@@ -152,7 +307,7 @@ public:
 
     /*
         Used to set stack pointer in a new frame.
-        Is how much memory is required to contain all local variables
+        Is how much memory is required to contain all local variables (including nested scopes)
     */
     int getVarStoreSize() const;
 
@@ -171,8 +326,34 @@ public:
         Expects there to be a function
         Does not do error checking
     */
-    AST* fn;
+    AST* fn = nullptr;
     std::pair<int, AST*> getFnInfo();
+    Frame* getFnFrame();
+
+    /*
+        Reserves memory in the frame to preserve a callee saved register.
+    */
+    void addSavedRegister(const std::string& reg);
+    const std::vector<std::pair<std::string, int>>& getSavedRegisters() const;
+
+    /*
+        Shape of the stack frame of a function, decided by RegisterAllocator::allocate.
+        Only used in the frame of a function body.
+        $31 only has to be saved by functions that make calls. Functions that also keep
+        all of their variables in registers they don't need to save don't need a frame at all.
+    */
+    bool savesReturnAddress = true;
+    bool hasStackFrame = true;
+
+    /*
+        Whether the function has locals that can be pointed to: arrays, structs and variables
+        whose address is taken. Tail calls free the frame before the callee runs so they can't be used then.
+        Decided by RegisterAllocator::allocate.
+    */
+    bool hasAddressedLocals = false;
+
+    // label after the prologue that self recursive tail calls jump to, "" if there are none
+    std::string tailCallLabel;
 
     /* 
         Used for 'break' and 'continue'.
@@ -198,4 +379,6 @@ public:
 
 // Need to come at end of file as dependent on declarations above
 #include "util.hpp"
+#include "regalloc.hpp"
+#include "assembly.hpp"
 #include "primitive.hpp"
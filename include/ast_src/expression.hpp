@@ -22,30 +22,55 @@ public:
     void generateFrames(Frame* _frame = nullptr) override;
     AST* deepCopy() override;
     void compile(std::ostream &assemblyOut) override;
-
-    ~AST_Assign();
+    AST* fold() override;
+    void compileToReg(std::ostream &assemblyOut, const std::string &reg) override;
+    IRInstr* lowerToValue(IRBuilder &builder) override;
+    int getRegNeed() override;
+    bool hasSideEffects() override;
+
+    AST* computeType() override;
+    std::string computeTypeName() override;
 };
 
 class AST_FunctionCall
     : public AST
 {
 private:
-    std::string functionName;
+    const std::string &functionName;
     std::vector<AST*>* args;
     int parity; // number of arguments
 
+    // in argument order, the ones with side effects first like in compileToReg
+    std::vector<IRInstr*> lowerArguments(IRBuilder &builder);
+
 public:
-    AST_FunctionCall(std::string* _functionName, std::vector<AST*>* _args = nullptr);
+    // set by return statements returning the value of the call
+    bool isTailCall = false;
+
+    AST_FunctionCall(const std::string* _functionName, std::vector<AST*>* _args = nullptr);
 
     void generateFrames(Frame* _frame = nullptr) override;
     AST* deepCopy() override;
     void compile(std::ostream &assemblyOut) override;
-
-    AST* getType() override;
+    AST* fold() override;
+    void compileToReg(std::ostream &assemblyOut, const std::string &reg) override;
+    IRInstr* lowerToValue(IRBuilder &builder) override;
+
+    /*
+        A call in tail position can take the place of the return of the function it is in
+        if all of its arguments are passed in registers and it returns its value the same way.
+        Calls of the function itself then become a jump back to its start after its
+        parameters have been replaced, other calls a jump to the callee after the frame is torn down.
+    */
+    bool canTailCall(Frame* fnFrame);
+    void compileTailCall(std::ostream &assemblyOut, Frame* fnFrame);
+    void lowerTailCall(IRBuilder &builder);
+
+    AST* computeType() override;
     int getBytes() override;
-    std::string getTypeName() override;
-
-    ~AST_FunctionCall();
+    std::string computeTypeName() override;
+    // name of the function called
+    std::string getName() override;
 };
 
 /*
@@ -81,6 +106,19 @@ private:
     AST* left;
     AST* right;
 
+    /*
+        Evaluates both operands into registers in Sethi-Ullman order.
+        One of them can end up in reg, the caller frees the others.
+    */
+    void compileOperands(std::ostream &assemblyOut, const std::string &reg, std::string &leftReg, std::string &rightReg);
+    bool leftEvaluatedFirst();
+
+    // used by fold, return nullptr if the operation can't be folded
+    AST* foldInt(int l, int r);
+    AST* foldFloating(double l, double r, bool isFloat);
+    // removes operations with no effect such as x+0 or x*1
+    AST* simplify();
+
 public:
     // Used for float to int conversion when binOp is a comparison
     AST* internalDataType;
@@ -90,14 +128,20 @@ public:
     void generateFrames(Frame* _frame = nullptr) override;
     AST* deepCopy() override;
     void compile(std::ostream &assemblyOut) override;
+    AST* fold() override;
+    void compileToReg(std::ostream &assemblyOut, const std::string &reg) override;
+    void compileBranch(std::ostream &assemblyOut, const std::string &label, bool jumpIf) override;
+    IRInstr* lowerToValue(IRBuilder &builder) override;
+    void lowerBranch(IRBuilder &builder, IRBlock* trueBlock, IRBlock* falseBlock) override;
+    int getRegNeed() override;
+    bool hasSideEffects() override;
 
     // Required when for example a float comparison produces an int (boolean)
     void setType(std::string newType) override;
 
-    AST* getType() override;
+    AST* computeType() override;
     int getBytes() override;
-
-    ~AST_BinOp();
+    std::string computeTypeName() override;
 };
 
 class AST_UnOp
@@ -120,14 +164,26 @@ public:
 
     AST_UnOp(Type _type, AST* _operand);
 
+    /*
+        Folds an expression whose value is only used as a condition (if, while, && and ||).
+        In that context !!x is the same as x.
+    */
+    static AST* foldCondition(AST* cond);
+
     void generateFrames(Frame* _frame = nullptr) override;
     AST* deepCopy() override;
     void compile(std::ostream &assemblyOut) override;
-
-    AST* getType() override;
+    AST* fold() override;
+    void compileToReg(std::ostream &assemblyOut, const std::string &reg) override;
+    void compileBranch(std::ostream &assemblyOut, const std::string &label, bool jumpIf) override;
+    IRInstr* lowerToValue(IRBuilder &builder) override;
+    void lowerBranch(IRBuilder &builder, IRBlock* trueBlock, IRBlock* falseBlock) override;
+    int getRegNeed() override;
+    bool hasSideEffects() override;
+
+    AST* computeType() override;
     int getBytes() override;
-
-    ~AST_UnOp();
+    std::string computeTypeName() override;
 };
 
 class AST_Sizeof
@@ -142,9 +198,10 @@ public:
 
     void generateFrames(Frame* _frame = nullptr) override;
     void compile(std::ostream &assemblyOut) override;
+    AST* fold() override;
+    void compileToReg(std::ostream &assemblyOut, const std::string &reg) override;
+    bool hasSideEffects() override;
 
-    AST* getType() override;
+    AST* computeType() override;
     int getBytes() override;
-
-    ~AST_Sizeof();
 };
@@ -1,4 +1,7 @@
 #include "expression.hpp"
+#include "structure.hpp"
+#include "ir.hpp"
+#include "pipeline.hpp"
 
 AST_Assign::AST_Assign(AST* _assignee, AST* _expr):
     assignee(_assignee),
@@ -19,58 +22,88 @@ AST* AST_Assign::deepCopy(){
 }
 
 void AST_Assign::compile(std::ostream &assemblyOut){
-    std::string varType = assignee->getType()->getTypeName();
+    compileAndDiscard(assemblyOut);
+}
+
+void AST_Assign::compileToReg(std::ostream &assemblyOut, const std::string &reg){
+    TypeKind varType = assignee->getType()->getTypeKind();
 
     std::string name = generateUniqueLabel("assignment");
-    assemblyOut << std::endl << "# start " << name << " for " << varType << std::endl;
+    assemblyOut << std::endl << "# start " << name << " for " << assignee->getType()->getTypeName() << std::endl;
 
     // compile expresison
-    expr->compile(assemblyOut);
-
-    // compile assignee location
-    assignee->compile(assemblyOut);
+    expr->compileToReg(assemblyOut, reg);
 
-    // load memory address to assign to
-    assemblyOut << "lw $t1, 8($sp)" << std::endl;
+    if (assignee->isVar) {
+        // variables don't need their address computed
+        assignee->updateVariable(assemblyOut, frame, reg);
+    } else {
+        // compile assignee location
+        bool spill = !enoughRegs(assignee->getRegNeed());
+        if (spill) {
+            pushReg(assemblyOut, reg);
+            freeReg(reg);
+        }
+        std::string addressReg = allocateReg(false);
+        assignee->compileToReg(assemblyOut, addressReg);
+        if (spill) {
+            reclaimReg(assemblyOut, reg, addressReg);
+        }
 
-    if (varType == "float") {
-        // load result of expression
-        assemblyOut << "l.s $f4, 16($sp)" << std::endl;
-        
         // assign memory address
-        assemblyOut << "s.s $f4, 0($t1)" << std::endl;
-    } else if (varType == "double") {
-        // load result of expression
-        assemblyOut << "l.d $f4, 16($sp)" << std::endl;
-        
-        // assign memory address
-        assemblyOut << "s.d $f4, 0($t1)" << std::endl;
-    } else if (varType == "char"){
-        // load result of expression
-        assemblyOut << "lw $t0, 16($sp)" << std::endl;
+        if (varType == TypeKind::FLOAT) {
+            assemblyOut << "s.s " << reg << ", 0(" << addressReg << ")" << std::endl;
+        } else if (varType == TypeKind::DOUBLE) {
+            assemblyOut << "s.d " << reg << ", 0(" << addressReg << ")" << std::endl;
+        } else if (varType == TypeKind::CHAR){
+            assemblyOut << "sb " << reg << ", 0(" << addressReg << ")" << std::endl;
+        } else {
+            assemblyOut << "sw " << reg << ", 0(" << addressReg << ")" << std::endl;
+        }
+        freeReg(addressReg);
+    }
 
-        // assign memory address
-        assemblyOut << "sb $t0, 0($t1)" << std::endl;
+    assemblyOut << "# end " << name << " for " << assignee->getType()->getTypeName() << std::endl << std::endl;
+}
+
+IRInstr* AST_Assign::lowerToValue(IRBuilder &builder){
+    TypeKind varType = assignee->getType()->getTypeKind();
+    IRInstr* value = expr->lowerToValue(builder);
+    if (assignee->isVar) {
+        assignee->lowerUpdate(builder, value);
     } else {
-        // load result of expression
-        assemblyOut << "lw $t0, 16($sp)" << std::endl;
+        builder.store(value, assignee->lowerToValue(builder), varType == TypeKind::CHAR);
+    }
+    return value;
+}
 
-        // assign memory address
-        assemblyOut << "sw $t0, 0($t1)" << std::endl;
+int AST_Assign::getRegNeed(){
+    if (assignee->isVar) {
+        return expr->getRegNeed();
     }
+    return std::max(expr->getRegNeed(), 1 + assignee->getRegNeed());
+}
 
-    // pop memory address
-    assemblyOut << "addiu $sp, $sp, 8" << std::endl;
+bool AST_Assign::hasSideEffects(){
+    return true;
+}
 
-    assemblyOut << "# end " << name << " for " << varType << std::endl << std::endl;
+// the value of an assignment is the value that was assigned
+AST* AST_Assign::computeType(){
+    return expr->getType();
 }
 
-AST_Assign::~AST_Assign(){
-    delete assignee;
-    delete expr;
+std::string AST_Assign::computeTypeName(){
+    return expr->getTypeName();
 }
 
-AST_FunctionCall::AST_FunctionCall(std::string* _functionName, std::vector<AST*>* _args):
+AST* AST_Assign::fold(){
+    assignee = assignee->fold();
+    expr = expr->fold();
+    return this;
+}
+
+AST_FunctionCall::AST_FunctionCall(const std::string* _functionName, std::vector<AST*>* _args):
     functionName(*_functionName),
     args(_args)
 {
@@ -80,6 +113,10 @@ AST_FunctionCall::AST_FunctionCall(std::string* _functionName, std::vector<AST*>
 
 void AST_FunctionCall::generateFrames(Frame* _frame){
     frame = _frame;
+    frame->addCall(functionName);
+    if(RegisterAllocator::current != nullptr){
+        RegisterAllocator::current->recordCall(this);
+    }
     if(args != nullptr){
         for(AST* arg: *args){
             arg->generateFrames(_frame);
@@ -87,6 +124,15 @@ void AST_FunctionCall::generateFrames(Frame* _frame){
     }
 }
 
+AST* AST_FunctionCall::fold(){
+    if(args != nullptr){
+        for(AST*& arg: *args){
+            arg = arg->fold();
+        }
+    }
+    return this;
+}
+
 AST* AST_FunctionCall::deepCopy(){
     std::vector<AST*>* new_args = nullptr;
     if(args!=nullptr){
@@ -100,207 +146,264 @@ AST* AST_FunctionCall::deepCopy(){
 }
 
 void AST_FunctionCall::compile(std::ostream &assemblyOut) {
+    compileAndDiscard(assemblyOut);
+}
+
+// moves an argument that was evaluated into valueReg to where it is passed (see argumentLocations)
+static void passArgument(std::ostream &assemblyOut, const std::string& valueReg, TypeKind kind, const std::string& argReg, int argOffset) {
+    if(argReg == ""){
+        std::string store = kind == TypeKind::FLOAT ? "s.s " : kind == TypeKind::DOUBLE ? "s.d " : "sw ";
+        assemblyOut << store << valueReg << ", " << argOffset << "($sp)" << std::endl;
+    }
+    else if(argReg[1] == 'f'){
+        std::string move = kind == TypeKind::DOUBLE ? "mov.d " : "mov.s ";
+        assemblyOut << move << argReg << ", " << valueReg << std::endl;
+    }
+    else if(kind == TypeKind::DOUBLE){
+        // double is split over two argument registers, most significant word first
+        int valueRegNum = std::stoi(valueReg.substr(2));
+        std::string argReg_2 = std::string("$a") + std::to_string(argOffset / 4 + 1);
+        assemblyOut << "mfc1 " << argReg << ", $f" << valueRegNum + 1 << std::endl;
+        assemblyOut << "mfc1 " << argReg_2 << ", " << valueReg << std::endl;
+    }
+    else if(kind == TypeKind::FLOAT){
+        assemblyOut << "mfc1 " << argReg << ", " << valueReg << std::endl;
+    }
+    else{
+        assemblyOut << "move " << argReg << ", " << valueReg << std::endl;
+    }
+}
+
+void AST_FunctionCall::compileToReg(std::ostream &assemblyOut, const std::string &reg) {
     assemblyOut << std::endl << "# start function call " << functionName << std::endl;
-    
+
+    // temporary registers are not preserved by the callee
+    std::vector<std::string> savedRegs = saveLiveRegs(assemblyOut, reg);
+
     int argMemSize = 0;
+    std::vector<std::string> argRegs;
     if(args != nullptr){
-        // loop to calculate required sizes
-        for(int i = 0; i < args->size(); i++){
-            std::string paramTypeName = args->at(i)->getTypeName();
-            if(paramTypeName == "double"){
-                if(argMemSize % 8)
-                    argMemSize += 4;
-                argMemSize += 8;
-            }
-            else{
-                argMemSize += 4;
-            }
-        }
-
-        if(argMemSize % 8){
-            assemblyOut << "addiu $sp, $sp, -4" << std::endl;
+        // arguments are stored in reverse order
+        std::vector<AST*> argList(args->rbegin(), args->rend());
+        std::vector<TypeKind> kinds;
+        for(AST* arg: argList){
+            kinds.push_back(arg->getType()->getTypeKind());
         }
+        std::vector<int> argOffsets;
+        argMemSize = argumentLocations(kinds, argOffsets, argRegs);
         assemblyOut << "addiu $sp, $sp, -" << argMemSize << std::endl;
 
-        // state variables
-        bool allowFReg = true;
-        bool loadFromReg = true;
-        int availableAReg = 0;
-        int availableFReg = 12;
-        int memOffset = 0;
-
-        // loop through arguments
-        for (int i = args->size() - 1, arg_i = 0; arg_i < args->size(); i--, arg_i++) {
-            std::string paramTypeName = args->at(i)->getTypeName(); 
-            bool useMem = !loadFromReg;
-
-            // compiler argument expression
-            args->at(i)->compile(assemblyOut);
-            assemblyOut << "addiu $sp, $sp, 8" << std::endl;
-            
-            if(loadFromReg){
-                if(paramTypeName == "float" || paramTypeName == "double"){
-                    // this part is the same for floats and doubles
-                    if(allowFReg){
-                        assemblyOut << "# (storing a " << paramTypeName << " type to f reg)" << std::endl;
-                        std::string reg = std::string("$f") + std::to_string(availableFReg);
-                        if(paramTypeName == "float")
-                            assemblyOut << "l.s " << reg << ", 0($sp)" << std::endl;
-                        else
-                            assemblyOut << "l.d " << reg << ", 0($sp)" << std::endl;
-
-                        // update state
-                        availableFReg += 2;
-                        availableAReg++;
-                        memOffset += 4;
-                        if(paramTypeName == "double"){
-                            availableAReg++;
-                            memOffset += 4;
-                        }
-
-                        if(availableFReg == 16)
-                            allowFReg = false;
-                        if(availableAReg == 4)
-                            loadFromReg = false;
-                    }
-                    else{
-                        assemblyOut << "# (storing a " << paramTypeName << " type to a reg)" << std::endl;
-                        
-                        if(paramTypeName == "double"){
-                            if(availableAReg % 2){
-                                memOffset += 4;
-                                availableAReg++;
-                            }
-                            
-                            if(availableAReg < 4){
-                                std::string reg = std::string("$a") + std::to_string(availableAReg);
-                                std::string reg_2 = std::string("$a") + std::to_string(availableAReg+1);
-                                assemblyOut << "lw " << reg << ", 0($sp)" << std::endl;
-                                assemblyOut << "lw " << reg_2 << ", -4($sp)" << std::endl;
-
-                                // update state
-                                availableAReg += 2;
-                                memOffset += 8;
-                            }
-                            else{
-                                loadFromReg = false;
-                                useMem = true;
-                            }
-                        }
-                        else{
-                            std::string reg = std::string("$a") + std::to_string(availableAReg);
-                            assemblyOut << "lw " << reg << ", 0($sp)" << std::endl;
-                            
-                            // update state
-                            availableAReg++;
-                            memOffset += 4;
-                        }
-
-                        // check state
-                        if(availableAReg == 4)
-                            loadFromReg = false;
-                    }
-                }
-                else{
-                    assemblyOut << "# (storing an integer type to reg)" << std::endl;
-                    std::string reg = std::string("$a") + std::to_string(availableAReg);
-                    assemblyOut << "lw " << reg << ", 0($sp)" << std::endl;
-
-                    // update state
-                    availableAReg++;
-                    allowFReg = false;
-                    memOffset += 4;
+        // $f12 and $f14 must not be handed out as temporaries while the arguments are evaluated
+        for(const std::string& argReg: argRegs){
+            if(argReg != "" && argReg[1] == 'f')
+                reserveReg(argReg);
+        }
 
-                    if(availableAReg == 4)
-                        loadFromReg = false;
-                }
+        // arguments that might contain calls are evaluated first into temporary registers,
+        // which are preserved over the calls of later arguments unlike the argument registers
+        std::vector<std::string> valueRegs(argList.size(), "");
+        for(int i = 0; i < (int)argList.size(); i++){
+            if(argList[i]->hasSideEffects()){
+                valueRegs[i] = allocateReg(usesFloatReg(argList[i]));
+                argList[i]->compileToReg(assemblyOut, valueRegs[i]);
             }
-            // load from memory
-            if(useMem){
-                if(paramTypeName == "float"){
-                    assemblyOut << "# (storing a floating type from memory)" << std::endl;
-                    assemblyOut << "l.s $f4, 0($sp)" << std::endl;
-                    assemblyOut << "s.s $f4, " << memOffset << "($sp)" << std::endl;
-
-                    // update state
-                    memOffset += 4;
-                }
-                else if(paramTypeName == "double"){
-                    if(memOffset % 8){
-                        memOffset += 4;
-                    }
-                    assemblyOut << "# (storing a double type from memory)" << std::endl;
-                    
-                    assemblyOut << "l.d $f4, 0($sp)" << std::endl;
-                    assemblyOut << "s.d $f4, " << memOffset << "($sp)" << std::endl;
+        }
 
-                    // update state
-                    memOffset += 8;
-                }
-                else{
-                    assemblyOut << "# (storing a integer type from memory)" << std::endl;
-                    assemblyOut << "lw $t0, 0($sp)" << std::endl;
-                    assemblyOut << "sw $t0, " << memOffset << "($sp)" << std::endl;
+        // the others go straight into their argument register if it is of the right kind
+        bool direct = Pipeline::isEnabled("arg-regs");
+        for(int i = 0; i < (int)argList.size(); i++){
+            if(valueRegs[i] != "")
+                continue;
+            bool isFloat = usesFloatReg(argList[i]);
+            if(direct && argRegs[i] != "" && isFloat == (argRegs[i][1] == 'f')){
+                argList[i]->compileToReg(assemblyOut, argRegs[i]);
+            }
+            else{
+                valueRegs[i] = allocateReg(isFloat);
+                argList[i]->compileToReg(assemblyOut, valueRegs[i]);
+            }
+        }
 
-                    // update state
-                    memOffset += 4;
-                }
+        // move the rest to their register or stack slot
+        for(int i = 0; i < (int)argList.size(); i++){
+            if(valueRegs[i] != ""){
+                passArgument(assemblyOut, valueRegs[i], kinds[i], argRegs[i], argOffsets[i]);
+                freeReg(valueRegs[i]);
             }
         }
-        // move sp back by 4 to point to first argument 
-        // assemblyOut << "addiu $sp, $sp, 4" << std::endl;
     }
 
     assemblyOut << "jal " << functionName << std::endl;
     assemblyOut << "nop" << std::endl;
-    
+
     // remove arguments from stack
-    if(args  != nullptr){
-        if(argMemSize % 8){
-            assemblyOut << "addiu $sp, $sp, 4" << std::endl;
-        }
+    if(args != nullptr){
         assemblyOut << "addiu $sp, $sp, " << argMemSize << std::endl;
     }
+    for(const std::string& argReg: argRegs){
+        if(argReg != "" && argReg[1] == 'f')
+            freeReg(argReg);
+    }
 
-    std::string typeName = getTypeName();
-    if(typeName == "float")
-        assemblyOut << "s.s $f0, 0($sp)" << std::endl;
-    else if(typeName == "double")
-        assemblyOut << "s.d $f0, 0($sp)" << std::endl;
-    else
-        assemblyOut << "sw $v0, 0($sp)" << std::endl;
-    assemblyOut << "addiu $sp, $sp, -8" << std::endl;
+    restoreLiveRegs(assemblyOut, savedRegs, reg);
+
+    // the result of a call made for its side effects stays where it is
+    if(!resultUnused){
+        TypeKind kind = getTypeKind();
+        if(kind == TypeKind::FLOAT)
+            assemblyOut << "mov.s " << reg << ", $f0" << std::endl;
+        else if(kind == TypeKind::DOUBLE)
+            assemblyOut << "mov.d " << reg << ", $f0" << std::endl;
+        else
+            assemblyOut << "move " << reg << ", $v0" << std::endl;
+    }
 
     assemblyOut << "# end function call " << functionName << std::endl << std::endl;
 }
 
-AST* AST_FunctionCall::getType(){
-    return frame->getFunction(functionName)->getType();
+std::vector<IRInstr*> AST_FunctionCall::lowerArguments(IRBuilder &builder){
+    std::vector<AST*> argList;
+    if(args != nullptr){
+        argList.assign(args->rbegin(), args->rend());
+    }
+    std::vector<IRInstr*> values(argList.size(), nullptr);
+    for(bool sideEffects: {true, false}){
+        for(int i = 0; i < (int)argList.size(); i++){
+            if(argList[i]->hasSideEffects() == sideEffects){
+                values[i] = argList[i]->lowerToValue(builder);
+            }
+        }
+    }
+    return values;
 }
 
-int AST_FunctionCall::getBytes(){
-    return getType()->getBytes();
+IRInstr* AST_FunctionCall::lowerToValue(IRBuilder &builder){
+    std::vector<IRInstr*> values = lowerArguments(builder);
+    IRInstr* call = builder.emit(IROp::CALL, irType(getTypeKind()), values);
+    call->name = functionName;
+    return call;
 }
 
-std::string AST_FunctionCall::getTypeName(){
-    return frame->getFunction(functionName)->getTypeName();
+bool AST_FunctionCall::canTailCall(Frame* fnFrame){
+    // the callee could be given a pointer into the frame
+    if(!Pipeline::isEnabled("tail-calls") || fnFrame->hasAddressedLocals){
+        return false;
+    }
+
+    // int, unsigned, char and pointers are all returned in $v0
+    TypeKind kind = getTypeKind();
+    TypeKind fnKind = fnFrame->fn->getTypeKind();
+    bool isFloat = kind == TypeKind::FLOAT || kind == TypeKind::DOUBLE;
+    bool fnIsFloat = fnKind == TypeKind::FLOAT || fnKind == TypeKind::DOUBLE;
+    if(kind != fnKind && (isFloat || fnIsFloat)){
+        return false;
+    }
+
+    std::vector<TypeKind> kinds;
+    if(args != nullptr){
+        for(auto arg = args->rbegin(); arg != args->rend(); arg++){
+            kinds.push_back((*arg)->getType()->getTypeKind());
+        }
+    }
+    std::vector<int> argOffsets;
+    std::vector<std::string> argRegs;
+    argumentLocations(kinds, argOffsets, argRegs);
+    return std::find(argRegs.begin(), argRegs.end(), "") == argRegs.end();
 }
 
-AST_FunctionCall::~AST_FunctionCall() {
+void AST_FunctionCall::compileTailCall(std::ostream &assemblyOut, Frame* fnFrame){
+    assemblyOut << "# tail call " << functionName << std::endl;
+
+    // every argument is evaluated before any of them is passed
+    // since the parameters of this function might be needed by the later ones
+    std::vector<AST*> argList;
+    std::vector<TypeKind> kinds;
     if(args != nullptr){
-        for (AST* arg : *args) {
-            if (arg != nullptr) {
-                delete arg;
-            }
+        argList.assign(args->rbegin(), args->rend());
+    }
+    for(AST* arg: argList){
+        kinds.push_back(arg->getType()->getTypeKind());
+    }
+    std::vector<int> argOffsets;
+    std::vector<std::string> argRegs;
+    argumentLocations(kinds, argOffsets, argRegs);
+
+    // $f12 and $f14 might already hold parameters of this function which keep them reserved
+    std::vector<std::string> reservedRegs;
+    for(const std::string& argReg: argRegs){
+        if(argReg[1] == 'f' && isRegFree(argReg)){
+            reserveReg(argReg);
+            reservedRegs.push_back(argReg);
+        }
+    }
+
+    std::vector<std::string> valueRegs;
+    for(AST* arg: argList){
+        valueRegs.push_back(allocateReg(usesFloatReg(arg)));
+        arg->compileToReg(assemblyOut, valueRegs.back());
+    }
+    for(const std::string& reg: reservedRegs){
+        freeReg(reg);
+    }
+
+    AST_FunDeclaration* fn = dynamic_cast<AST_FunDeclaration*>(fnFrame->fn);
+    if(fn->getName() == functionName){
+        std::vector<std::string> paramNames = fn->getParamNames();
+        for(int i = 0; i < (int)argList.size(); i++){
+            regToVar(assemblyOut, fnFrame, valueRegs[i], paramNames[i]);
+            freeReg(valueRegs[i]);
         }
-        delete args;
+        assemblyOut << "j " << fnFrame->tailCallLabel << std::endl;
+        assemblyOut << "nop" << std::endl;
+        return;
     }
+
+    for(int i = 0; i < (int)argList.size(); i++){
+        passArgument(assemblyOut, valueRegs[i], kinds[i], argRegs[i], argOffsets[i]);
+        freeReg(valueRegs[i]);
+    }
+    compileEpilogue(assemblyOut, fnFrame, functionName);
+}
+
+void AST_FunctionCall::lowerTailCall(IRBuilder &builder){
+    std::vector<IRInstr*> values = lowerArguments(builder);
+
+    AST_FunDeclaration* fn = dynamic_cast<AST_FunDeclaration*>(builder.fnFrame->fn);
+    if(fn->getName() == functionName){
+        std::vector<std::string> paramNames = fn->getParamNames();
+        for(int i = 0; i < (int)values.size(); i++){
+            builder.writeVariable(builder.fnFrame, paramNames[i], values[i]);
+        }
+        builder.jump(builder.tailCallTarget);
+        return;
+    }
+
+    IRInstr* call = builder.emit(IROp::TAILCALL, IRType::VOID, values);
+    call->name = functionName;
+}
+
+AST* AST_FunctionCall::computeType(){
+    return frame->getFunction(functionName)->getType();
+}
+
+int AST_FunctionCall::getBytes(){
+    return getType()->getBytes();
+}
+
+std::string AST_FunctionCall::getName(){
+    return functionName;
+}
+
+std::string AST_FunctionCall::computeTypeName(){
+    return frame->getFunction(functionName)->getTypeName();
 }
 
 AST_BinOp::AST_BinOp(AST_BinOp::Type _type, AST* _left, AST* _right):
     type(_type),
+    dataType(nullptr),
     left(_left),
-    right(_right)
+    right(_right),
+    internalDataType(nullptr)
 {}
 
 void AST_BinOp::generateFrames(Frame* _frame){
@@ -320,913 +423,504 @@ AST* AST_BinOp::deepCopy(){
     return new AST_BinOp(type, new_left, new_right);
 }
 
-void AST_BinOp::compile(std::ostream &assemblyOut) {
-    this->getType(); // ensure that interalDataType is initialised
-    std::string varType = this->internalDataType->getTypeName();
-
-    std::string binLabel = generateUniqueLabel("binOp");
-    assemblyOut << std::endl << "# start " << binLabel << std::endl; 
-    
-    // compile left expression
-    left->compile(assemblyOut);
-
-    if (varType == "float") {
-        // storing result in memory is done in every case statement because results are
-        // int (boolean) or float
-        switch (type) {
-            case Type::EQUAL_EQUAL:
-            {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "l.s $f4, 16($sp)" << std::endl;
-                assemblyOut << "l.s $f5, 8($sp)" << std::endl;
-                            
-                assemblyOut << "# " << binLabel << " is float ==" << std::endl;
-                std::string trueLabel = generateUniqueLabel("trueLabel");
-                std::string endLabel = generateUniqueLabel("end");
-
-                assemblyOut << "c.eq.s $f4, $f5" << std::endl;
-                assemblyOut << "bc1t " << trueLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << "addiu $t2, $0, 0" << std::endl;
-                assemblyOut << "j " << endLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << trueLabel << ":" << std::endl;
-                assemblyOut << "addiu $t2, $0, 1" << std::endl;
-
-                assemblyOut << endLabel << ":" << std::endl;
-
-                // store result in memory
-                assemblyOut << "sw $t2, 16($sp)" << std::endl;
-                break;
-            }
-            case Type::BANG_EQUAL:
-            {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "l.s $f4, 16($sp)" << std::endl;
-                assemblyOut << "l.s $f5, 8($sp)" << std::endl;
-                            
-                assemblyOut << "# " << binLabel << " is float !=" << std::endl;
-                std::string trueLabel = generateUniqueLabel("trueLabel");
-                std::string endLabel = generateUniqueLabel("end");
+AST* AST_BinOp::fold(){
+    bool isCondition = type == Type::LOGIC_OR || type == Type::LOGIC_AND;
+    left = isCondition ? AST_UnOp::foldCondition(left) : left->fold();
+    right = isCondition ? AST_UnOp::foldCondition(right) : right->fold();
 
-                assemblyOut << "c.eq.s $f4, $f5" << std::endl;
-                assemblyOut << "bc1f " << trueLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << "addiu $t2, $0, 0" << std::endl;
-                assemblyOut << "j " << endLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << trueLabel << ":" << std::endl;
-                assemblyOut << "addiu $t2, $0, 1" << std::endl;
-
-                assemblyOut << endLabel << ":" << std::endl;
-
-                // store result in memory
-                assemblyOut << "sw $t2, 16($sp)" << std::endl;
-                break;
-            }
-            case Type::LESS:
-            {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "l.s $f4, 16($sp)" << std::endl;
-                assemblyOut << "l.s $f5, 8($sp)" << std::endl;
-
-                assemblyOut << "# " << binLabel << " is float <" << std::endl;
-                std::string trueLabel = generateUniqueLabel("trueLabel");
-                std::string endLabel = generateUniqueLabel("end");
-
-                assemblyOut << "c.lt.s $f4, $f5" << std::endl;
-                assemblyOut << "bc1t " << trueLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << "li $t2, 0" << std::endl;
-                assemblyOut << "j " << endLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << trueLabel << ":" << std::endl;
-                assemblyOut << "li $t2, 1" << std::endl;
-
-                assemblyOut << endLabel << ":" << std::endl;
-
-                // store result in memory
-                assemblyOut << "sw $t2, 16($sp)" << std::endl;
-                break;
-            }
-            case Type::LESS_EQUAL:
-            {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "l.s $f4, 16($sp)" << std::endl;
-                assemblyOut << "l.s $f5, 8($sp)" << std::endl;
-
-                assemblyOut << "# " << binLabel << " is float <=" << std::endl;
-                std::string trueLabel = generateUniqueLabel("trueLabel");
-                std::string endLabel = generateUniqueLabel("end");
-
-                assemblyOut << "c.le.s $f4, $f5" << std::endl;
-                assemblyOut << "bc1t " << trueLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << "li $t2, 0" << std::endl;
-                assemblyOut << "j " << endLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << trueLabel << ":" << std::endl;
-                assemblyOut << "li $t2, 1" << std::endl;
-
-                assemblyOut << endLabel << ":" << std::endl;
-
-                // store result in memory
-                assemblyOut << "sw $t2, 16($sp)" << std::endl;
-                break;
-            }
-            case Type::GREATER:
-            {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "l.s $f4, 16($sp)" << std::endl;
-                assemblyOut << "l.s $f5, 8($sp)" << std::endl;
-
-                assemblyOut << "# " << binLabel << " is float >" << std::endl;
-                std::string trueLabel = generateUniqueLabel("trueLabel");
-                std::string endLabel = generateUniqueLabel("end");
+    // addresses are never constant
+    if (returnPtr || type == Type::ARRAY) {
+        return this;
+    }
 
-                assemblyOut << "c.lt.s $f5, $f4" << std::endl;
-                assemblyOut << "bc1t " << trueLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
+    TypeKind leftKind = constantKind(left);
+    TypeKind rightKind = constantKind(right);
 
-                assemblyOut << "li $t2, 0" << std::endl;
-                assemblyOut << "j " << endLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << trueLabel << ":" << std::endl;
-                assemblyOut << "li $t2, 1" << std::endl;
+    // a constant left operand decides whether the right one is evaluated at all
+    if (isCondition) {
+        if (leftKind != TypeKind::INT) {
+            return this;
+        }
+        int l = left->getIntValue();
+        if (type == Type::LOGIC_AND && l == 0) {
+            return makeConstant(this, 0);
+        }
+        if (type == Type::LOGIC_OR && l != 0) {
+            return makeConstant(this, 1);
+        }
+        if (rightKind == TypeKind::INT) {
+            return makeConstant(this, right->getIntValue() != 0 ? 1 : 0);
+        }
+        return this;
+    }
 
-                assemblyOut << endLabel << ":" << std::endl;
+    AST* folded = nullptr;
+    switch (leftKind == rightKind ? leftKind : TypeKind::VOID) {
+        case TypeKind::INT:
+            folded = foldInt(left->getIntValue(), right->getIntValue());
+            break;
+        case TypeKind::FLOAT:
+            folded = foldFloating(left->getFloatValue(), right->getFloatValue(), true);
+            break;
+        case TypeKind::DOUBLE:
+            folded = foldFloating(left->getDoubleValue(), right->getDoubleValue(), false);
+            break;
+        default:
+            folded = simplify();
+            break;
+    }
+    return folded != nullptr ? folded : this;
+}
 
-                // store result in memory
-                assemblyOut << "sw $t2, 16($sp)" << std::endl;
-                break;
-            }
-            case Type::GREATER_EQUAL:
-            {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "l.s $f4, 16($sp)" << std::endl;
-                assemblyOut << "l.s $f5, 8($sp)" << std::endl;
-
-                assemblyOut << "# " << binLabel << " is float >=" << std::endl;
-                std::string trueLabel = generateUniqueLabel("trueLabel");
-                std::string endLabel = generateUniqueLabel("end");
+AST* AST_BinOp::foldInt(int l, int r) {
+    // arithmetic wraps around like it does on the target
+    uint32_t ul = l;
+    uint32_t ur = r;
+    switch (type) {
+        case Type::BIT_OR:        return makeConstant(this, (int)(ul | ur));
+        case Type::BIT_XOR:       return makeConstant(this, (int)(ul ^ ur));
+        case Type::BIT_AND:       return makeConstant(this, (int)(ul & ur));
+        case Type::EQUAL_EQUAL:   return makeConstant(this, l == r ? 1 : 0);
+        case Type::BANG_EQUAL:    return makeConstant(this, l != r ? 1 : 0);
+        case Type::LESS:          return makeConstant(this, l < r ? 1 : 0);
+        case Type::LESS_EQUAL:    return makeConstant(this, l <= r ? 1 : 0);
+        case Type::GREATER:       return makeConstant(this, l > r ? 1 : 0);
+        case Type::GREATER_EQUAL: return makeConstant(this, l >= r ? 1 : 0);
+        // sllv and srav only use the lower 5 bits of the shift amount
+        case Type::SHIFT_L:       return makeConstant(this, (int)(ul << (ur & 31)));
+        case Type::SHIFT_R:       return makeConstant(this, l >> (ur & 31));
+        case Type::PLUS:          return makeConstant(this, (int)(ul + ur));
+        case Type::MINUS:         return makeConstant(this, (int)(ul - ur));
+        case Type::STAR:          return makeConstant(this, (int)(ul * ur));
+        case Type::SLASH_F:
+        case Type::PERCENT:
+            // leave undefined behaviour to run time
+            if (r == 0 || (l == INT32_MIN && r == -1)) {
+                return nullptr;
+            }
+            return makeConstant(this, type == Type::SLASH_F ? l / r : l % r);
+        default:
+            return nullptr;
+    }
+}
 
-                assemblyOut << "c.le.s $f5, $f4" << std::endl;
-                assemblyOut << "bc1t " << trueLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
+AST* AST_BinOp::foldFloating(double l, double r, bool isFloat) {
+    // comparisons produce an int
+    switch (type) {
+        case Type::EQUAL_EQUAL:   return makeConstant(this, l == r ? 1 : 0);
+        case Type::BANG_EQUAL:    return makeConstant(this, l != r ? 1 : 0);
+        case Type::LESS:          return makeConstant(this, l < r ? 1 : 0);
+        case Type::LESS_EQUAL:    return makeConstant(this, l <= r ? 1 : 0);
+        case Type::GREATER:       return makeConstant(this, l > r ? 1 : 0);
+        case Type::GREATER_EQUAL: return makeConstant(this, l >= r ? 1 : 0);
+        default:
+            break;
+    }
 
-                assemblyOut << "li $t2, 0" << std::endl;
-                assemblyOut << "j " << endLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
+    // float arithmetic has to be done in single precision to give the same result as the target
+    if (isFloat) {
+        float fl = l;
+        float fr = r;
+        switch (type) {
+            case Type::PLUS:    return makeConstant(this, fl + fr);
+            case Type::MINUS:   return makeConstant(this, fl - fr);
+            case Type::STAR:    return makeConstant(this, fl * fr);
+            case Type::SLASH_F: return makeConstant(this, fl / fr);
+            default:            return nullptr;
+        }
+    }
+    switch (type) {
+        case Type::PLUS:    return makeConstant(this, l + r);
+        case Type::MINUS:   return makeConstant(this, l - r);
+        case Type::STAR:    return makeConstant(this, l * r);
+        case Type::SLASH_F: return makeConstant(this, l / r);
+        default:            return nullptr;
+    }
+}
 
-                assemblyOut << trueLabel << ":" << std::endl;
-                assemblyOut << "li $t2, 1" << std::endl;
+AST* AST_BinOp::simplify() {
+    TypeKind leftKind = constantKind(left);
+    TypeKind rightKind = constantKind(right);
+
+    // x*1.0 and x/1.0 are exact, x+0.0 is not (-0.0+0.0 is 0.0)
+    if (usesFloatReg(this)) {
+        bool leftOne = (leftKind == TypeKind::FLOAT && left->getFloatValue() == 1.0f)
+            || (leftKind == TypeKind::DOUBLE && left->getDoubleValue() == 1.0);
+        bool rightOne = (rightKind == TypeKind::FLOAT && right->getFloatValue() == 1.0f)
+            || (rightKind == TypeKind::DOUBLE && right->getDoubleValue() == 1.0);
+        if ((type == Type::STAR || type == Type::SLASH_F) && rightOne) {
+            return left;
+        }
+        if (type == Type::STAR && leftOne) {
+            return right;
+        }
+        return nullptr;
+    }
 
-                assemblyOut << endLabel << ":" << std::endl;
+    bool leftConst = leftKind == TypeKind::INT;
+    bool rightConst = rightKind == TypeKind::INT;
+    int l = leftConst ? left->getIntValue() : 0;
+    int r = rightConst ? right->getIntValue() : 0;
+
+    switch (type) {
+        case Type::PLUS:
+        case Type::BIT_OR:
+        case Type::BIT_XOR:
+            if (rightConst && r == 0) return left;
+            // operands are not converted, so the other operand can only be used if it has the type of the result
+            if (leftConst && l == 0 && right->getTypeName() == getTypeName()) return right;
+            break;
+        case Type::MINUS:
+        case Type::SHIFT_L:
+        case Type::SHIFT_R:
+            if (rightConst && r == 0) return left;
+            break;
+        case Type::STAR:
+            if (rightConst && r == 1) return left;
+            if (leftConst && l == 1 && right->getTypeName() == getTypeName()) return right;
+            // the other operand still has to be evaluated if it has side effects
+            if ((rightConst && r == 0 && !left->hasSideEffects()) || (leftConst && l == 0 && !right->hasSideEffects())) {
+                return makeConstant(this, 0);
+            }
+            break;
+        case Type::BIT_AND:
+            if ((rightConst && r == 0 && !left->hasSideEffects()) || (leftConst && l == 0 && !right->hasSideEffects())) {
+                return makeConstant(this, 0);
+            }
+            break;
+        case Type::SLASH_F:
+            if (rightConst && r == 1) return left;
+            break;
+        default:
+            break;
+    }
+    return nullptr;
+}
 
-                // store result in memory
-                assemblyOut << "sw $t2, 16($sp)" << std::endl;
-                break;
-            }
-            case Type::PLUS:
-            {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "l.s $f4, 16($sp)" << std::endl;
-                assemblyOut << "l.s $f5, 8($sp)" << std::endl;
+void AST_BinOp::compile(std::ostream &assemblyOut) {
+    compileAndDiscard(assemblyOut);
+}
 
-                assemblyOut << "# " << binLabel << " is float +" << std::endl;
-                assemblyOut << "add.s $f6, $f4, $f5" << std::endl;
+void AST_BinOp::compileOperands(std::ostream &assemblyOut, const std::string &reg, std::string &leftReg, std::string &rightReg) {
+    // evaluate the operand needing more registers first (Sethi-Ullman)
+    // unless that would reorder side effects
+    bool leftFirst = leftEvaluatedFirst();
+    AST* first = leftFirst ? left : right;
+    AST* second = leftFirst ? right : left;
+
+    // the destination register can hold the first operand if it is of the same kind
+    bool firstFloat = usesFloatReg(first);
+    std::string firstReg = firstFloat == (reg[1] == 'f') ? reg : allocateReg(firstFloat);
+    first->compileToReg(assemblyOut, firstReg);
+
+    // spill first operand if there are not enough registers left for the second
+    bool spill = !enoughRegs(second->getRegNeed());
+    if (spill) {
+        pushReg(assemblyOut, firstReg);
+        freeReg(firstReg);
+    }
+    std::string secondReg = allocateReg(usesFloatReg(second));
+    second->compileToReg(assemblyOut, secondReg);
+    if (spill) {
+        reclaimReg(assemblyOut, firstReg, secondReg);
+    }
 
-                // store result in memory
-                assemblyOut << "s.s $f6, 16($sp)" << std::endl;
-                break;
-            }
-            case Type::MINUS:
-            {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "l.s $f4, 16($sp)" << std::endl;
-                assemblyOut << "l.s $f5, 8($sp)" << std::endl;
+    leftReg = leftFirst ? firstReg : secondReg;
+    rightReg = leftFirst ? secondReg : firstReg;
+}
 
-                assemblyOut << "# " << binLabel << " is float -" << std::endl;
-                assemblyOut << "sub.s $f6, $f4, $f5" << std::endl;
+void AST_BinOp::compileToReg(std::ostream &assemblyOut, const std::string &reg) {
+    this->getType(); // ensure that interalDataType is initialised
+    TypeKind varType = this->internalDataType->getTypeKind();
 
-                // store result in memory
-                assemblyOut << "s.s $f6, 16($sp)" << std::endl;
-                break;
-            }
-            case Type::STAR:
-            {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "l.s $f4, 16($sp)" << std::endl;
-                assemblyOut << "l.s $f5, 8($sp)" << std::endl;
+    std::string binLabel = generateUniqueLabel("binOp");
+    assemblyOut << std::endl << "# start " << binLabel << std::endl;
 
-                assemblyOut << "# " << binLabel << " is float *" << std::endl;
-                assemblyOut << "mul.s $f6, $f4, $f5" << std::endl;
+    // short-circuit evaluation => right operand is only evaluated if needed
+    // reg is only cleared if the condition turns out to be false
+    if (type == Type::LOGIC_OR || type == Type::LOGIC_AND) {
+        std::string endLabel = generateUniqueLabel("end");
+        assemblyOut << "# " << binLabel << " is " << (type == Type::LOGIC_OR ? "||" : "&&") << std::endl;
 
-                // store result in memory
-                assemblyOut << "s.s $f6, 16($sp)" << std::endl;
-                break;
-            }
-            case Type::SLASH_F:
-            {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "l.s $f4, 16($sp)" << std::endl;
-                assemblyOut << "l.s $f5, 8($sp)" << std::endl;
+        assemblyOut << "li " << reg << ", 1" << std::endl;
+        compileBranch(assemblyOut, endLabel, true);
+        assemblyOut << "move " << reg << ", $0" << std::endl;
+        assemblyOut << endLabel << ":" << std::endl;
 
-                assemblyOut << "# " << binLabel << " is float /" << std::endl;
-                assemblyOut << "div.s $f6, $f4, $f5" << std::endl;
+        assemblyOut << "# end " << binLabel << std::endl << std::endl;
+        return;
+    }
 
-                // store result in memory
-                assemblyOut << "s.s $f6, 16($sp)" << std::endl;
-                break;
-            }
-            default:
-            {
-                throw std::runtime_error("AST_BinOp: Float Not Implemented Yet.\n");
-                break;
-            }
+    // integer multiplication and division by a constant (see multiplyByConstant)
+    bool isInt = varType == TypeKind::INT || varType == TypeKind::UNSIGNED || varType == TypeKind::CHAR;
+    bool isMulDiv = type == Type::STAR || type == Type::SLASH_F || type == Type::PERCENT;
+    AST* constant = nullptr;
+    if (isInt && isMulDiv && constantKind(right) == TypeKind::INT) {
+        constant = right;
+    } else if (isInt && type == Type::STAR && constantKind(left) == TypeKind::INT) {
+        constant = left;
+    }
+    bool reduce = constant != nullptr && Pipeline::isEnabled("strength-reduce");
+    if (reduce && (type == Type::STAR || canDivideByConstant(constant->getIntValue(), varType == TypeKind::UNSIGNED))) {
+        AST* operand = constant == right ? left : right;
+        operand->compileToReg(assemblyOut, reg);
+        if (type == Type::STAR) {
+            assemblyOut << "# " << binLabel << " is * " << constant->getIntValue() << std::endl;
+            multiplyByConstant(assemblyOut, reg, reg, constant->getIntValue());
+        } else {
+            assemblyOut << "# " << binLabel << " is " << (type == Type::PERCENT ? "% " : "/ ") << constant->getIntValue() << std::endl;
+            divideByConstant(assemblyOut, reg, reg, constant->getIntValue(), varType == TypeKind::UNSIGNED, type == Type::PERCENT);
         }
+        assemblyOut << "# end " << binLabel << std::endl << std::endl;
+        return;
     }
-    else if (varType == "double") {
-        // storing result in memory is done in every case statement because results are
-        // int (boolean) or double
-        switch (type) {
-            case Type::EQUAL_EQUAL:
-            {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "l.d $f4, 16($sp)" << std::endl;
-                assemblyOut << "l.d $f6, 8($sp)" << std::endl;
-                            
-                assemblyOut << "# " << binLabel << " is double ==" << std::endl;
-                std::string trueLabel = generateUniqueLabel("trueLabel");
-                std::string endLabel = generateUniqueLabel("end");
 
-                assemblyOut << "c.eq.d $f4, $f6" << std::endl;
-                assemblyOut << "bc1t " << trueLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << "addiu $t2, $0, 0" << std::endl;
-                assemblyOut << "j " << endLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
+    std::string leftReg, rightReg;
+    compileOperands(assemblyOut, reg, leftReg, rightReg);
 
-                assemblyOut << trueLabel << ":" << std::endl;
-                assemblyOut << "addiu $t2, $0, 1" << std::endl;
-
-                assemblyOut << endLabel << ":" << std::endl;
-
-                // store result in memory
-                assemblyOut << "sw $t2, 16($sp)" << std::endl;
-                break;
-            }
+    if (varType == TypeKind::FLOAT || varType == TypeKind::DOUBLE) {
+        std::string fmt = varType == TypeKind::FLOAT ? ".s " : ".d ";
+        switch (type) {
+            case Type::EQUAL_EQUAL:
             case Type::BANG_EQUAL:
-            {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "l.d $f4, 16($sp)" << std::endl;
-                assemblyOut << "l.d $f6, 8($sp)" << std::endl;
-                            
-                assemblyOut << "# " << binLabel << " is double !=" << std::endl;
-                std::string trueLabel = generateUniqueLabel("trueLabel");
-                std::string endLabel = generateUniqueLabel("end");
-
-                assemblyOut << "c.eq.d $f4, $f6" << std::endl;
-                assemblyOut << "bc1f " << trueLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << "addiu $t2, $0, 0" << std::endl;
-                assemblyOut << "j " << endLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << trueLabel << ":" << std::endl;
-                assemblyOut << "addiu $t2, $0, 1" << std::endl;
-
-                assemblyOut << endLabel << ":" << std::endl;
-
-                // store result in memory
-                assemblyOut << "sw $t2, 16($sp)" << std::endl;
-                break;
-            }
             case Type::LESS:
-            {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "l.d $f4, 16($sp)" << std::endl;
-                assemblyOut << "l.d $f6, 8($sp)" << std::endl;
-
-                assemblyOut << "# " << binLabel << " is double <" << std::endl;
-                std::string trueLabel = generateUniqueLabel("trueLabel");
-                std::string endLabel = generateUniqueLabel("end");
-
-                assemblyOut << "c.lt.d $f4, $f6" << std::endl;
-                assemblyOut << "bc1t " << trueLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << "li $t2, 0" << std::endl;
-                assemblyOut << "j " << endLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << trueLabel << ":" << std::endl;
-                assemblyOut << "li $t2, 1" << std::endl;
-
-                assemblyOut << endLabel << ":" << std::endl;
-
-                // store result in memory
-                assemblyOut << "sw $t2, 16($sp)" << std::endl;
-                break;
-            }
             case Type::LESS_EQUAL:
-            {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "l.d $f4, 16($sp)" << std::endl;
-                assemblyOut << "l.d $f6, 8($sp)" << std::endl;
-
-                assemblyOut << "# " << binLabel << " is double <=" << std::endl;
-                std::string trueLabel = generateUniqueLabel("trueLabel");
-                std::string endLabel = generateUniqueLabel("end");
-
-                assemblyOut << "c.le.d $f4, $f6" << std::endl;
-                assemblyOut << "bc1t " << trueLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << "li $t2, 0" << std::endl;
-                assemblyOut << "j " << endLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << trueLabel << ":" << std::endl;
-                assemblyOut << "li $t2, 1" << std::endl;
-
-                assemblyOut << endLabel << ":" << std::endl;
-
-                // store result in memory
-                assemblyOut << "sw $t2, 16($sp)" << std::endl;
-                break;
-            }
             case Type::GREATER:
-            {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "l.d $f4, 16($sp)" << std::endl;
-                assemblyOut << "l.d $f6, 8($sp)" << std::endl;
-
-                assemblyOut << "# " << binLabel << " is double >" << std::endl;
-                std::string trueLabel = generateUniqueLabel("trueLabel");
-                std::string endLabel = generateUniqueLabel("end");
-
-                assemblyOut << "c.lt.d $f6, $f4" << std::endl;
-                assemblyOut << "bc1t " << trueLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << "li $t2, 0" << std::endl;
-                assemblyOut << "j " << endLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << trueLabel << ":" << std::endl;
-                assemblyOut << "li $t2, 1" << std::endl;
-
-                assemblyOut << endLabel << ":" << std::endl;
-
-                // store result in memory
-                assemblyOut << "sw $t2, 16($sp)" << std::endl;
-                break;
-            }
             case Type::GREATER_EQUAL:
             {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "l.d $f4, 16($sp)" << std::endl;
-                assemblyOut << "l.d $f6, 8($sp)" << std::endl;
-
-                assemblyOut << "# " << binLabel << " is double >=" << std::endl;
-                std::string trueLabel = generateUniqueLabel("trueLabel");
+                assemblyOut << "# " << binLabel << " is " << this->internalDataType->getTypeName() << " comparison" << std::endl;
                 std::string endLabel = generateUniqueLabel("end");
 
-                assemblyOut << "c.le.d $f6, $f4" << std::endl;
-                assemblyOut << "bc1t " << trueLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
+                // greater comparisons are less comparisons with the operands swapped
+                // not equal branches on the condition flag being false
+                std::string branch = type == Type::BANG_EQUAL ? "bc1f " : "bc1t ";
+                if (type == Type::EQUAL_EQUAL || type == Type::BANG_EQUAL) {
+                    assemblyOut << "c.eq" << fmt << leftReg << ", " << rightReg << std::endl;
+                } else if (type == Type::LESS) {
+                    assemblyOut << "c.lt" << fmt << leftReg << ", " << rightReg << std::endl;
+                } else if (type == Type::LESS_EQUAL) {
+                    assemblyOut << "c.le" << fmt << leftReg << ", " << rightReg << std::endl;
+                } else if (type == Type::GREATER) {
+                    assemblyOut << "c.lt" << fmt << rightReg << ", " << leftReg << std::endl;
+                } else {
+                    assemblyOut << "c.le" << fmt << rightReg << ", " << leftReg << std::endl;
+                }
 
-                assemblyOut << "li $t2, 0" << std::endl;
-                assemblyOut << "j " << endLabel << std::endl;
+                assemblyOut << "li " << reg << ", 1" << std::endl;
+                assemblyOut << branch << endLabel << std::endl;
                 assemblyOut << "nop" << std::endl;
-
-                assemblyOut << trueLabel << ":" << std::endl;
-                assemblyOut << "li $t2, 1" << std::endl;
-
+                assemblyOut << "move " << reg << ", $0" << std::endl;
                 assemblyOut << endLabel << ":" << std::endl;
-
-                // store result in memory
-                assemblyOut << "sw $t2, 16($sp)" << std::endl;
                 break;
             }
             case Type::PLUS:
             {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "l.d $f4, 16($sp)" << std::endl;
-                assemblyOut << "l.d $f6, 8($sp)" << std::endl;
-
-                assemblyOut << "# " << binLabel << " is double +" << std::endl;
-                assemblyOut << "add.d $f8, $f4, $f6" << std::endl;
-
-                // store result in memory
-                assemblyOut << "s.d $f8, 16($sp)" << std::endl;
+                assemblyOut << "# " << binLabel << " is " << this->internalDataType->getTypeName() << " +" << std::endl;
+                assemblyOut << "add" << fmt << reg << ", " << leftReg << ", " << rightReg << std::endl;
                 break;
             }
             case Type::MINUS:
             {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "l.d $f4, 16($sp)" << std::endl;
-                assemblyOut << "l.d $f6, 8($sp)" << std::endl;
-
-                assemblyOut << "# " << binLabel << " is double -" << std::endl;
-                assemblyOut << "sub.d $f8, $f4, $f6" << std::endl;
-
-                // store result in memory
-                assemblyOut << "s.d $f8, 16($sp)" << std::endl;
+                assemblyOut << "# " << binLabel << " is " << this->internalDataType->getTypeName() << " -" << std::endl;
+                assemblyOut << "sub" << fmt << reg << ", " << leftReg << ", " << rightReg << std::endl;
                 break;
             }
             case Type::STAR:
             {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "l.d $f4, 16($sp)" << std::endl;
-                assemblyOut << "l.d $f6, 8($sp)" << std::endl;
-
-                assemblyOut << "# " << binLabel << " is double *" << std::endl;
-                assemblyOut << "mul.d $f8, $f4, $f6" << std::endl;
-
-                // store result in memory
-                assemblyOut << "s.d $f8, 16($sp)" << std::endl;
+                assemblyOut << "# " << binLabel << " is " << this->internalDataType->getTypeName() << " *" << std::endl;
+                assemblyOut << "mul" << fmt << reg << ", " << leftReg << ", " << rightReg << std::endl;
                 break;
             }
             case Type::SLASH_F:
             {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "l.d $f4, 16($sp)" << std::endl;
-                assemblyOut << "l.d $f6, 8($sp)" << std::endl;
-
-                assemblyOut << "# " << binLabel << " is double /" << std::endl;
-                assemblyOut << "div.d $f8, $f4, $f6" << std::endl;
-
-                // store result in memory
-                assemblyOut << "s.d $f8, 16($sp)" << std::endl;
+                assemblyOut << "# " << binLabel << " is " << this->internalDataType->getTypeName() << " /" << std::endl;
+                assemblyOut << "div" << fmt << reg << ", " << leftReg << ", " << rightReg << std::endl;
                 break;
             }
             default:
             {
+                if (varType == TypeKind::FLOAT) {
+                    throw std::runtime_error("AST_BinOp: Float Not Implemented Yet.\n");
+                }
                 throw std::runtime_error("AST_BinOp: Double Not Implemented Yet.\n");
                 break;
             }
         }
     }
-    else if(varType == "pointer"){
-        bool useT2 = true;
+    else if(varType == TypeKind::POINTER && (type == Type::PLUS || type == Type::MINUS || type == Type::ARRAY)){
+        // indices are scaled by the size of the pointed to type
+        int bytes = internalDataType->getType()->getBytes();
         switch (type) {
             case Type::PLUS:
             {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-
-                assemblyOut << "lw $t0, 16($sp)" << std::endl;
-                assemblyOut << "lw $t1, 8($sp)" << std::endl;
-
                 assemblyOut << "# " << binLabel << " is pointer arithmetic +" << std::endl;
-                assemblyOut << "addiu $t2, $0, " << internalDataType->getType()->getBytes() << std::endl;
-                assemblyOut << "multu $t1, $t2" << std::endl;
-                assemblyOut << "mflo $t1" << std::endl;
-                assemblyOut << "add $t2, $t0, $t1" << std::endl;
+                multiplyByConstant(assemblyOut, rightReg, rightReg, bytes);
+                assemblyOut << "addu " << reg << ", " << leftReg << ", " << rightReg << std::endl;
                 break;
             }
             case Type::MINUS:
             {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                assemblyOut << "lw $t0, 16($sp)" << std::endl;
-                assemblyOut << "lw $t1, 8($sp)" << std::endl;
-                if(right->getTypeName() == "pointer"){
+                if(right->getTypeKind() == TypeKind::POINTER){
                     assemblyOut << "# " << binLabel << " is pointer difference -" << std::endl;
-                    assemblyOut << "sub $t2, $t0, $t1" << std::endl;
-                    assemblyOut << "addiu $t1, $0, " << internalDataType->getType()->getBytes() << std::endl;
-                    assemblyOut << "div $t2, $t1" << std::endl;
-                    assemblyOut << "mflo $t2" << std::endl;
+                    assemblyOut << "subu " << reg << ", " << leftReg << ", " << rightReg << std::endl;
+                    divideByConstant(assemblyOut, reg, reg, bytes, false, false);
                 }
                 else{
                     assemblyOut << "# " << binLabel << " is pointer arithmetic -" << std::endl;
-                    assemblyOut << "addiu $t2, $0, " << internalDataType->getType()->getBytes() << std::endl;
-                    assemblyOut << "mult $t1, $t2" << std::endl;
-                    assemblyOut << "mflo $t1" << std::endl;
-                    assemblyOut << "sub $t2, $t0, $t1" << std::endl;
+                    multiplyByConstant(assemblyOut, rightReg, rightReg, bytes);
+                    assemblyOut << "subu " << reg << ", " << leftReg << ", " << rightReg << std::endl;
                 }
                 break;
             }
-            case Type::ARRAY:
+            default:
             {
-                // load result of index expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "lw $t0, 16($sp)" << std::endl;
-                assemblyOut << "lw $t1, 8($sp)" << std::endl;
-
                 assemblyOut << "# " << binLabel << " [] " << std::endl;
-                assemblyOut << "addiu $t2, $0, " << internalDataType->getType()->getBytes() << std::endl;
-                assemblyOut << "multu $t1, $t2" << std::endl;
-                assemblyOut << "mflo $t1" << std::endl;
-                assemblyOut << "add $t2, $t0, $t1" << std::endl;
+                // address of element, reg might be a float register so use the left operand
+                multiplyByConstant(assemblyOut, rightReg, rightReg, bytes);
+                assemblyOut << "addu " << leftReg << ", " << leftReg << ", " << rightReg << std::endl;
+
                 // if not left of assign load value
-                if(!returnPtr){
-                    std::string returnType = internalDataType->getType()->getTypeName();
-                    if(returnType == "double"){
-                        assemblyOut << "l.d $f4, 0($t2)" << std::endl;
-                        assemblyOut << "s.d $f4, 16($sp)" << std::endl;
-                        useT2 = false;
+                if(returnPtr){
+                    if(leftReg != reg)
+                        assemblyOut << "move " << reg << ", " << leftReg << std::endl;
+                }
+                else{
+                    TypeKind returnType = internalDataType->getType()->getTypeKind();
+                    if(returnType == TypeKind::DOUBLE){
+                        assemblyOut << "l.d " << reg << ", 0(" << leftReg << ")" << std::endl;
+                    }
+                    else if(returnType == TypeKind::FLOAT){
+                        assemblyOut << "l.s " << reg << ", 0(" << leftReg << ")" << std::endl;
                     }
                     else{
-                        std::string load = returnType =="char"?"lb":"lw";
-                        assemblyOut << load << " $t2, 0($t2)" << std::endl;
+                        std::string load = returnType == TypeKind::CHAR ? "lb " : "lw ";
+                        assemblyOut << load << reg << ", 0(" << leftReg << ")" << std::endl;
                     }
                 }
-                
-                break;
-            }
-            default:
-            {
-                throw std::runtime_error("AST_BinOp: Pointer Not Implemented Yet.\n");
                 break;
             }
         }
-        // store result in memory
-        if(useT2)
-            assemblyOut << "sw $t2, 16($sp)" << std::endl;
-    }
-    else {
-        switch (type) {
-            case Type::LOGIC_OR:
-            {
-                assemblyOut << "# " << binLabel << " is &&" << std::endl;
-                std::string trueLabel = generateUniqueLabel("trueLabel");
-                std::string falseLabel = generateUniqueLabel("falseLabel");
-                std::string endLabel = generateUniqueLabel("end");
-
-                // evaluate first expression first => short-circuit evaluation
-                assemblyOut << "lw $t0, 8($sp)" << std::endl;
-                assemblyOut << "bne $t0, $0, " << trueLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-                
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                assemblyOut << "lw $t1, 8($sp)" << std::endl;
-
-                assemblyOut << "bne $t1, $0, " << trueLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << falseLabel << ":" << std::endl;
-                assemblyOut << "addiu $t2, $0, 0" << std::endl;
-                assemblyOut << "j " << endLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << trueLabel << ":" << std::endl;
-                assemblyOut << "addiu $t2, $0, 1" << std::endl;
-
-                assemblyOut << endLabel << ":" << std::endl;
-                break;
-            }
-            case Type::LOGIC_AND:
-            {
-                assemblyOut << "# " << binLabel << " is &&" << std::endl;
-                std::string trueLabel = generateUniqueLabel("trueLabel");
-                std::string falseLabel = generateUniqueLabel("falseLabel");
-                std::string endLabel = generateUniqueLabel("end");
-
-                // evaluate first expression first => short-circuit evaluation
-                assemblyOut << "lw $t0, 8($sp)" << std::endl;
-                assemblyOut << "beq $t0, $0, " << falseLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-                
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                assemblyOut << "lw $t1, 8($sp)" << std::endl;
-                
-                assemblyOut << "beq $t1, $0, " << falseLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << trueLabel << ":" << std::endl;
-                assemblyOut << "addiu $t2, $0, 1" << std::endl;
-                assemblyOut << "j " << endLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-                
-                assemblyOut << falseLabel << ":" << std::endl;
-                assemblyOut << "addiu $t2, $0, 0" << std::endl;
-            
-                assemblyOut << endLabel << ":" << std::endl;
-                break;
-            }
+    }
+    else {
+        // same as compileBranch, unsigned values and pointers compare with sltu
+        bool isUnsigned = varType == TypeKind::UNSIGNED || varType == TypeKind::POINTER;
+        std::string slt = isUnsigned ? "sltu " : "slt ";
+        switch (type) {
             case Type::BIT_OR:
             {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "lw $t0, 16($sp)" << std::endl;
-                assemblyOut << "lw $t1, 8($sp)" << std::endl;
-
                 assemblyOut << "# " << binLabel << " is |" << std::endl;
-                assemblyOut << "or $t2, $t0, $t1" << std::endl;
+                assemblyOut << "or " << reg << ", " << leftReg << ", " << rightReg << std::endl;
                 break;
             }
             case Type::BIT_XOR:
             {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "lw $t0, 16($sp)" << std::endl;
-                assemblyOut << "lw $t1, 8($sp)" << std::endl;
-                
                 assemblyOut << "# " << binLabel << " is ^" << std::endl;
-                assemblyOut << "xor $t2, $t0, $t1" << std::endl;
+                assemblyOut << "xor " << reg << ", " << leftReg << ", " << rightReg << std::endl;
                 break;
             }
             case Type::BIT_AND:
             {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "lw $t0, 16($sp)" << std::endl;
-                assemblyOut << "lw $t1, 8($sp)" << std::endl;
-                
-                
                 assemblyOut << "# " << binLabel << " is &" << std::endl;
-                assemblyOut << "and $t2, $t0, $t1" << std::endl;
+                assemblyOut << "and " << reg << ", " << leftReg << ", " << rightReg << std::endl;
                 break;
             }
             case Type::EQUAL_EQUAL:
             {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "lw $t0, 16($sp)" << std::endl;
-                assemblyOut << "lw $t1, 8($sp)" << std::endl;
-                            
                 assemblyOut << "# " << binLabel << " is ==" << std::endl;
-                std::string trueLabel = generateUniqueLabel("trueLabel");
-                std::string endLabel = generateUniqueLabel("end");
-
-                assemblyOut << "beq $t0, $t1, " << trueLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << "addiu $t2, $0, 0" << std::endl;
-                assemblyOut << "j " << endLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << trueLabel << ":" << std::endl;
-                assemblyOut << "addiu $t2, $0, 1" << std::endl;
-
-                assemblyOut << endLabel << ":" << std::endl;
+                assemblyOut << "xor " << reg << ", " << leftReg << ", " << rightReg << std::endl;
+                assemblyOut << "sltiu " << reg << ", " << reg << ", 1" << std::endl;
                 break;
             }
             case Type::BANG_EQUAL:
             {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "lw $t0, 16($sp)" << std::endl;
-                assemblyOut << "lw $t1, 8($sp)" << std::endl;
-                            
                 assemblyOut << "# " << binLabel << " is !=" << std::endl;
-                std::string trueLabel = generateUniqueLabel("trueLabel");
-                std::string endLabel = generateUniqueLabel("end");
-
-                assemblyOut << "bne $t0, $t1, " << trueLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << "addiu $t2, $0, 0" << std::endl;
-                assemblyOut << "j " << endLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << trueLabel << ":" << std::endl;
-                assemblyOut << "addiu $t2, $0, 1" << std::endl;
-
-                assemblyOut << endLabel << ":" << std::endl;
+                assemblyOut << "xor " << reg << ", " << leftReg << ", " << rightReg << std::endl;
+                assemblyOut << "sltu " << reg << ", $0, " << reg << std::endl;
                 break;
             }
             case Type::LESS:
             {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "lw $t0, 16($sp)" << std::endl;
-                assemblyOut << "lw $t1, 8($sp)" << std::endl;
-
                 assemblyOut << "# " << binLabel << " is <" << std::endl;
-                assemblyOut << "slt $t2, $t0, $t1" << std::endl;
+                assemblyOut << slt << reg << ", " << leftReg << ", " << rightReg << std::endl;
                 break;
             }
             case Type::LESS_EQUAL:
             {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "lw $t0, 16($sp)" << std::endl;
-                assemblyOut << "lw $t1, 8($sp)" << std::endl;
-
-                assemblyOut << "# " << binLabel << " is <=" << std::endl;
                 // less_equal if not greater
-                std::string trueLabel = generateUniqueLabel("trueLabel");
-                std::string endLabel = generateUniqueLabel("end");
-                
-                assemblyOut << "slt $t2, $t1, $t0" << std::endl;
-                assemblyOut << "beq $t2, $0, " << trueLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << "addiu $t2, $0, 0" << std::endl;
-                assemblyOut << "j " << endLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << trueLabel << ":" << std::endl;
-                assemblyOut << "addiu $t2, $0, 1" << std::endl;
-
-                assemblyOut << endLabel << ":" << std::endl;
+                assemblyOut << "# " << binLabel << " is <=" << std::endl;
+                assemblyOut << slt << reg << ", " << rightReg << ", " << leftReg << std::endl;
+                assemblyOut << "xori " << reg << ", " << reg << ", 1" << std::endl;
                 break;
             }
             case Type::GREATER:
             {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "lw $t0, 16($sp)" << std::endl;
-                assemblyOut << "lw $t1, 8($sp)" << std::endl;
-
                 assemblyOut << "# " << binLabel << " is >" << std::endl;
-                assemblyOut << "slt $t2, $t1, $t0" << std::endl;
+                assemblyOut << slt << reg << ", " << rightReg << ", " << leftReg << std::endl;
                 break;
             }
             case Type::GREATER_EQUAL:
             {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "lw $t0, 16($sp)" << std::endl;
-                assemblyOut << "lw $t1, 8($sp)" << std::endl;
-
-                assemblyOut << "# " << binLabel << " is >=" << std::endl;
                 // greater_equal if not less
-                std::string trueLabel = generateUniqueLabel("trueLabel");
-                std::string endLabel = generateUniqueLabel("end");
-                
-                assemblyOut << "slt $t2, $t0, $t1" << std::endl;
-                assemblyOut << "beq $t2, $0, " << trueLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << "addiu $t2, $0, 0" << std::endl;
-                assemblyOut << "j " << endLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                assemblyOut << trueLabel << ":" << std::endl;
-                assemblyOut << "addiu $t2, $0, 1" << std::endl;
-
-                assemblyOut << endLabel << ":" << std::endl;
+                assemblyOut << "# " << binLabel << " is >=" << std::endl;
+                assemblyOut << slt << reg << ", " << leftReg << ", " << rightReg << std::endl;
+                assemblyOut << "xori " << reg << ", " << reg << ", 1" << std::endl;
                 break;
             }
             case Type::SHIFT_L:
             {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "lw $t0, 16($sp)" << std::endl;
-                assemblyOut << "lw $t1, 8($sp)" << std::endl;
-
                 assemblyOut << "# " << binLabel << " is <<" << std::endl;
-                assemblyOut << "sll $t2, $t0, $t1" << std::endl;
+                assemblyOut << "sllv " << reg << ", " << leftReg << ", " << rightReg << std::endl;
                 break;
             }
             case Type::SHIFT_R:
             {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "lw $t0, 16($sp)" << std::endl;
-                assemblyOut << "lw $t1, 8($sp)" << std::endl;
-
+                // arithmetic shift unless unsigned
+                std::string shift = varType == TypeKind::UNSIGNED ? "srlv " : "srav ";
                 assemblyOut << "# " << binLabel << " is >>" << std::endl;
-                assemblyOut << "srl $t2, $t0, $t1" << std::endl;
+                assemblyOut << shift << reg << ", " << leftReg << ", " << rightReg << std::endl;
                 break;
             }
             case Type::PLUS:
             {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "lw $t0, 16($sp)" << std::endl;
-                assemblyOut << "lw $t1, 8($sp)" << std::endl;
-
-                if(right->getTypeName() == "pointer"){
+                if(right->getTypeKind() == TypeKind::POINTER){
                     assemblyOut << "# " << binLabel << " is pointer arithmetic +" << std::endl;
-                    assemblyOut << "addiu $t2, $0, " << internalDataType->getType()->getBytes() << std::endl;
-                    assemblyOut << "multu $t0, $t2" << std::endl;
-                    assemblyOut << "mflo $t0" << std::endl;
-                    assemblyOut << "add $t2, $t1, $t0" << std::endl;
-                    break;
+                    multiplyByConstant(assemblyOut, leftReg, leftReg, internalDataType->getType()->getBytes());
                 }
                 else{
                     assemblyOut << "# " << binLabel << " is +" << std::endl;
-                    assemblyOut << "add $t2, $t0, $t1" << std::endl;
                 }
+                assemblyOut << "addu " << reg << ", " << leftReg << ", " << rightReg << std::endl;
                 break;
             }
             case Type::MINUS:
             {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "lw $t0, 16($sp)" << std::endl;
-                assemblyOut << "lw $t1, 8($sp)" << std::endl;
-
                 assemblyOut << "# " << binLabel << " is -" << std::endl;
-                assemblyOut << "sub $t2, $t0, $t1" << std::endl;
+                assemblyOut << "subu " << reg << ", " << leftReg << ", " << rightReg << std::endl;
                 break;
             }
             case Type::STAR:
             {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "lw $t0, 16($sp)" << std::endl;
-                assemblyOut << "lw $t1, 8($sp)" << std::endl;
-
-                assemblyOut << "# " << binLabel << " is *" << std::endl;
-                assemblyOut << "mult $t0, $t1" << std::endl;
-
                 // only care about 32 least significant bits
-                assemblyOut << "mflo $t2" << std::endl;
+                assemblyOut << "# " << binLabel << " is *" << std::endl;
+                assemblyOut << "mul " << reg << ", " << leftReg << ", " << rightReg << std::endl;
                 break;
             }
             case Type::SLASH_F:
             {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "lw $t0, 16($sp)" << std::endl;
-                assemblyOut << "lw $t1, 8($sp)" << std::endl;
-
                 assemblyOut << "# " << binLabel << " is /" << std::endl;
-                assemblyOut << "div $t0, $t1" << std::endl;
+                assemblyOut << (varType == TypeKind::UNSIGNED ? "divu " : "div ") << leftReg << ", " << rightReg << std::endl;
 
                 // only care about quotient for fixed point division (get remainder using 'mfhi')
-                assemblyOut << "mflo $t2" << std::endl;
+                assemblyOut << "mflo " << reg << std::endl;
                 break;
             }
             case Type::PERCENT:
             {
-                // load result of right expression into register
-                right->compile(assemblyOut);
-                
-                assemblyOut << "lw $t0, 16($sp)" << std::endl;
-                assemblyOut << "lw $t1, 8($sp)" << std::endl;
-
                 assemblyOut << "# " << binLabel << " is %" << std::endl;
-                assemblyOut << "div $t0, $t1" << std::endl;
+                assemblyOut << (varType == TypeKind::UNSIGNED ? "divu " : "div ") << leftReg << ", " << rightReg << std::endl;
 
                 // only care about remainder
-                assemblyOut << "mfhi $t2" << std::endl;
+                assemblyOut << "mfhi " << reg << std::endl;
                 break;
             }
             default:
@@ -1235,21 +929,306 @@ void AST_BinOp::compile(std::ostream &assemblyOut) {
                 break;
             }
         }
+    }
+
+    if (leftReg != reg) {
+        freeReg(leftReg);
+    }
+    if (rightReg != reg) {
+        freeReg(rightReg);
+    }
+
+    assemblyOut << "# end " << binLabel << std::endl << std::endl;
+}
+
+void AST_BinOp::compileBranch(std::ostream &assemblyOut, const std::string &label, bool jumpIf) {
+    if (type == Type::LOGIC_OR || type == Type::LOGIC_AND) {
+        // a || b jumps as soon as one of them is true, a && b as soon as one of them is false
+        // otherwise the left operand skips over the right one when it decides the result
+        bool shortCircuit = type == Type::LOGIC_OR;
+        if (jumpIf == shortCircuit) {
+            left->compileBranch(assemblyOut, label, jumpIf);
+            right->compileBranch(assemblyOut, label, jumpIf);
+        } else {
+            std::string skipLabel = generateUniqueLabel("skip");
+            left->compileBranch(assemblyOut, skipLabel, shortCircuit);
+            right->compileBranch(assemblyOut, label, jumpIf);
+            assemblyOut << skipLabel << ":" << std::endl;
+        }
+        return;
+    }
+
+    if (type != Type::EQUAL_EQUAL && type != Type::BANG_EQUAL && type != Type::LESS && type != Type::LESS_EQUAL
+        && type != Type::GREATER && type != Type::GREATER_EQUAL) {
+        AST::compileBranch(assemblyOut, label, jumpIf);
+        return;
+    }
+
+    this->getType(); // ensure that interalDataType is initialised
+    TypeKind varType = this->internalDataType->getTypeKind();
+
+    if (varType == TypeKind::FLOAT || varType == TypeKind::DOUBLE) {
+        std::string fmt = varType == TypeKind::FLOAT ? ".s " : ".d ";
+        std::string reg = allocateReg(true);
+        std::string leftReg, rightReg;
+        compileOperands(assemblyOut, reg, leftReg, rightReg);
+
+        // same comparisons as compileToReg, the flag is tested directly
+        if (type == Type::EQUAL_EQUAL || type == Type::BANG_EQUAL) {
+            assemblyOut << "c.eq" << fmt << leftReg << ", " << rightReg << std::endl;
+        } else if (type == Type::LESS) {
+            assemblyOut << "c.lt" << fmt << leftReg << ", " << rightReg << std::endl;
+        } else if (type == Type::LESS_EQUAL) {
+            assemblyOut << "c.le" << fmt << leftReg << ", " << rightReg << std::endl;
+        } else if (type == Type::GREATER) {
+            assemblyOut << "c.lt" << fmt << rightReg << ", " << leftReg << std::endl;
+        } else {
+            assemblyOut << "c.le" << fmt << rightReg << ", " << leftReg << std::endl;
+        }
+        freeReg(leftReg);
+        freeReg(rightReg);
+        if (leftReg != reg && rightReg != reg) {
+            freeReg(reg);
+        }
+
+        bool onFlag = jumpIf != (type == Type::BANG_EQUAL);
+        assemblyOut << (onFlag ? "bc1t " : "bc1f ") << label << std::endl;
+        assemblyOut << "nop" << std::endl;
+        return;
+    }
+
+    // branch on the negated comparison when jumping if false
+    Type cmp = type;
+    if (!jumpIf) {
+        switch (type) {
+            case Type::EQUAL_EQUAL:   cmp = Type::BANG_EQUAL; break;
+            case Type::BANG_EQUAL:    cmp = Type::EQUAL_EQUAL; break;
+            case Type::LESS:          cmp = Type::GREATER_EQUAL; break;
+            case Type::LESS_EQUAL:    cmp = Type::GREATER; break;
+            case Type::GREATER:       cmp = Type::LESS_EQUAL; break;
+            default:                  cmp = Type::LESS; break;
+        }
+    }
+
+    bool isUnsigned = varType == TypeKind::UNSIGNED || varType == TypeKind::POINTER;
+    bool rightConst = constantKind(right) == TypeKind::INT;
+    int r = rightConst ? right->getIntValue() : 0;
+    std::string reg = allocateReg(false);
+
+    // comparisons with 0 have their own branches
+    if (rightConst && r == 0 && (!isUnsigned || cmp == Type::EQUAL_EQUAL || cmp == Type::BANG_EQUAL)) {
+        left->compileToReg(assemblyOut, reg);
+        freeReg(reg);
+        switch (cmp) {
+            case Type::EQUAL_EQUAL:   assemblyOut << "beq " << reg << ", $0, "; break;
+            case Type::BANG_EQUAL:    assemblyOut << "bne " << reg << ", $0, "; break;
+            case Type::LESS:          assemblyOut << "bltz " << reg << ", "; break;
+            case Type::LESS_EQUAL:    assemblyOut << "blez " << reg << ", "; break;
+            case Type::GREATER:       assemblyOut << "bgtz " << reg << ", "; break;
+            default:                  assemblyOut << "bgez " << reg << ", "; break;
+        }
+        assemblyOut << label << std::endl;
+        assemblyOut << "nop" << std::endl;
+        return;
+    }
+
+    // x <= c is x < c+1 as long as c+1 doesn't overflow (-1 is the largest unsigned),
+    // the set instruction gives whether the branch is taken (bne) or not (beq)
+    int bound = (cmp == Type::LESS_EQUAL || cmp == Type::GREATER) ? r + 1 : r;
+    bool immediate = rightConst && cmp != Type::EQUAL_EQUAL && cmp != Type::BANG_EQUAL
+        && r != INT32_MAX && !(isUnsigned && r == -1) && bound >= (isUnsigned ? 0 : -32768) && bound <= 32767;
+    if (immediate) {
+        left->compileToReg(assemblyOut, reg);
+        assemblyOut << (isUnsigned ? "sltiu " : "slti ") << reg << ", " << reg << ", " << bound << std::endl;
+        freeReg(reg);
+        bool taken = cmp == Type::LESS || cmp == Type::LESS_EQUAL;
+        assemblyOut << (taken ? "bne " : "beq ") << reg << ", $0, " << label << std::endl;
+        assemblyOut << "nop" << std::endl;
+        return;
+    }
+
+    std::string leftReg, rightReg;
+    compileOperands(assemblyOut, reg, leftReg, rightReg);
+    std::string slt = isUnsigned ? "sltu " : "slt ";
+    switch (cmp) {
+        case Type::EQUAL_EQUAL:
+            assemblyOut << "beq " << leftReg << ", " << rightReg << ", " << label << std::endl;
+            break;
+        case Type::BANG_EQUAL:
+            assemblyOut << "bne " << leftReg << ", " << rightReg << ", " << label << std::endl;
+            break;
+        case Type::LESS:
+            assemblyOut << slt << reg << ", " << leftReg << ", " << rightReg << std::endl;
+            assemblyOut << "bne " << reg << ", $0, " << label << std::endl;
+            break;
+        case Type::GREATER_EQUAL:
+            assemblyOut << slt << reg << ", " << leftReg << ", " << rightReg << std::endl;
+            assemblyOut << "beq " << reg << ", $0, " << label << std::endl;
+            break;
+        case Type::GREATER:
+            assemblyOut << slt << reg << ", " << rightReg << ", " << leftReg << std::endl;
+            assemblyOut << "bne " << reg << ", $0, " << label << std::endl;
+            break;
+        default:
+            assemblyOut << slt << reg << ", " << rightReg << ", " << leftReg << std::endl;
+            assemblyOut << "beq " << reg << ", $0, " << label << std::endl;
+            break;
+    }
+    assemblyOut << "nop" << std::endl;
+
+    freeReg(leftReg);
+    freeReg(rightReg);
+    if (leftReg != reg && rightReg != reg) {
+        freeReg(reg);
+    }
+}
+
+IRInstr* AST_BinOp::lowerToValue(IRBuilder &builder) {
+    this->getType(); // ensure that interalDataType is initialised
+    TypeKind varType = this->internalDataType->getTypeKind();
+
+    // short-circuit evaluation, the value depends on where the condition continues
+    if (type == Type::LOGIC_OR || type == Type::LOGIC_AND) {
+        IRBlock* trueBlock = builder.fn->newBlock();
+        IRBlock* falseBlock = builder.fn->newBlock();
+        IRBlock* endBlock = builder.fn->newBlock();
+        lowerBranch(builder, trueBlock, falseBlock);
+        builder.sealBlock(trueBlock);
+        builder.sealBlock(falseBlock);
+
+        builder.setBlock(trueBlock);
+        IRInstr* one = builder.constant(1);
+        builder.jump(endBlock);
+        builder.setBlock(falseBlock);
+        IRInstr* zero = builder.constant(0);
+        builder.jump(endBlock);
+
+        builder.sealBlock(endBlock);
+        builder.setBlock(endBlock);
+        return builder.phi(IRType::WORD, {{trueBlock, one}, {falseBlock, zero}});
+    }
+
+    IRInstr* l = left->lowerToValue(builder);
+    IRInstr* r = right->lowerToValue(builder);
+
+    if (varType == TypeKind::FLOAT || varType == TypeKind::DOUBLE) {
+        IRType valueType = irType(varType);
+        switch (type) {
+            case Type::EQUAL_EQUAL:     return builder.binary(IROp::SEQ, IRType::WORD, l, r);
+            case Type::BANG_EQUAL:      return builder.binary(IROp::SNE, IRType::WORD, l, r);
+            case Type::LESS:            return builder.binary(IROp::SLT, IRType::WORD, l, r);
+            case Type::LESS_EQUAL:      return builder.binary(IROp::SLE, IRType::WORD, l, r);
+            case Type::GREATER:         return builder.binary(IROp::SGT, IRType::WORD, l, r);
+            case Type::GREATER_EQUAL:   return builder.binary(IROp::SGE, IRType::WORD, l, r);
+            case Type::PLUS:            return builder.binary(IROp::ADD, valueType, l, r);
+            case Type::MINUS:           return builder.binary(IROp::SUB, valueType, l, r);
+            case Type::STAR:            return builder.binary(IROp::MUL, valueType, l, r);
+            case Type::SLASH_F:         return builder.binary(IROp::DIV, valueType, l, r);
+            default:
+                throw IRUnsupported("AST_BinOp: operator not supported on " + this->internalDataType->getTypeName() + ".\n");
+        }
+    }
+
+    if (varType == TypeKind::POINTER && (type == Type::PLUS || type == Type::MINUS || type == Type::ARRAY)) {
+        // indices are scaled by the size of the pointed to type
+        IRInstr* bytes = builder.constant(internalDataType->getType()->getBytes());
+        if (type == Type::MINUS && right->getTypeKind() == TypeKind::POINTER) {
+            return builder.binary(IROp::DIV, IRType::WORD, builder.binary(IROp::SUB, IRType::WORD, l, r), bytes);
+        }
+        IRInstr* offset = builder.binary(IROp::MUL, IRType::WORD, r, bytes);
+        if (type == Type::MINUS) {
+            return builder.binary(IROp::SUB, IRType::WORD, l, offset);
+        }
+        IRInstr* address = builder.binary(IROp::ADD, IRType::WORD, l, offset);
+        if (type == Type::PLUS || returnPtr) {
+            return address;
+        }
+        TypeKind returnType = internalDataType->getType()->getTypeKind();
+        return builder.load(irType(returnType), address, returnType == TypeKind::CHAR);
+    }
+
+    bool isUnsigned = varType == TypeKind::UNSIGNED || varType == TypeKind::POINTER;
+    switch (type) {
+        case Type::BIT_OR:          return builder.binary(IROp::OR, IRType::WORD, l, r);
+        case Type::BIT_XOR:         return builder.binary(IROp::XOR, IRType::WORD, l, r);
+        case Type::BIT_AND:         return builder.binary(IROp::AND, IRType::WORD, l, r);
+        case Type::EQUAL_EQUAL:     return builder.binary(IROp::SEQ, IRType::WORD, l, r);
+        case Type::BANG_EQUAL:      return builder.binary(IROp::SNE, IRType::WORD, l, r);
+        case Type::LESS:            return builder.binary(isUnsigned ? IROp::SLTU : IROp::SLT, IRType::WORD, l, r);
+        case Type::LESS_EQUAL:      return builder.binary(isUnsigned ? IROp::SLEU : IROp::SLE, IRType::WORD, l, r);
+        case Type::GREATER:         return builder.binary(isUnsigned ? IROp::SGTU : IROp::SGT, IRType::WORD, l, r);
+        case Type::GREATER_EQUAL:   return builder.binary(isUnsigned ? IROp::SGEU : IROp::SGE, IRType::WORD, l, r);
+        case Type::SHIFT_L:         return builder.binary(IROp::SHL, IRType::WORD, l, r);
+        case Type::SHIFT_R:         return builder.binary(varType == TypeKind::UNSIGNED ? IROp::SHRU : IROp::SHR, IRType::WORD, l, r);
+        case Type::MINUS:           return builder.binary(IROp::SUB, IRType::WORD, l, r);
+        case Type::STAR:            return builder.binary(IROp::MUL, IRType::WORD, l, r);
+        case Type::SLASH_F:         return builder.binary(varType == TypeKind::UNSIGNED ? IROp::DIVU : IROp::DIV, IRType::WORD, l, r);
+        case Type::PERCENT:         return builder.binary(varType == TypeKind::UNSIGNED ? IROp::REMU : IROp::REM, IRType::WORD, l, r);
+        case Type::PLUS:
+            if (right->getTypeKind() == TypeKind::POINTER) {
+                l = builder.binary(IROp::MUL, IRType::WORD, l, builder.constant(internalDataType->getType()->getBytes()));
+            }
+            return builder.binary(IROp::ADD, IRType::WORD, l, r);
+        default:
+            throw IRUnsupported("AST_BinOp: operator not supported on " + this->internalDataType->getTypeName() + ".\n");
+    }
+}
+
+void AST_BinOp::lowerBranch(IRBuilder &builder, IRBlock* trueBlock, IRBlock* falseBlock) {
+    // the right operand is only reached if the left one doesn't decide the result
+    if (type == Type::LOGIC_OR || type == Type::LOGIC_AND) {
+        IRBlock* rightBlock = builder.fn->newBlock();
+        if (type == Type::LOGIC_OR) {
+            left->lowerBranch(builder, trueBlock, rightBlock);
+        } else {
+            left->lowerBranch(builder, rightBlock, falseBlock);
+        }
+        builder.sealBlock(rightBlock);
+        builder.setBlock(rightBlock);
+        right->lowerBranch(builder, trueBlock, falseBlock);
+        return;
+    }
+    // comparisons are fused with the branch by the instruction selection
+    AST::lowerBranch(builder, trueBlock, falseBlock);
+}
+
+int AST_BinOp::getRegNeed() {
+    int leftNeed = left->getRegNeed();
+    int rightNeed = right->getRegNeed();
+
+    if (type == Type::LOGIC_OR || type == Type::LOGIC_AND) {
+        // operands are evaluated one after the other while the destination holds the result
+        return std::max(leftNeed, rightNeed) + 1;
+    }
+
+    int need = leftNeed == rightNeed ? leftNeed + 1 : std::max(leftNeed, rightNeed);
+    if (leftNeed < rightNeed && leftEvaluatedFirst()) {
+        need = rightNeed + 1;
+    }
+
+    // destination can't hold an operand when the kind of register differs (e.g. float comparison)
+    if (usesFloatReg(left) != usesFloatReg(this)) {
+        need++;
+    }
+    return need;
+}
 
-        // store result in memory
-        assemblyOut << "sw $t2, 16($sp)" << std::endl;
+bool AST_BinOp::leftEvaluatedFirst() {
+    if (left->hasSideEffects() || right->hasSideEffects()) {
+        return true;
     }
-    
-    assemblyOut << "addiu $sp, $sp, 8" << std::endl;
+    return left->getRegNeed() >= right->getRegNeed();
+}
 
-    assemblyOut << "# end " << binLabel << std::endl << std::endl; 
+bool AST_BinOp::hasSideEffects() {
+    return left->hasSideEffects() || right->hasSideEffects();
 }
 
 void AST_BinOp::setType(std::string newType) { 
-    this->dataType = new AST_Type(&newType);
+    this->dataType = AST_Type::get(AST_Type::kindOf(newType));
 }
 
-AST* AST_BinOp::getType(){
+AST* AST_BinOp::computeType(){
     if (this->internalDataType == nullptr) {
         // save internal type
         this->internalDataType = left->getType();
@@ -1268,7 +1247,7 @@ AST* AST_BinOp::getType(){
         if(type == AST_BinOp::Type::ARRAY){
             left_type = left_type->getType();
         }
-        if(left->getTypeName() == "int" && right->getTypeName() == "pointer" && type == AST_BinOp::Type::PLUS){
+        if(left->getTypeKind() == TypeKind::INT && right->getTypeKind() == TypeKind::POINTER && type == AST_BinOp::Type::PLUS){
             left_type = right->getType();
         }
         this->dataType = left_type;
@@ -1276,30 +1255,36 @@ AST* AST_BinOp::getType(){
     return this->dataType;
 }
 
+std::string AST_BinOp::computeTypeName(){
+    return getType()->getTypeName();
+}
+
 int AST_BinOp::getBytes(){
     // assuming left and right have same type
     // we don't need to implement implicit casting so this should be fine
     int bytes = left->getBytes();
-    if(left->getTypeName() == "pointer"){
+    if(left->getTypeKind() == TypeKind::POINTER){
         bytes = left->getType()->getType()->getBytes();
     }
     return bytes;
 }
 
-AST_BinOp::~AST_BinOp(){
-    delete left;
-    delete right;
-}
-
 AST_UnOp::AST_UnOp(AST_UnOp::Type _type, AST* _operand):
     type(_type),
-    operand(_operand)
+    operand(_operand),
+    dataType(nullptr),
+    internalDataType(nullptr)
 {}
 
 void AST_UnOp::generateFrames(Frame* _frame){
     frame = _frame;
-    if(type == Type::ADDRESS)
+    if(type == Type::ADDRESS){
         operand->returnPtr = true;
+        // variables whose address is taken have to stay in memory
+        if(operand->isVar && RegisterAllocator::current != nullptr){
+            RegisterAllocator::current->takeAddress(_frame, operand->getName());
+        }
+    }
     operand->generateFrames(_frame);
 }
 
@@ -1308,150 +1293,168 @@ AST* AST_UnOp::deepCopy(){
     return new AST_UnOp(type, new_operand);
 }
 
-void AST_UnOp::compile(std::ostream &assemblyOut) {
-    getType();
-    std::string varType = this->internalDataType->getTypeName();
+AST* AST_UnOp::fold(){
+    operand = operand->fold();
 
-    std::string unLabel = generateUniqueLabel("unOp");
-    assemblyOut << std::endl << "# start " << unLabel << std::endl;
+    if (returnPtr) {
+        return this;
+    }
 
-    operand->compile(assemblyOut);
+    TypeKind kind = constantKind(operand);
+    switch (type) {
+        case Type::PLUS:
+            return operand;
+        case Type::BANG:
+            switch (kind) {
+                case TypeKind::INT:    return makeConstant(this, operand->getIntValue() == 0 ? 1 : 0);
+                case TypeKind::FLOAT:  return makeConstant(this, operand->getFloatValue() == 0.0f ? 1 : 0);
+                case TypeKind::DOUBLE: return makeConstant(this, operand->getDoubleValue() == 0.0 ? 1 : 0);
+                default:               break;
+            }
+            break;
+        case Type::NOT:
+            if (kind == TypeKind::INT) return makeConstant(this, ~operand->getIntValue());
+            break;
+        case Type::MINUS:
+            switch (kind) {
+                case TypeKind::INT:    return makeConstant(this, (int)(0u - (uint32_t)operand->getIntValue()));
+                case TypeKind::FLOAT:  return makeConstant(this, -operand->getFloatValue());
+                case TypeKind::DOUBLE: return makeConstant(this, -operand->getDoubleValue());
+                default:               break;
+            }
+            break;
+        default:
+            break;
+    }
+    return this;
+}
 
-    if (varType == "float") {
-        assemblyOut << "l.s $f4, 8($sp)" << std::endl;
+void AST_UnOp::compileBranch(std::ostream &assemblyOut, const std::string &label, bool jumpIf) {
+    // floating point operands are tested on their bits, which compileCondToReg already does
+    if (type == Type::BANG && !usesFloatReg(operand)) {
+        operand->compileBranch(assemblyOut, label, !jumpIf);
+        return;
+    }
+    AST::compileBranch(assemblyOut, label, jumpIf);
+}
 
-        switch (type) {
-            case Type::ADDRESS:
-            {
-                assemblyOut << "# " << unLabel << " is &" << std::endl;
-                // does nothing in compile part
-                assemblyOut << "mov.s $f6, $f4" << std::endl;
-                break;
-            }
-            case Type::MINUS:
-            {
-                assemblyOut << "# " << unLabel << " is float -" << std::endl;
+AST* AST_UnOp::foldCondition(AST* cond){
+    cond = cond->fold();
 
-                assemblyOut << "neg.s $f6, $f4" << std::endl;
-                break;
-            }
-            default:
-            {
-                throw std::runtime_error("AST_BinOp: Float Not Implemented Yet.\n");
-                break;
-            }
+    AST_UnOp* outer = dynamic_cast<AST_UnOp*>(cond);
+    while (outer != nullptr && outer->type == Type::BANG) {
+        AST_UnOp* inner = dynamic_cast<AST_UnOp*>(outer->operand);
+        // conditions on floating point values are tested on their bits (see compileCondToReg), so -0.0 would differ
+        if (inner == nullptr || inner->type != Type::BANG || usesFloatReg(inner->operand)) {
+            break;
         }
+        cond = inner->operand;
+        outer = dynamic_cast<AST_UnOp*>(cond);
+    }
+    return cond;
+}
 
-        // push onto operand stack
-        assemblyOut << "s.s $f6, 8($sp)" << std::endl;
+void AST_UnOp::compile(std::ostream &assemblyOut) {
+    compileAndDiscard(assemblyOut);
+}
+
+void AST_UnOp::compileToReg(std::ostream &assemblyOut, const std::string &reg) {
+    getType();
+    TypeKind varType = this->internalDataType->getTypeKind();
+
+    std::string unLabel = generateUniqueLabel("unOp");
+    assemblyOut << std::endl << "# start " << unLabel << std::endl;
+
+    if (type == Type::ADDRESS) {
+        // operand returns its address
+        assemblyOut << "# " << unLabel << " is &" << std::endl;
+        operand->compileToReg(assemblyOut, reg);
     }
-    else if (varType == "double") {
-        assemblyOut << "l.d $f4, 8($sp)" << std::endl;
-        bool useF6 = true;
+    else if (varType == TypeKind::FLOAT || varType == TypeKind::DOUBLE) {
+        operand->compileToReg(assemblyOut, reg);
+
+        std::string fmt = varType == TypeKind::FLOAT ? ".s " : ".d ";
         switch (type) {
-            case Type::ADDRESS:
-            {
-                assemblyOut << "# " << unLabel << " is &" << std::endl;
-                // does nothing in compile part
-                useF6 = false;
-                break;
-            }
             case Type::MINUS:
             {
-                assemblyOut << "# " << unLabel << " is double -" << std::endl;
-
-                assemblyOut << "neg.d $f6, $f4" << std::endl;
+                assemblyOut << "# " << unLabel << " is " << this->internalDataType->getTypeName() << " -" << std::endl;
+                assemblyOut << "neg" << fmt << reg << ", " << reg << std::endl;
                 break;
             }
+            case Type::PLUS:
+                // does nothing at all
+                break;
             default:
             {
+                if (varType == TypeKind::FLOAT) {
+                    throw std::runtime_error("AST_UnOp: Float Not Implemented Yet.\n");
+                }
                 throw std::runtime_error("AST_UnOp: Double Not Implemented Yet.\n");
                 break;
             }
         }
-
-        // push onto operand stack
-        if(useF6)
-            assemblyOut << "s.d $f6, 8($sp)" << std::endl;
     }
-    else if(varType == "pointer"){
-        assemblyOut << "lw $t0, 8($sp)" << std::endl;
+    else if(varType == TypeKind::POINTER){
         switch(type){
             case Type::DEREFERENCE:
             {
                 assemblyOut << "# " << unLabel << " is *" << std::endl;
-                
-                if(!returnPtr){
-                    if(dataType->getTypeName() == "double"){
-                        assemblyOut << "l.d $f4, 0($t0)" << std::endl;
-                        assemblyOut << "s.d $f4, 8($sp)" << std::endl;
+
+                if(returnPtr){
+                    operand->compileToReg(assemblyOut, reg);
+                }
+                else{
+                    // pointer has to be in an integer register
+                    std::string addressReg = reg[1] == 'f' ? allocateReg(false) : reg;
+                    operand->compileToReg(assemblyOut, addressReg);
+
+                    TypeKind dataKind = dataType->getTypeKind();
+                    if(dataKind == TypeKind::DOUBLE){
+                        assemblyOut << "l.d " << reg << ", 0(" << addressReg << ")" << std::endl;
                     }
-                    if(dataType->getTypeName() == "char"){
-                        assemblyOut << "move $t1, $0" << std::endl;
-                        assemblyOut << "lb $t1, 0($t0)" << std::endl;
-                        assemblyOut << "sw $t1, 8($sp)" << std::endl;
+                    else if(dataKind == TypeKind::FLOAT){
+                        assemblyOut << "l.s " << reg << ", 0(" << addressReg << ")" << std::endl;
+                    }
+                    else if(dataKind == TypeKind::CHAR){
+                        assemblyOut << "lb " << reg << ", 0(" << addressReg << ")" << std::endl;
                     }
                     else{
-                        assemblyOut << "lw $t1, 0($t0)" << std::endl;
-                        assemblyOut << "sw $t1, 8($sp)" << std::endl;
+                        assemblyOut << "lw " << reg << ", 0(" << addressReg << ")" << std::endl;
                     }
+
+                    if(addressReg != reg)
+                        freeReg(addressReg);
                 }
                 break;
             }
-            case Type::ADDRESS:
-                // does nothing at all
-                break;
             case Type::PRE_INCREMENT:
-            {
-                assemblyOut << "# " << unLabel << " is pre ++" << std::endl;
-
-                assemblyOut << "addiu $t1, $t0, " << internalDataType->getType()->getBytes() << std::endl;
-
-                // update variable
-                operand->updateVariable(assemblyOut, frame, "$t1");
-
-                // push onto stack            
-                assemblyOut << "sw $t1, 8($sp)" << std::endl;
-                
-                break;
-            }
             case Type::PRE_DECREMENT:
             {
-                assemblyOut << "# " << unLabel << " is pre --" << std::endl;
+                assemblyOut << "# " << unLabel << " is pre " << (type == Type::PRE_INCREMENT ? "++" : "--") << std::endl;
+                operand->compileToReg(assemblyOut, reg);
 
-                assemblyOut << "addiu $t1, $t0, -" << internalDataType->getType()->getBytes() << std::endl;
+                std::string sign = type == Type::PRE_INCREMENT ? "" : "-";
+                assemblyOut << "addiu " << reg << ", " << reg << ", " << sign << internalDataType->getType()->getBytes() << std::endl;
 
                 // update variable
-                operand->updateVariable(assemblyOut, frame, "$t1");
-
-                // push onto stack            
-                assemblyOut << "sw $t1, 8($sp)" << std::endl;
+                operand->updateVariable(assemblyOut, frame, reg);
                 break;
             }
             case Type::POST_INCREMENT:
-            {
-                assemblyOut << "# " << unLabel << " is post ++" << std::endl;
-
-                // push onto operand stack
-                assemblyOut << "sw $t0, 8($sp)" << std::endl;
-
-                assemblyOut << "addiu $t1, $t0, " << internalDataType->getType()->getBytes() << std::endl;
-
-                // update variable
-                operand->updateVariable(assemblyOut, frame, "$t1");
-                break;
-            }
             case Type::POST_DECREMENT:
             {
-                assemblyOut << "# " << unLabel << " is post --" << std::endl;
-                
-                // push onto operand stack
-                assemblyOut << "sw $t0, 8($sp)" << std::endl;
+                assemblyOut << "# " << unLabel << " is post " << (type == Type::POST_INCREMENT ? "++" : "--") << std::endl;
+                operand->compileToReg(assemblyOut, reg);
 
-                assemblyOut << "addiu $t1, $t0, -" << internalDataType->getType()->getBytes() << std::endl;
+                // reg keeps the old value, unless nothing uses it
+                std::string sign = type == Type::POST_INCREMENT ? "" : "-";
+                std::string newValueReg = resultUnused ? reg : allocateReg(false);
+                assemblyOut << "addiu " << newValueReg << ", " << reg << ", " << sign << internalDataType->getType()->getBytes() << std::endl;
 
                 // update variable
-                operand->updateVariable(assemblyOut, frame, "$t1");
+                operand->updateVariable(assemblyOut, frame, newValueReg);
+                if(newValueReg != reg)
+                    freeReg(newValueReg);
                 break;
             }
             default:
@@ -1462,116 +1465,165 @@ void AST_UnOp::compile(std::ostream &assemblyOut) {
         }
     }
     else {
-        assemblyOut << "lw $t0, 8($sp)" << std::endl;
+        operand->compileToReg(assemblyOut, reg);
 
         switch (type) {
-            case Type::ADDRESS:
-            {
-                assemblyOut << "# " << unLabel << " is &" << std::endl;
-                // does nothing in compile part
-                assemblyOut << "move $t1, $t0" << std::endl;
-                break;
-            }
             case Type::BANG:
             {
                 // if 0, set to 1 else, set to 0
                 assemblyOut << "# " << unLabel << " is !" << std::endl;
-
-                std::string currentlyFalseLabel = generateUniqueLabel("currentlyFalseLabel");
-                std::string endLabel = generateUniqueLabel("end");
-
-                assemblyOut << "beq $t0, $0, " << currentlyFalseLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                // currently true
-                assemblyOut << "addiu $t1, $0, 0" << std::endl;
-                assemblyOut << "j " << endLabel << std::endl;
-                assemblyOut << "nop" << std::endl;
-
-                // currently false
-                assemblyOut << currentlyFalseLabel <<  ":" << std::endl;
-                assemblyOut << "addiu $t1, $0, 1" << std::endl;
-                
-                assemblyOut << endLabel << ":" << std::endl;
+                assemblyOut << "sltiu " << reg << ", " << reg << ", 1" << std::endl;
                 break;
             }
             case Type::NOT:
             {
                 assemblyOut << "# " << unLabel << " is ~" << std::endl;
-
-                assemblyOut << "nor $t1, $t0, $t0" << std::endl;
+                assemblyOut << "nor " << reg << ", " << reg << ", $0" << std::endl;
                 break;
             }
             case Type::MINUS:
             {
                 assemblyOut << "# " << unLabel << " is -" << std::endl;
-
-                assemblyOut << "subu $t1, $0, $t0" << std::endl;
+                assemblyOut << "subu " << reg << ", $0, " << reg << std::endl;
                 break;
             }
-            case Type::PRE_INCREMENT:
-            {
-                assemblyOut << "# " << unLabel << " is pre ++" << std::endl;
-
-                assemblyOut << "addiu $t1, $t0, 1" << std::endl;
-
-                // update variable
-                operand->updateVariable(assemblyOut, frame, "$t1");
+            case Type::PLUS:
+                // does nothing at all
                 break;
-            }
+            case Type::PRE_INCREMENT:
             case Type::PRE_DECREMENT:
             {
-                assemblyOut << "# " << unLabel << " is pre --" << std::endl;
+                assemblyOut << "# " << unLabel << " is pre " << (type == Type::PRE_INCREMENT ? "++" : "--") << std::endl;
 
-                assemblyOut << "addiu $t1, $t0, -1" << std::endl;
+                std::string step = type == Type::PRE_INCREMENT ? "1" : "-1";
+                assemblyOut << "addiu " << reg << ", " << reg << ", " << step << std::endl;
 
                 // update variable
-                operand->updateVariable(assemblyOut, frame, "$t1");
+                operand->updateVariable(assemblyOut, frame, reg);
                 break;
             }
             case Type::POST_INCREMENT:
-            {
-                assemblyOut << "# " << unLabel << " is post ++" << std::endl;
-
-                // push onto operand stack
-                assemblyOut << "sw $t0, 8($sp)" << std::endl;
-
-                assemblyOut << "addiu $t1, $t0, 1" << std::endl;
-
-                // update variable
-                operand->updateVariable(assemblyOut, frame, "$t1");
-                break;
-            }
             case Type::POST_DECREMENT:
             {
-                assemblyOut << "# " << unLabel << " is post --" << std::endl;
-                
-                // push onto operand stack
-                assemblyOut << "sw $t0, 8($sp)" << std::endl;
+                assemblyOut << "# " << unLabel << " is post " << (type == Type::POST_INCREMENT ? "++" : "--") << std::endl;
 
-                assemblyOut << "addiu $t1, $t0, -1" << std::endl;
+                // reg keeps the old value, unless nothing uses it
+                std::string step = type == Type::POST_INCREMENT ? "1" : "-1";
+                std::string newValueReg = resultUnused ? reg : allocateReg(false);
+                assemblyOut << "addiu " << newValueReg << ", " << reg << ", " << step << std::endl;
 
                 // update variable
-                operand->updateVariable(assemblyOut, frame, "$t1");
+                operand->updateVariable(assemblyOut, frame, newValueReg);
+                if(newValueReg != reg)
+                    freeReg(newValueReg);
                 break;
             }
             default:
             {
-                throw std::runtime_error("AST_BinOp: Not Implemented Yet.\n");
+                throw std::runtime_error("AST_UnOp: Not Implemented Yet.\n");
                 break;
             }
         }
+    }
+
+    assemblyOut << "# end " << unLabel << std::endl << std::endl;
+}
+
+IRInstr* AST_UnOp::lowerToValue(IRBuilder &builder) {
+    getType();
+    TypeKind varType = this->internalDataType->getTypeKind();
+
+    if (type == Type::ADDRESS) {
+        // operand returns its address
+        return operand->lowerToValue(builder);
+    }
+
+    if (varType == TypeKind::FLOAT || varType == TypeKind::DOUBLE) {
+        IRInstr* value = operand->lowerToValue(builder);
+        if (type == Type::MINUS) {
+            return builder.emit(IROp::NEG, irType(varType), {value});
+        } else if (type == Type::PLUS) {
+            return value;
+        }
+        throw IRUnsupported("AST_UnOp: operator not supported on " + this->internalDataType->getTypeName() + ".\n");
+    }
+
+    if (varType == TypeKind::POINTER && type == Type::DEREFERENCE) {
+        IRInstr* address = operand->lowerToValue(builder);
+        if (returnPtr) {
+            return address;
+        }
+        TypeKind dataKind = dataType->getTypeKind();
+        return builder.load(irType(dataKind), address, dataKind == TypeKind::CHAR);
+    }
 
-        // push onto operand stack
-        if (type != Type::POST_DECREMENT && type != Type::POST_INCREMENT) {
-            assemblyOut << "sw $t1, 8($sp)" << std::endl;
+    // pointers step over the pointed to type
+    int step = varType == TypeKind::POINTER ? internalDataType->getType()->getBytes() : 1;
+    IRInstr* value = operand->lowerToValue(builder);
+    switch (type) {
+        case Type::PRE_INCREMENT:
+        case Type::PRE_DECREMENT:
+        case Type::POST_INCREMENT:
+        case Type::POST_DECREMENT:
+        {
+            bool increment = type == Type::PRE_INCREMENT || type == Type::POST_INCREMENT;
+            IRInstr* newValue = builder.binary(IROp::ADD, IRType::WORD, value, builder.constant(increment ? step : -step));
+            operand->lowerUpdate(builder, newValue);
+            return type == Type::PRE_INCREMENT || type == Type::PRE_DECREMENT ? newValue : value;
         }
+        default:
+            break;
+    }
+    if (varType == TypeKind::POINTER) {
+        throw IRUnsupported("AST_UnOp: operator not supported on pointer.\n");
+    }
+
+    switch (type) {
+        case Type::BANG:    return builder.binary(IROp::SEQ, IRType::WORD, value, builder.constant(0));
+        case Type::NOT:     return builder.emit(IROp::NOT, IRType::WORD, {value});
+        case Type::MINUS:   return builder.emit(IROp::NEG, IRType::WORD, {value});
+        case Type::PLUS:    return value;
+        default:
+            throw IRUnsupported("AST_UnOp: operator not supported on " + this->internalDataType->getTypeName() + ".\n");
+    }
+}
+
+void AST_UnOp::lowerBranch(IRBuilder &builder, IRBlock* trueBlock, IRBlock* falseBlock) {
+    // floating point operands are tested on their bits like in compileBranch
+    if (type == Type::BANG && !usesFloatReg(operand)) {
+        operand->lowerBranch(builder, falseBlock, trueBlock);
+        return;
+    }
+    AST::lowerBranch(builder, trueBlock, falseBlock);
+}
+
+int AST_UnOp::getRegNeed() {
+    int need = operand->getRegNeed();
+
+    // post increment needs a register for the new value
+    if (type == Type::POST_INCREMENT || type == Type::POST_DECREMENT) {
+        return std::max(need, 2);
+    }
+    // dereferencing into a floating point register needs an integer register for the address
+    if (type == Type::DEREFERENCE && !returnPtr && usesFloatReg(this)) {
+        return need + 1;
+    }
+    return need;
+}
+
+bool AST_UnOp::hasSideEffects() {
+    switch (type) {
+        case Type::PRE_INCREMENT:
+        case Type::PRE_DECREMENT:
+        case Type::POST_INCREMENT:
+        case Type::POST_DECREMENT:
+            return true;
+        default:
+            return operand->hasSideEffects();
     }
-    
-    assemblyOut << "# end " << unLabel << std::endl << std::endl; 
 }
 
-AST* AST_UnOp::getType(){
+AST* AST_UnOp::computeType(){
     if(internalDataType == nullptr){
         // save internal type
         this->internalDataType = operand->getType();
@@ -1593,6 +1645,10 @@ AST* AST_UnOp::getType(){
     return this->dataType;
 }
 
+std::string AST_UnOp::computeTypeName(){
+    return getType()->getTypeName();
+}
+
 int AST_UnOp::getBytes(){
     if(dataType == nullptr){
         getType();
@@ -1600,10 +1656,6 @@ int AST_UnOp::getBytes(){
     return dataType->getBytes();
 }
 
-AST_UnOp::~AST_UnOp(){
-    delete operand;
-}
-
 AST_Sizeof::AST_Sizeof(AST* _operand) :
     operand(_operand)
 {}
@@ -1614,34 +1666,40 @@ void AST_Sizeof::generateFrames(Frame* _frame) {
 }
 
 void AST_Sizeof::compile(std::ostream &assemblyOut) {
+    compileAndDiscard(assemblyOut);
+}
+
+void AST_Sizeof::compileToReg(std::ostream &assemblyOut, const std::string &reg) {
     int size = operand->getBytes();
 
     // char is treated as having the same size as int internally 
-    if (operand->getTypeName() == "char") {
+    if (operand->getTypeKind() == TypeKind::CHAR) {
         size = 1;
     }
 
-    assemblyOut << std::endl << "# start sizeof" << std::endl;
-    
-    // load size into register
-    assemblyOut << "addiu $t0, $0, " << size << std::endl;
+    assemblyOut << "# sizeof" << std::endl;
+    assemblyOut << "li " << reg << ", " << size << std::endl;
+}
+
+bool AST_Sizeof::hasSideEffects() {
+    return false;
+}
 
-    // store size to top of stack
-    assemblyOut << "sw $t0, 0($sp)" << std::endl;
-    assemblyOut << "addiu $sp, $sp, -8" << std::endl;
+AST* AST_Sizeof::fold() {
+    int size = operand->getBytes();
 
-    assemblyOut << "# end sizeof" << std::endl << std::endl;
+    // char is treated as having the same size as int internally 
+    if (operand->getTypeKind() == TypeKind::CHAR) {
+        size = 1;
+    }
+    return makeConstant(this, size);
 }
 
-AST* AST_Sizeof::getType() {
-    std::string typeName = "int";
-    return new AST_Type(&typeName);
+AST* AST_Sizeof::computeType() {
+    return AST_Type::get(TypeKind::INT);
 }
 
 int AST_Sizeof::getBytes() {
     return 4;
 }
 
-AST_Sizeof::~AST_Sizeof() {
-    delete operand;
-}
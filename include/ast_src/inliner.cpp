@@ -0,0 +1,230 @@
+#include "inliner.hpp"
+#include "pipeline.hpp"
+#include "structure.hpp"
+
+int Inliner::threshold = -1;
+
+const int Inliner::defaultThreshold = 40;
+const int Inliner::singleCallBonus = 200;
+const int Inliner::maxDepth = 4;
+const int Inliner::maxCallerSize = 2000;
+
+// the jump, its delay slot and taking the result, passing the arguments comes on top
+static const int callInstructions = 3;
+
+int Inliner::size(IRFunction* fn) {
+    int count = 0;
+    for (IRBlock* block : fn->blocks) {
+        for (IRInstr* instr : block->instrs) {
+            // constants are folded into the instructions using them and most jumps fall through
+            if (instr->op != IROp::PARAM && instr->op != IROp::CONST && instr->op != IROp::JUMP) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+std::string Inliner::checkCallee(IRFunction* fn, IRInstr* call, IRFunction* callee) {
+    if (callee->paramTypes.size() != call->operands.size()) {
+        return "it is called with " + std::to_string(call->operands.size()) + " arguments";
+    }
+    for (int i = 0; i < (int)call->operands.size(); i++) {
+        if (call->operands[i]->type != callee->paramTypes[i]) {
+            return "argument " + std::to_string(i + 1) + " doesn't have the type of the parameter";
+        }
+    }
+    IRType resultType = call->op == IROp::TAILCALL ? fn->returnType : call->type;
+    if (call->op == IROp::TAILCALL && callee->returnType != resultType) {
+        return "it returns another type than the caller";
+    }
+    for (IRBlock* block : callee->blocks) {
+        IRInstr* ret = block->terminator();
+        if (resultType != IRType::VOID && ret->op == IROp::RET && !ret->operands.empty() && ret->operands[0]->type != resultType) {
+            return "it returns a value of another type than its own";
+        }
+    }
+    return "";
+}
+
+std::vector<IRInstr*> Inliner::substitute(IRFunction* fn, IRInstr* call, IRFunction* callee) {
+    IRBlock* block = call->block;
+    IRType resultType = call->type;
+    std::vector<IRBlock*> blocks = fn->takeBlocks(callee);
+    IRBlock* entry = blocks[0];
+    std::vector<IRInstr*> params = entry->instrs;
+    for (IRInstr* param : params) {
+        if (param->op == IROp::PARAM) {
+            param->replaceAllUsesWith(call->operands[param->imm]);
+            fn->erase(param);
+        }
+    }
+    entry->preds.push_back(block);
+    int position = std::find(fn->blocks.begin(), fn->blocks.end(), block) - fn->blocks.begin() + 1;
+    fn->blocks.insert(fn->blocks.begin() + position, blocks.begin(), blocks.end());
+
+    // the returns of the callee return from the caller as well after a tail call
+    std::vector<IRInstr*> calls;
+    if (call->op == IROp::TAILCALL) {
+        for (IRBlock* inlined : blocks) {
+            for (IRInstr* instr : inlined->instrs) {
+                if (instr->op == IROp::CALL || instr->op == IROp::TAILCALL) {
+                    calls.push_back(instr);
+                }
+            }
+        }
+        fn->erase(call);
+        IRInstr* jump = fn->newInstr(IROp::JUMP, IRType::VOID);
+        jump->targets.push_back(entry);
+        block->append(jump);
+        return calls;
+    }
+
+    // the code after the call continues in a block of its own
+    IRBlock* rest = fn->newBlock();
+    fn->blocks.pop_back();
+    auto after = std::find(block->instrs.begin(), block->instrs.end(), call) + 1;
+    for (auto it = after; it != block->instrs.end(); it++) {
+        (*it)->block = rest;
+        rest->instrs.push_back(*it);
+    }
+    block->instrs.erase(after, block->instrs.end());
+    for (IRBlock* successor : rest->successors()) {
+        std::replace(successor->preds.begin(), successor->preds.end(), block, rest);
+    }
+
+    // returns jump to it instead, tail calls return the value of a call
+    std::vector<IRInstr*> results;
+    for (IRBlock* inlined : blocks) {
+        for (IRInstr* instr : inlined->instrs) {
+            if (instr->op == IROp::CALL) {
+                calls.push_back(instr);
+            }
+        }
+        IRInstr* terminator = inlined->terminator();
+        if (terminator->op == IROp::TAILCALL) {
+            IRInstr* value = fn->newInstr(IROp::CALL, callee->returnType);
+            value->name = terminator->name;
+            for (IRInstr* argument : terminator->operands) {
+                value->addOperand(argument);
+            }
+            inlined->insertBeforeTerminator(value);
+            calls.push_back(value);
+            results.push_back(value);
+        } else if (terminator->op == IROp::RET) {
+            results.push_back(terminator->operands.empty() ? nullptr : terminator->operands[0]);
+        } else {
+            continue;
+        }
+        fn->erase(terminator);
+        IRInstr* jump = fn->newInstr(IROp::JUMP, IRType::VOID);
+        jump->targets.push_back(rest);
+        inlined->append(jump);
+        rest->preds.push_back(inlined);
+    }
+
+    if (!call->users.empty()) {
+        // floating point functions can end without returning anything
+        for (int i = 0; i < (int)results.size(); i++) {
+            if (results[i] == nullptr) {
+                results[i] = fn->newInstr(IROp::CONST, resultType);
+                rest->preds[i]->insertBeforeTerminator(results[i]);
+            }
+        }
+        IRInstr* result;
+        if (results.size() == 1) {
+            result = results[0];
+        } else {
+            // nothing returns if results is empty, the code after the call can't be reached then
+            result = fn->newInstr(results.empty() ? IROp::CONST : IROp::PHI, resultType);
+            for (IRInstr* value : results) {
+                result->addOperand(value);
+            }
+            rest->insertAfterPhis(result);
+        }
+        call->replaceAllUsesWith(result);
+    }
+    fn->erase(call);
+
+    IRInstr* jump = fn->newInstr(IROp::JUMP, IRType::VOID);
+    jump->targets.push_back(entry);
+    block->append(jump);
+    fn->blocks.insert(fn->blocks.begin() + position + blocks.size(), rest);
+    return calls;
+}
+
+void Inliner::inlineCalls(IRFunction* fn) {
+    int limit = threshold >= 0 ? threshold : Pipeline::getLevel() == "Os" ? 0 : defaultThreshold;
+
+    // calls still to look at, with the functions inlined on the way to them starting from fn
+    std::vector<std::pair<IRInstr*, std::vector<std::string>>> worklist;
+    for (IRBlock* block : fn->blocks) {
+        for (IRInstr* instr : block->instrs) {
+            if (instr->op == IROp::CALL || instr->op == IROp::TAILCALL) {
+                worklist.push_back({instr, {fn->name}});
+            }
+        }
+    }
+
+    bool changed = false;
+    for (int i = 0; i < (int)worklist.size(); i++) {
+        IRInstr* call = worklist[i].first;
+        std::vector<std::string> chain = worklist[i].second;
+        std::string name = call->name;
+        std::string remark = "'" + name + "' not inlined into '" + fn->name + "': ";
+
+        if (std::find(chain.begin(), chain.end(), name) != chain.end()) {
+            Pipeline::remark("inline", remark + "the call is recursive", true);
+            continue;
+        }
+        if ((int)chain.size() > maxDepth) {
+            Pipeline::remark("inline", remark + "it is nested too deeply in inlined calls", true);
+            continue;
+        }
+        int callerSize = size(fn);
+        if (callerSize > maxCallerSize) {
+            Pipeline::remark("inline", remark + "the caller already has " + std::to_string(callerSize) + " instructions", true);
+            continue;
+        }
+
+        AST_FunDeclaration* declaration = dynamic_cast<AST_FunDeclaration*>(fn->frame->getFunction(name));
+        IRFunction* callee = declaration != nullptr ? declaration->lowerFunction() : nullptr;
+        if (callee == nullptr) {
+            Pipeline::remark("inline", remark + "its body isn't available in the IR", true);
+            continue;
+        }
+        std::string reason = checkCallee(fn, call, callee);
+        if (reason != "") {
+            Pipeline::remark("inline", remark + reason, true);
+            delete callee;
+            continue;
+        }
+
+        int cost = size(callee) - callInstructions - (int)call->operands.size();
+        int calleeLimit = limit;
+        if (fn->frame->getCallCount(name) == 1 && Pipeline::getLevel() != "Os") {
+            calleeLimit += singleCallBonus;
+        }
+        std::string costs = "(cost " + std::to_string(cost) + ", threshold " + std::to_string(calleeLimit) + ")";
+        if (cost > calleeLimit) {
+            Pipeline::remark("inline", remark + "too costly to inline " + costs, true);
+            delete callee;
+            continue;
+        }
+
+        std::vector<IRInstr*> calls = substitute(fn, call, callee);
+        delete callee;
+        changed = true;
+        Pipeline::remark("inline", "'" + name + "' inlined into '" + fn->name + "' " + costs);
+
+        chain.push_back(name);
+        for (IRInstr* inner : calls) {
+            worklist.push_back({inner, chain});
+        }
+    }
+
+    // the code after calls that never return
+    if (changed) {
+        fn->removeUnreachableBlocks();
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "ir.hpp"
+
+/*
+    Substitutes the bodies of functions for calls of them in the IR of a function.
+
+    The callee is looked up in the function table of the frames (Frame::getFunction) and lowered
+    again for every call site, so it can be defined before or after the caller. Its cost is the
+    number of instructions it brings in minus the ones the call needs, calls are inlined when it is
+    at most the threshold, which is higher for functions called only once in the file.
+    Calls in the inlined bodies are considered as well, but never calls of a function that is already
+    being inlined on the way to them, which stops recursion, and only up to maxDepth functions deep.
+
+    Every decision is reported with -Rpass=inline and -Rpass-missed=inline.
+*/
+class Inliner
+{
+public:
+    // -finline-threshold=<n>, -1 for the default of the optimisation level
+    static int threshold;
+
+    static void inlineCalls(IRFunction* fn);
+
+private:
+    static const int defaultThreshold;
+    static const int singleCallBonus;
+    static const int maxDepth;
+    // callers that grow past this many instructions stop inlining
+    static const int maxCallerSize;
+
+    // instructions that end up in the code of the function, roughly
+    static int size(IRFunction* fn);
+
+    // why the callee can't replace the call, "" if it can
+    static std::string checkCallee(IRFunction* fn, IRInstr* call, IRFunction* callee);
+
+    // replaces the call by the blocks of callee and returns the calls among them
+    static std::vector<IRInstr*> substitute(IRFunction* fn, IRInstr* call, IRFunction* callee);
+};
@@ -0,0 +1,753 @@
+#include "ir.hpp"
+
+IRInstr::IRInstr(IROp _op, IRType _type):
+    op(_op),
+    type(_type)
+{}
+
+bool IRInstr::isTerminator() const {
+    return op == IROp::JUMP || op == IROp::BRANCH || op == IROp::SWITCH || op == IROp::RET || op == IROp::TAILCALL;
+}
+
+bool IRInstr::isCompare() const {
+    return op >= IROp::SEQ && op <= IROp::SGEU;
+}
+
+bool IRInstr::hasSideEffects() const {
+    return op == IROp::STORE || op == IROp::CALL || isTerminator();
+}
+
+bool IRInstr::isConstant() const {
+    return op == IROp::CONST && type == IRType::WORD;
+}
+
+bool IRInstr::isConstant(int value) const {
+    return isConstant() && imm == value;
+}
+
+void IRInstr::addOperand(IRInstr* value) {
+    operands.push_back(value);
+    value->users.push_back(this);
+}
+
+void IRInstr::setOperand(int i, IRInstr* value) {
+    IRInstr* old = operands[i];
+    old->users.erase(std::find(old->users.begin(), old->users.end(), this));
+    operands[i] = value;
+    value->users.push_back(this);
+}
+
+void IRInstr::removeOperand(int i) {
+    IRInstr* old = operands[i];
+    old->users.erase(std::find(old->users.begin(), old->users.end(), this));
+    operands.erase(operands.begin() + i);
+}
+
+void IRInstr::dropOperands() {
+    while (!operands.empty()) {
+        removeOperand((int)operands.size() - 1);
+    }
+}
+
+void IRInstr::replaceAllUsesWith(IRInstr* value) {
+    std::vector<IRInstr*> oldUsers = users;
+    for (IRInstr* user : oldUsers) {
+        for (int i = 0; i < (int)user->operands.size(); i++) {
+            if (user->operands[i] == this) {
+                user->setOperand(i, value);
+            }
+        }
+    }
+}
+
+static const char* opName(IROp op) {
+    static const char* names[] = {
+        "const", "param",
+        "add", "sub", "mul", "div", "divu", "rem", "remu",
+        "and", "or", "xor", "shl", "shr", "shru",
+        "neg", "not",
+        "seq", "sne", "slt", "sle", "sgt", "sge",
+        "sltu", "sleu", "sgtu", "sgeu",
+        "sext8", "fbits",
+        "slot", "global", "string",
+        "load", "store", "call", "phi",
+        "jump", "branch", "switch", "ret", "tailcall"
+    };
+    return names[(int)op];
+}
+
+static const char* typeName(IRType type) {
+    switch (type) {
+        case IRType::VOID: return "void";
+        case IRType::WORD: return "word";
+        case IRType::FLOAT: return "float";
+        case IRType::DOUBLE: return "double";
+    }
+    return "";
+}
+
+std::string IRInstr::toString() const {
+    std::stringstream out;
+    if (type != IRType::VOID) {
+        out << "%" << id << ":" << typeName(type) << " = ";
+    }
+    out << opName(op);
+    if (isByte) {
+        out << ".b";
+    }
+
+    std::vector<std::string> args;
+    for (IRInstr* operand : operands) {
+        args.push_back("%" + std::to_string(operand->id));
+    }
+    if (op == IROp::CONST) {
+        if (type == IRType::WORD) {
+            args.push_back(std::to_string(imm));
+        } else {
+            std::stringstream value;
+            value << fimm;
+            args.push_back(value.str());
+        }
+    } else if (op == IROp::PARAM || op == IROp::SLOT || ((op == IROp::LOAD || op == IROp::STORE) && imm != 0)) {
+        args.push_back(std::to_string(imm));
+    } else if (op == IROp::GLOBAL || op == IROp::CALL || op == IROp::TAILCALL) {
+        args.insert(args.begin(), name);
+    } else if (op == IROp::STRING) {
+        args.push_back("\"" + name + "\"");
+    } else if (op == IROp::PHI) {
+        for (int i = 0; i < (int)operands.size(); i++) {
+            args[i] = "[" + args[i] + ", " + block->preds[i]->name() + "]";
+        }
+    } else if (op == IROp::SWITCH) {
+        args.push_back("default " + targets[0]->name());
+        for (int i = 0; i < (int)caseValues.size(); i++) {
+            args.push_back(std::to_string(caseValues[i]) + " " + targets[i + 1]->name());
+        }
+    } else {
+        for (IRBlock* target : targets) {
+            args.push_back(target->name());
+        }
+    }
+
+    for (int i = 0; i < (int)args.size(); i++) {
+        out << (i == 0 ? " " : ", ") << args[i];
+    }
+    return out.str();
+}
+
+IRInstr* IRBlock::terminator() const {
+    if (instrs.empty() || !instrs.back()->isTerminator()) {
+        return nullptr;
+    }
+    return instrs.back();
+}
+
+std::vector<IRBlock*> IRBlock::successors() const {
+    std::vector<IRBlock*> result;
+    IRInstr* last = terminator();
+    if (last != nullptr) {
+        for (IRBlock* target : last->targets) {
+            if (std::find(result.begin(), result.end(), target) == result.end()) {
+                result.push_back(target);
+            }
+        }
+    }
+    return result;
+}
+
+int IRBlock::predIndex(IRBlock* pred) const {
+    return std::find(preds.begin(), preds.end(), pred) - preds.begin();
+}
+
+void IRBlock::append(IRInstr* instr) {
+    instr->block = this;
+    instrs.push_back(instr);
+}
+
+void IRBlock::insertAfterPhis(IRInstr* instr) {
+    instr->block = this;
+    auto it = instrs.begin();
+    while (it != instrs.end() && (*it)->op == IROp::PHI) {
+        it++;
+    }
+    instrs.insert(it, instr);
+}
+
+void IRBlock::insertBeforeTerminator(IRInstr* instr) {
+    instr->block = this;
+    instrs.insert(terminator() == nullptr ? instrs.end() : instrs.end() - 1, instr);
+}
+
+void IRBlock::remove(IRInstr* instr) {
+    instrs.erase(std::find(instrs.begin(), instrs.end(), instr));
+    instr->block = nullptr;
+}
+
+std::string IRBlock::name() const {
+    return "bb" + std::to_string(id);
+}
+
+bool IRFunction::dump = false;
+
+IRFunction::~IRFunction() {
+    for (IRBlock* block : blocks) {
+        for (IRInstr* instr : block->instrs) {
+            delete instr;
+        }
+        delete block;
+    }
+}
+
+IRBlock* IRFunction::newBlock() {
+    IRBlock* block = new IRBlock();
+    block->id = nextBlockId++;
+    blocks.push_back(block);
+    return block;
+}
+
+IRInstr* IRFunction::newInstr(IROp op, IRType type) {
+    IRInstr* instr = new IRInstr(op, type);
+    instr->id = nextValueId++;
+    return instr;
+}
+
+int IRFunction::newSlot(int bytes) {
+    slots.push_back(bytes);
+    return (int)slots.size() - 1;
+}
+
+std::vector<IRBlock*> IRFunction::takeBlocks(IRFunction* other) {
+    int firstSlot = (int)slots.size();
+    slots.insert(slots.end(), other->slots.begin(), other->slots.end());
+    for (IRBlock* block : other->blocks) {
+        block->id = nextBlockId++;
+        for (IRInstr* instr : block->instrs) {
+            instr->id = nextValueId++;
+            if (instr->op == IROp::SLOT) {
+                instr->imm += firstSlot;
+            }
+        }
+    }
+    std::vector<IRBlock*> taken = other->blocks;
+    other->blocks.clear();
+    other->slots.clear();
+    return taken;
+}
+
+void IRFunction::addEdge(IRBlock* from, IRBlock* to) {
+    if (to->predIndex(from) == (int)to->preds.size()) {
+        to->preds.push_back(from);
+    }
+}
+
+void IRFunction::removeEdge(IRBlock* from, IRBlock* to) {
+    int index = to->predIndex(from);
+    if (index == (int)to->preds.size()) {
+        return;
+    }
+    to->preds.erase(to->preds.begin() + index);
+    for (IRInstr* instr : to->instrs) {
+        if (instr->op == IROp::PHI && index < (int)instr->operands.size()) {
+            instr->removeOperand(index);
+        }
+    }
+}
+
+void IRFunction::removeUnreachableBlocks() {
+    std::set<IRBlock*> reachable = {blocks[0]};
+    std::vector<IRBlock*> worklist = {blocks[0]};
+    while (!worklist.empty()) {
+        IRBlock* block = worklist.back();
+        worklist.pop_back();
+        for (IRBlock* successor : block->successors()) {
+            if (reachable.insert(successor).second) {
+                worklist.push_back(successor);
+            }
+        }
+    }
+
+    std::vector<IRBlock*> unreachable;
+    for (IRBlock* block : blocks) {
+        if (reachable.count(block) == 0) {
+            unreachable.push_back(block);
+            for (IRBlock* successor : block->successors()) {
+                removeEdge(block, successor);
+            }
+        }
+    }
+    // values of unreachable blocks are only used by other unreachable blocks
+    for (IRBlock* block : unreachable) {
+        for (IRInstr* instr : block->instrs) {
+            instr->dropOperands();
+        }
+    }
+    for (IRBlock* block : unreachable) {
+        for (IRInstr* instr : block->instrs) {
+            delete instr;
+        }
+        blocks.erase(std::find(blocks.begin(), blocks.end(), block));
+        delete block;
+    }
+}
+
+void IRFunction::splitCriticalEdges() {
+    std::vector<IRBlock*> original = blocks;
+    for (IRBlock* block : original) {
+        if (block->preds.size() < 2 || block->instrs.empty() || block->instrs[0]->op != IROp::PHI) {
+            continue;
+        }
+        for (int i = 0; i < (int)block->preds.size(); i++) {
+            IRBlock* pred = block->preds[i];
+            if (pred->successors().size() < 2) {
+                continue;
+            }
+
+            // the new block goes between them if the predecessor fell through, at the end otherwise
+            IRBlock* split = newBlock();
+            blocks.pop_back();
+            auto position = std::find(blocks.begin(), blocks.end(), block);
+            if (position != blocks.begin() && *(position - 1) == pred) {
+                blocks.insert(position, split);
+            } else {
+                blocks.push_back(split);
+            }
+
+            for (IRBlock*& target : pred->terminator()->targets) {
+                if (target == block) {
+                    target = split;
+                }
+            }
+            block->preds[i] = split;
+            split->preds.push_back(pred);
+            IRInstr* jump = newInstr(IROp::JUMP, IRType::VOID);
+            jump->targets.push_back(block);
+            split->append(jump);
+        }
+    }
+}
+
+void IRFunction::erase(IRInstr* instr) {
+    IRBlock* block = instr->block;
+    block->instrs.erase(std::find(block->instrs.begin(), block->instrs.end(), instr));
+    instr->dropOperands();
+    delete instr;
+}
+
+void IRFunction::print(std::ostream &out) const {
+    out << "function " << name << "(";
+    for (int i = 0; i < (int)paramTypes.size(); i++) {
+        out << (i == 0 ? "" : ", ") << typeName(paramTypes[i]);
+    }
+    out << ") -> " << typeName(returnType) << std::endl;
+    for (IRBlock* block : blocks) {
+        out << block->name() << ":";
+        if (!block->preds.empty()) {
+            out << " ; preds";
+            for (IRBlock* pred : block->preds) {
+                out << " " << pred->name();
+            }
+        }
+        out << std::endl;
+        for (IRInstr* instr : block->instrs) {
+            out << "    " << instr->toString() << std::endl;
+        }
+    }
+}
+
+IRBuilder::IRBuilder(IRFunction* _fn, Frame* _fnFrame):
+    fn(_fn),
+    fnFrame(_fnFrame)
+{
+    current = fn->newBlock();
+    layout.push_back(current);
+    sealBlock(current);
+}
+
+IRBuilder::~IRBuilder() {
+    for (IRInstr* phi : removedPhis) {
+        delete phi;
+    }
+}
+
+IRBlock* IRBuilder::block() const {
+    return current;
+}
+
+void IRBuilder::setBlock(IRBlock* block) {
+    current = block;
+    if (!isStarted(block)) {
+        layout.push_back(block);
+    }
+}
+
+bool IRBuilder::isTerminated() const {
+    return current->terminator() != nullptr;
+}
+
+int IRBuilder::layoutPosition() const {
+    return (int)layout.size();
+}
+
+void IRBuilder::rotateLayout(int first, int middle) {
+    std::rotate(layout.begin() + first, layout.begin() + middle, layout.end());
+}
+
+bool IRBuilder::isStarted(IRBlock* block) const {
+    return std::find(layout.begin(), layout.end(), block) != layout.end();
+}
+
+IRInstr* IRBuilder::emit(IROp op, IRType type, const std::vector<IRInstr*>& operands) {
+    if (isTerminated()) {
+        setBlock(fn->newBlock());
+        sealBlock(current);
+    }
+    IRInstr* instr = fn->newInstr(op, type);
+    for (IRInstr* operand : operands) {
+        instr->addOperand(operand);
+    }
+    current->append(instr);
+    return instr;
+}
+
+IRInstr* IRBuilder::constant(int value) {
+    IRInstr* instr = emit(IROp::CONST, IRType::WORD);
+    instr->imm = value;
+    return instr;
+}
+
+IRInstr* IRBuilder::constant(IRType type, double value) {
+    if (type == IRType::WORD) {
+        return constant((int)value);
+    }
+    IRInstr* instr = emit(IROp::CONST, type);
+    instr->fimm = value;
+    return instr;
+}
+
+bool foldConstants(IROp op, int left, int right, int &result) {
+    uint32_t a = left, b = right;
+    // division is left to run time, the divisor could be 0
+    switch (op) {
+        case IROp::ADD:  result = a + b; break;
+        case IROp::SUB:  result = a - b; break;
+        case IROp::MUL:  result = a * b; break;
+        case IROp::AND:  result = a & b; break;
+        case IROp::OR:   result = a | b; break;
+        case IROp::XOR:  result = a ^ b; break;
+        case IROp::SHL:  result = a << (b & 31); break;
+        case IROp::SHR:  result = (int)a >> (b & 31); break;
+        case IROp::SHRU: result = a >> (b & 31); break;
+        case IROp::SEQ:  result = a == b; break;
+        case IROp::SNE:  result = a != b; break;
+        case IROp::SLT:  result = (int)a < (int)b; break;
+        case IROp::SLE:  result = (int)a <= (int)b; break;
+        case IROp::SGT:  result = (int)a > (int)b; break;
+        case IROp::SGE:  result = (int)a >= (int)b; break;
+        case IROp::SLTU: result = a < b; break;
+        case IROp::SLEU: result = a <= b; break;
+        case IROp::SGTU: result = a > b; break;
+        case IROp::SGEU: result = a >= b; break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+IRInstr* IRBuilder::binary(IROp op, IRType type, IRInstr* left, IRInstr* right) {
+    if (left->op == IROp::CONST && right->op != IROp::CONST) {
+        switch (op) {
+            case IROp::ADD: case IROp::MUL: case IROp::AND: case IROp::OR: case IROp::XOR: case IROp::SEQ: case IROp::SNE:
+                std::swap(left, right);
+                break;
+            case IROp::SLT: op = IROp::SGT; std::swap(left, right); break;
+            case IROp::SGT: op = IROp::SLT; std::swap(left, right); break;
+            case IROp::SLE: op = IROp::SGE; std::swap(left, right); break;
+            case IROp::SGE: op = IROp::SLE; std::swap(left, right); break;
+            case IROp::SLTU: op = IROp::SGTU; std::swap(left, right); break;
+            case IROp::SGTU: op = IROp::SLTU; std::swap(left, right); break;
+            case IROp::SLEU: op = IROp::SGEU; std::swap(left, right); break;
+            case IROp::SGEU: op = IROp::SLEU; std::swap(left, right); break;
+            default:
+                break;
+        }
+    }
+
+    if (type == IRType::WORD && right->isConstant()) {
+        int value;
+        if (left->isConstant() && foldConstants(op, left->imm, right->imm, value)) {
+            return constant(value);
+        }
+        uint32_t b = right->imm;
+        bool identity = b == 0 && (op == IROp::ADD || op == IROp::SUB || op == IROp::OR || op == IROp::XOR
+            || op == IROp::SHL || op == IROp::SHR || op == IROp::SHRU);
+        if (identity || (b == 1 && op == IROp::MUL)) {
+            return left;
+        }
+    }
+    return emit(op, type, {left, right});
+}
+
+IRInstr* IRBuilder::load(IRType type, IRInstr* address, bool isByte) {
+    IRInstr* instr = emit(IROp::LOAD, type, {address});
+    instr->isByte = isByte;
+    return instr;
+}
+
+void IRBuilder::store(IRInstr* value, IRInstr* address, bool isByte) {
+    IRInstr* instr = emit(IROp::STORE, IRType::VOID, {value, address});
+    instr->isByte = isByte;
+}
+
+IRInstr* IRBuilder::phi(IRType type, const std::vector<std::pair<IRBlock*, IRInstr*>>& incoming) {
+    IRInstr* instr = fn->newInstr(IROp::PHI, type);
+    for (IRBlock* pred : current->preds) {
+        for (const auto& value : incoming) {
+            if (value.first == pred) {
+                instr->addOperand(value.second);
+            }
+        }
+    }
+    current->insertAfterPhis(instr);
+    return instr;
+}
+
+void IRBuilder::jump(IRBlock* target) {
+    if (isTerminated()) {
+        return;
+    }
+    IRInstr* instr = emit(IROp::JUMP, IRType::VOID);
+    instr->targets.push_back(target);
+    fn->addEdge(current, target);
+}
+
+void IRBuilder::branch(IRInstr* cond, IRBlock* trueBlock, IRBlock* falseBlock) {
+    if (trueBlock == falseBlock || cond->isConstant()) {
+        jump(cond->isConstant(0) ? falseBlock : trueBlock);
+        return;
+    }
+    IRInstr* instr = emit(IROp::BRANCH, IRType::VOID, {cond});
+    instr->targets = {trueBlock, falseBlock};
+    fn->addEdge(current, trueBlock);
+    fn->addEdge(current, falseBlock);
+}
+
+void IRBuilder::ret(IRInstr* value) {
+    if (value == nullptr) {
+        emit(IROp::RET, IRType::VOID);
+    } else {
+        emit(IROp::RET, IRType::VOID, {value});
+    }
+}
+
+void IRBuilder::finish() {
+    // blocks that were never started can't be reached
+    for (IRBlock* block : fn->blocks) {
+        if (!isStarted(block)) {
+            layout.push_back(block);
+        }
+    }
+    fn->blocks = layout;
+    fn->removeUnreachableBlocks();
+
+    // a phi with a single operand is a copy of it
+    for (IRBlock* block : fn->blocks) {
+        std::vector<IRInstr*> copies;
+        for (IRInstr* instr : block->instrs) {
+            if (instr->op == IROp::PHI && instr->operands.size() == 1) {
+                copies.push_back(instr);
+            }
+        }
+        for (IRInstr* phi : copies) {
+            phi->replaceAllUsesWith(phi->operands[0]);
+            fn->erase(phi);
+        }
+    }
+}
+
+IRBuilder::Variable IRBuilder::resolve(Frame* frame, const std::string& name) {
+    return {frame->getVarFrame(name), name};
+}
+
+IRType IRBuilder::variableType(const Variable& variable) {
+    return irType(variable.first->getVarType(variable.second)->getTypeKind());
+}
+
+bool IRBuilder::isRegisterVariable(const Variable& variable) {
+    return variable.first != nullptr && !variable.first->isAddressTaken(variable.second);
+}
+
+IRInstr* IRBuilder::variableSlot(const Variable& variable) {
+    auto it = slots.find(variable);
+    if (it == slots.end()) {
+        AST* type = variable.first->getVarType(variable.second);
+        it = slots.insert({variable, fn->newSlot(type->getTypeKind() == TypeKind::CHAR ? 1 : type->getBytes())}).first;
+    }
+    IRInstr* slot = emit(IROp::SLOT, IRType::WORD);
+    slot->imm = it->second;
+    return slot;
+}
+
+IRInstr* IRBuilder::readVariable(Frame* frame, const std::string& name) {
+    Variable variable = resolve(frame, name);
+    TypeKind kind = frame->getVarType(name)->getTypeKind();
+    IRType type = irType(kind);
+    if (isRegisterVariable(variable)) {
+        return readVariable(variable, current);
+    }
+    return load(type, variableAddress(frame, name), kind == TypeKind::CHAR);
+}
+
+void IRBuilder::writeVariable(Frame* frame, const std::string& name, IRInstr* value) {
+    Variable variable = resolve(frame, name);
+    TypeKind kind = frame->getVarType(name)->getTypeKind();
+    irType(kind);
+    if (isRegisterVariable(variable)) {
+        if (kind == TypeKind::CHAR) {
+            value = emit(IROp::SEXT8, IRType::WORD, {value});
+        }
+        definitions[current][variable] = value;
+    } else {
+        store(value, variableAddress(frame, name), kind == TypeKind::CHAR);
+    }
+}
+
+IRInstr* IRBuilder::variableAddress(Frame* frame, const std::string& name) {
+    Variable variable = resolve(frame, name);
+    if (variable.first == nullptr) {
+        IRInstr* global = emit(IROp::GLOBAL, IRType::WORD);
+        global->name = name;
+        return global;
+    }
+    if (isRegisterVariable(variable)) {
+        throw IRUnsupported("IRBuilder: address of variable " + name + " held in a register.\n");
+    }
+    return variableSlot(variable);
+}
+
+IRInstr* IRBuilder::readVariable(const Variable& variable, IRBlock* block) {
+    auto it = definitions[block].find(variable);
+    if (it != definitions[block].end()) {
+        return it->second;
+    }
+    return readVariableRecursive(variable, block);
+}
+
+IRInstr* IRBuilder::readVariableRecursive(const Variable& variable, IRBlock* block) {
+    IRType type = variableType(variable);
+    IRInstr* value;
+    if (sealedBlocks.count(block) == 0) {
+        value = fn->newInstr(IROp::PHI, type);
+        block->insertAfterPhis(value);
+        incompletePhis[block][variable] = value;
+    } else if (block->preds.size() == 1) {
+        value = readVariable(variable, block->preds[0]);
+    } else if (block->preds.empty()) {
+        // read before the variable has been written
+        value = undefinedValue(type);
+    } else {
+        // the phi breaks cycles through loops
+        IRInstr* phi = fn->newInstr(IROp::PHI, type);
+        block->insertAfterPhis(phi);
+        definitions[block][variable] = phi;
+        value = addPhiOperands(variable, phi);
+    }
+    definitions[block][variable] = value;
+    return value;
+}
+
+IRInstr* IRBuilder::addPhiOperands(const Variable& variable, IRInstr* phi) {
+    for (IRBlock* pred : phi->block->preds) {
+        phi->addOperand(readVariable(variable, pred));
+    }
+    return removeTrivialPhi(phi);
+}
+
+IRInstr* IRBuilder::removeTrivialPhi(IRInstr* phi) {
+    IRInstr* same = nullptr;
+    for (IRInstr* operand : phi->operands) {
+        if (operand == same || operand == phi) {
+            continue;
+        }
+        if (same != nullptr) {
+            return phi;
+        }
+        same = operand;
+    }
+    if (same == nullptr) {
+        // only reachable through itself
+        same = undefinedValue(phi->type);
+    }
+
+    std::vector<IRInstr*> phiUsers;
+    for (IRInstr* user : phi->users) {
+        if (user != phi && user->op == IROp::PHI && std::find(phiUsers.begin(), phiUsers.end(), user) == phiUsers.end()) {
+            phiUsers.push_back(user);
+        }
+    }
+    phi->dropOperands();
+    phi->replaceAllUsesWith(same);
+    for (auto& blockDefinitions : definitions) {
+        for (auto& definition : blockDefinitions.second) {
+            if (definition.second == phi) {
+                definition.second = same;
+            }
+        }
+    }
+    phi->block->instrs.erase(std::find(phi->block->instrs.begin(), phi->block->instrs.end(), phi));
+    phi->block = nullptr;
+    removedPhis.push_back(phi);
+
+    // phis using this one may have become trivial too
+    for (IRInstr* user : phiUsers) {
+        if (user->block != nullptr) {
+            removeTrivialPhi(user);
+        }
+    }
+    return same;
+}
+
+IRInstr* IRBuilder::undefinedValue(IRType type) {
+    // any value will do, 0 is the cheapest
+    IRInstr* value = fn->newInstr(IROp::CONST, type);
+    IRBlock* entry = fn->blocks[0];
+    auto it = entry->instrs.begin();
+    while (it != entry->instrs.end() && (*it)->op == IROp::PARAM) {
+        it++;
+    }
+    value->block = entry;
+    entry->instrs.insert(it, value);
+    return value;
+}
+
+void IRBuilder::sealBlock(IRBlock* block) {
+    if (!sealedBlocks.insert(block).second) {
+        return;
+    }
+    std::map<Variable, IRInstr*> phis = incompletePhis[block];
+    incompletePhis.erase(block);
+    for (const auto& phi : phis) {
+        addPhiOperands(phi.first, phi.second);
+    }
+}
+
+IRUnsupported::IRUnsupported(const std::string& message):
+    std::runtime_error(message)
+{}
+
+IRType irType(TypeKind kind) {
+    switch (kind) {
+        case TypeKind::INT:
+        case TypeKind::UNSIGNED:
+        case TypeKind::CHAR:
+        case TypeKind::POINTER:
+            return IRType::WORD;
+        case TypeKind::FLOAT:
+            return IRType::FLOAT;
+        case TypeKind::DOUBLE:
+            return IRType::DOUBLE;
+        case TypeKind::VOID:
+            return IRType::VOID;
+        default:
+            throw IRUnsupported("irType: struct values are not supported.\n");
+    }
+}
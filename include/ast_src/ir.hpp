@@ -0,0 +1,276 @@
+#pragma once
+
+#include "ast.hpp"
+
+#include <set>
+
+/*
+    Intermediate representation between the AST and MIPS assembly.
+
+    A function is a control flow graph of basic blocks. Every block ends with exactly one
+    terminator (JUMP, BRANCH, SWITCH, RET or TAILCALL) and starts with its PHI instructions.
+    Values are in SSA form: an instruction is the value it produces and is used directly
+    by the instructions that read it.
+
+    Scalar locals whose address is never taken only exist as SSA values, all other
+    variables live in memory and are read and written with LOAD and STORE (see IRBuilder).
+    The AST is lowered to it by the lower methods of the nodes, and isel.hpp turns it into assembly.
+*/
+
+// WORD covers int, unsigned, char and pointers
+enum struct IRType {
+    VOID, WORD, FLOAT, DOUBLE
+};
+
+enum struct IROp {
+    CONST,      // imm for words, fimm for floating point
+    PARAM,      // parameter number imm, in argument order
+    ADD, SUB, MUL, DIV, DIVU, REM, REMU,
+    AND, OR, XOR, SHL, SHR, SHRU,
+    NEG, NOT,
+    // comparisons always produce a word (0 or 1), their operands can be floating point
+    SEQ, SNE, SLT, SLE, SGT, SGE,
+    SLTU, SLEU, SGTU, SGEU,
+    SEXT8,      // value truncated to a char
+    FBITS,      // bits of a float, most significant word of a double
+    SLOT,       // address of stack slot imm
+    GLOBAL,     // address of the global variable name
+    STRING,     // address of a string constant with the text name
+    LOAD,       // from operand 0 + imm, a single byte if isByte
+    STORE,      // operand 0 to operand 1 + imm
+    CALL,       // of the function name, the operands are the arguments
+    PHI,        // one operand per predecessor of the block, in the same order
+    JUMP,       // to targets[0]
+    BRANCH,     // to targets[0] if operand 0 is not 0, to targets[1] otherwise
+    SWITCH,     // to targets[i + 1] if operand 0 is caseValues[i], to targets[0] otherwise
+    RET,        // returns operand 0 if there is one
+    TAILCALL    // call whose value is returned by the function
+};
+
+class IRBlock;
+
+class IRInstr
+{
+public:
+    IROp op;
+    IRType type;
+
+    // number used when printing
+    int id = 0;
+    IRBlock* block = nullptr;
+
+    std::vector<IRInstr*> operands;
+    // every instruction reading this value, once per operand
+    std::vector<IRInstr*> users;
+
+    int imm = 0;
+    double fimm = 0;
+    std::string name;
+    bool isByte = false;
+
+    std::vector<IRBlock*> targets;
+    std::vector<int> caseValues;
+
+    IRInstr(IROp _op, IRType _type);
+
+    bool isTerminator() const;
+    bool isCompare() const;
+    // instructions that have to be kept even if their value is not used
+    bool hasSideEffects() const;
+    bool isConstant() const;
+    bool isConstant(int value) const;
+
+    void addOperand(IRInstr* value);
+    void setOperand(int i, IRInstr* value);
+    void removeOperand(int i);
+    void dropOperands();
+    // every user of this value reads value instead
+    void replaceAllUsesWith(IRInstr* value);
+
+    std::string toString() const;
+};
+
+class IRBlock
+{
+public:
+    int id = 0;
+    std::vector<IRInstr*> instrs;
+    // blocks that can jump here, each one only once
+    std::vector<IRBlock*> preds;
+
+    // nullptr if the block doesn't end with a terminator yet
+    IRInstr* terminator() const;
+    // each block only once
+    std::vector<IRBlock*> successors() const;
+    int predIndex(IRBlock* pred) const;
+
+    void append(IRInstr* instr);
+    // before the first instruction that isn't a phi
+    void insertAfterPhis(IRInstr* instr);
+    void insertBeforeTerminator(IRInstr* instr);
+    // takes the instruction out of the block without deleting it, to move it somewhere else
+    void remove(IRInstr* instr);
+
+    std::string name() const;
+};
+
+class IRFunction
+{
+private:
+    int nextValueId = 0;
+    int nextBlockId = 0;
+
+public:
+    std::string name;
+    IRType returnType = IRType::WORD;
+    std::vector<IRType> paramTypes;
+
+    // in layout order, the first block is the entry
+    std::vector<IRBlock*> blocks;
+    // sizes of the stack slots in bytes
+    std::vector<int> slots;
+    // frame of the body, the functions it calls are looked up from it
+    Frame* frame = nullptr;
+
+    // writes the IR of every function to stderr (-fdump-ir)
+    static bool dump;
+
+    ~IRFunction();
+
+    IRBlock* newBlock();
+    IRInstr* newInstr(IROp op, IRType type);
+    int newSlot(int bytes);
+
+    /*
+        Moves the blocks of other into this function without laying them out, numbering them and their
+        instructions like the ones created here. Its stack slots are added to the ones of this function.
+    */
+    std::vector<IRBlock*> takeBlocks(IRFunction* other);
+
+    // update the preds of to, removing an edge also removes the operands of the phis for it
+    void addEdge(IRBlock* from, IRBlock* to);
+    void removeEdge(IRBlock* from, IRBlock* to);
+
+    // blocks the entry can't reach are deleted, unused instructions are not
+    void removeUnreachableBlocks();
+
+    /*
+        An edge from a block with several successors to one with several predecessors gets
+        a block of its own, so there is always a place for the moves of the phis on that edge.
+    */
+    void splitCriticalEdges();
+
+    // removes the instruction from its block and deletes it, its value must not be used anymore
+    void erase(IRInstr* instr);
+
+    void print(std::ostream &out) const;
+};
+
+/*
+    Lowering of the AST of a function into IR.
+
+    Reads and writes of variables are turned into SSA values as they are lowered
+    (Braun et al., "Simple and Efficient Construction of Static Single Assignment Form").
+    The value of a variable at the end of each block is recorded, blocks whose predecessors are
+    not all known yet (the start of loops) are not sealed and get their phis completed once they are.
+*/
+class IRBuilder
+{
+private:
+    typedef std::pair<Frame*, std::string> Variable;
+
+    IRBlock* current = nullptr;
+    // blocks in the order they were started in, this becomes the layout of the function
+    std::vector<IRBlock*> layout;
+
+    std::map<IRBlock*, std::map<Variable, IRInstr*>> definitions;
+    std::map<IRBlock*, std::map<Variable, IRInstr*>> incompletePhis;
+    std::set<IRBlock*> sealedBlocks;
+    // stack slots of the variables that live in memory
+    std::map<Variable, int> slots;
+
+    Variable resolve(Frame* frame, const std::string& name);
+    IRType variableType(const Variable& variable);
+    bool isRegisterVariable(const Variable& variable);
+    IRInstr* variableSlot(const Variable& variable);
+
+    IRInstr* readVariable(const Variable& variable, IRBlock* block);
+    IRInstr* readVariableRecursive(const Variable& variable, IRBlock* block);
+    IRInstr* addPhiOperands(const Variable& variable, IRInstr* phi);
+    IRInstr* removeTrivialPhi(IRInstr* phi);
+    IRInstr* undefinedValue(IRType type);
+
+    // deleted with the builder since they can still be on the worklist of removeTrivialPhi
+    std::vector<IRInstr*> removedPhis;
+
+public:
+    IRFunction* fn;
+    Frame* fnFrame;
+
+    // targets of break and continue, innermost last
+    std::vector<IRBlock*> breakTargets;
+    std::vector<IRBlock*> continueTargets;
+    // blocks of the cases of the switch statements, by the label of the case
+    std::map<std::string, IRBlock*> caseBlocks;
+    // start of the function after the parameters, for self recursive tail calls
+    IRBlock* tailCallTarget = nullptr;
+
+    IRBuilder(IRFunction* _fn, Frame* _fnFrame);
+    ~IRBuilder();
+
+    IRBlock* block() const;
+    // continues in block, code after a terminator goes into a new block that can't be reached
+    void setBlock(IRBlock* block);
+    bool isTerminated() const;
+
+    /*
+        Blocks are laid out in the order they are started in.
+        rotateLayout moves the blocks started from position middle on before the ones
+        started from first on, loops use it to put their condition after the body.
+    */
+    int layoutPosition() const;
+    void rotateLayout(int first, int middle);
+    bool isStarted(IRBlock* block) const;
+    // all predecessors of the block are known
+    void sealBlock(IRBlock* block);
+
+    IRInstr* emit(IROp op, IRType type, const std::vector<IRInstr*>& operands = {});
+    IRInstr* constant(int value);
+    IRInstr* constant(IRType type, double value);
+    // constants go on the right of commutative operations, operations on two constants are folded
+    IRInstr* binary(IROp op, IRType type, IRInstr* left, IRInstr* right);
+    IRInstr* load(IRType type, IRInstr* address, bool isByte);
+    void store(IRInstr* value, IRInstr* address, bool isByte);
+    // values in the order of the predecessors given with them
+    IRInstr* phi(IRType type, const std::vector<std::pair<IRBlock*, IRInstr*>>& incoming);
+
+    // nothing is added after a terminator, the jump could never be taken
+    void jump(IRBlock* target);
+    void branch(IRInstr* cond, IRBlock* trueBlock, IRBlock* falseBlock);
+    void ret(IRInstr* value);
+
+    // lays out the blocks and removes the ones that can't be reached
+    void finish();
+
+    // variables as seen from frame
+    IRInstr* readVariable(Frame* frame, const std::string& name);
+    void writeVariable(Frame* frame, const std::string& name, IRInstr* value);
+    IRInstr* variableAddress(Frame* frame, const std::string& name);
+};
+
+/*
+    Thrown while lowering constructs the IR doesn't handle.
+    The function is then compiled directly from the AST.
+*/
+class IRUnsupported
+    : public std::runtime_error
+{
+public:
+    IRUnsupported(const std::string& message);
+};
+
+// op applied to two word constants, false if it is left to run time
+bool foldConstants(IROp op, int left, int right, int &result);
+
+// IR type of values of a C type
+IRType irType(TypeKind kind);
@@ -0,0 +1,1313 @@
+#include "isel.hpp"
+#include "optimise.hpp"
+#include "pipeline.hpp"
+
+#include <cmath>
+#include <iomanip>
+
+// registers handed out to values, in order of preference
+static const std::vector<std::string> callerSavedRegs = {
+    "$t0", "$t1", "$t2", "$t3", "$t4", "$t5", "$t7", "$v1", "$a3", "$a2", "$a1", "$a0"
+};
+static const std::vector<std::string> calleeSavedRegs = {
+    "$s0", "$s1", "$s2", "$s3", "$s4", "$s5", "$s6", "$s7"
+};
+static const std::vector<std::string> callerSavedFloatRegs = {
+    "$f4", "$f6", "$f8", "$f10", "$f14", "$f12"
+};
+static const std::vector<std::string> calleeSavedFloatRegs = {
+    "$f20", "$f22", "$f24", "$f26", "$f28", "$f30"
+};
+
+static bool fitsImmediate(IRInstr* value, int min, int max) {
+    return value->isConstant() && value->imm >= min && value->imm <= max;
+}
+
+static bool isMemory(const std::string &location) {
+    return location.back() == ')';
+}
+
+// location of the word at offset bytes after a location in the frame
+static std::string offsetBy(const std::string &location, int offset) {
+    return std::to_string(std::stoi(location) + offset) + "($sp)";
+}
+
+// odd register of a floating point pair, which holds the most significant word of a double
+static std::string oddReg(const std::string &reg) {
+    return "$f" + std::to_string(std::stoi(reg.substr(2)) + 1);
+}
+
+static std::string symbol(const std::string &name, int offset) {
+    if (offset == 0) {
+        return name;
+    }
+    return name + (offset > 0 ? "+" : "-") + std::to_string(std::abs(offset));
+}
+
+static TypeKind typeKind(IRType type) {
+    return type == IRType::FLOAT ? TypeKind::FLOAT : type == IRType::DOUBLE ? TypeKind::DOUBLE : TypeKind::INT;
+}
+
+static IROp invertCompare(IROp op) {
+    switch (op) {
+        case IROp::SEQ:  return IROp::SNE;
+        case IROp::SNE:  return IROp::SEQ;
+        case IROp::SLT:  return IROp::SGE;
+        case IROp::SGE:  return IROp::SLT;
+        case IROp::SLE:  return IROp::SGT;
+        case IROp::SGT:  return IROp::SLE;
+        case IROp::SLTU: return IROp::SGEU;
+        case IROp::SGEU: return IROp::SLTU;
+        case IROp::SLEU: return IROp::SGTU;
+        case IROp::SGTU: return IROp::SLEU;
+        default:
+            throw std::runtime_error("invertCompare: not a comparison.\n");
+    }
+}
+
+static bool isUnsignedCompare(IROp op) {
+    return op >= IROp::SLTU && op <= IROp::SGEU;
+}
+
+InstructionSelector::InstructionSelector(IRFunction* _fn):
+    fn(_fn)
+{}
+
+bool InstructionSelector::isFloat(IRType type) {
+    return type == IRType::FLOAT || type == IRType::DOUBLE;
+}
+
+bool InstructionSelector::isRematerialized(IRInstr* value) {
+    if (value->op == IROp::SLOT || fitsImmediate(value, -32768, 65535)) {
+        return true;
+    } else if (value->op != IROp::CONST && value->op != IROp::GLOBAL && value->op != IROp::STRING) {
+        return false;
+    }
+    // the others take several instructions, they are kept in a register if they were moved out of a loop
+    for (IRInstr* user : value->users) {
+        if (user->block != value->block) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool InstructionSelector::needsLocation(IRInstr* value) {
+    return live.count(value) != 0 && folded.count(value) == 0 && !isRematerialized(value) && value->type != IRType::VOID;
+}
+
+bool InstructionSelector::isEmitted(IRInstr* instr) {
+    return live.count(instr) != 0 && folded.count(instr) == 0 && !isRematerialized(instr)
+        && instr->op != IROp::PHI && instr->op != IROp::PARAM;
+}
+
+void InstructionSelector::emittedUses(IRInstr* instr, std::vector<IRInstr*> &uses) {
+    for (IRInstr* operand : instr->operands) {
+        if (folded.count(operand) != 0) {
+            emittedUses(operand, uses);
+        } else if (!isRematerialized(operand)) {
+            uses.push_back(operand);
+        }
+    }
+}
+
+void InstructionSelector::markLive() {
+    std::vector<IRInstr*> worklist;
+    for (IRBlock* block : fn->blocks) {
+        for (IRInstr* instr : block->instrs) {
+            if (instr->hasSideEffects() && live.insert(instr).second) {
+                worklist.push_back(instr);
+            }
+        }
+    }
+    while (!worklist.empty()) {
+        IRInstr* instr = worklist.back();
+        worklist.pop_back();
+        for (IRInstr* operand : instr->operands) {
+            if (live.insert(operand).second) {
+                worklist.push_back(operand);
+            }
+        }
+    }
+}
+
+void InstructionSelector::findFolded() {
+    for (IRBlock* block : fn->blocks) {
+        for (IRInstr* instr : block->instrs) {
+            if (live.count(instr) == 0 || instr->users.empty()) {
+                continue;
+            }
+
+            // the branch tests the comparison itself
+            if (instr->isCompare()) {
+                IRInstr* user = instr->users[0];
+                if (instr->users.size() == 1 && user->op == IROp::BRANCH && user->block == block) {
+                    folded.insert(instr);
+                }
+                continue;
+            }
+
+            // the constant becomes the offset of the loads and stores
+            if (instr->op == IROp::ADD && instr->type == IRType::WORD && fitsImmediate(instr->operands[1], -32768, 32767)) {
+                bool onlyAddress = true;
+                for (IRInstr* user : instr->users) {
+                    bool isAddress = (user->op == IROp::LOAD && user->operands[0] == instr)
+                        || (user->op == IROp::STORE && user->operands[1] == instr && user->operands[0] != instr);
+                    onlyAddress = onlyAddress && isAddress;
+                }
+                if (onlyAddress) {
+                    folded.insert(instr);
+                }
+            }
+        }
+    }
+}
+
+void InstructionSelector::computeIntervals() {
+    // every instruction has a position for reading its operands and one after it for its value
+    int position = 0;
+    for (IRBlock* block : fn->blocks) {
+        int from = position;
+        position += 2;
+        for (IRInstr* instr : block->instrs) {
+            if (instr->op == IROp::PHI) {
+                positions[instr] = from;
+            } else {
+                positions[instr] = position;
+                position += 2;
+                if (instr->op == IROp::CALL && live.count(instr) != 0) {
+                    callPositions.push_back(positions[instr]);
+                }
+            }
+        }
+        blockPositions[block] = {from, position};
+        position += 2;
+    }
+
+    // values defined and read in each block, phi operands are read at the end of the predecessor
+    std::map<IRBlock*, std::set<IRInstr*>> defs, uses, liveIn, liveOut;
+    for (IRBlock* block : fn->blocks) {
+        for (IRInstr* instr : block->instrs) {
+            if (isEmitted(instr)) {
+                std::vector<IRInstr*> instrUses;
+                emittedUses(instr, instrUses);
+                for (IRInstr* use : instrUses) {
+                    if (defs[block].count(use) == 0) {
+                        uses[block].insert(use);
+                    }
+                }
+            }
+            if (needsLocation(instr)) {
+                defs[block].insert(instr);
+            }
+        }
+        for (IRBlock* successor : block->successors()) {
+            for (IRInstr* phi : successor->instrs) {
+                if (phi->op == IROp::PHI && needsLocation(phi)) {
+                    IRInstr* operand = phi->operands[successor->predIndex(block)];
+                    if (needsLocation(operand)) {
+                        liveOut[block].insert(operand);
+                    }
+                }
+            }
+        }
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto it = fn->blocks.rbegin(); it != fn->blocks.rend(); it++) {
+            IRBlock* block = *it;
+            std::set<IRInstr*> out = liveOut[block];
+            for (IRBlock* successor : block->successors()) {
+                for (IRInstr* value : liveIn[successor]) {
+                    if (value->op != IROp::PHI || value->block != successor) {
+                        out.insert(value);
+                    }
+                }
+            }
+            std::set<IRInstr*> in = uses[block];
+            for (IRInstr* value : out) {
+                if (defs[block].count(value) == 0) {
+                    in.insert(value);
+                }
+            }
+            if (out != liveOut[block] || in != liveIn[block]) {
+                liveOut[block] = out;
+                liveIn[block] = in;
+                changed = true;
+            }
+        }
+    }
+
+    /*
+        Values get one range per block they are live in, so a value can share a register with
+        others in the holes of its lifetime. Values that leave a block only through a phi are read
+        by the moves at its end, the phi is written right after them.
+    */
+    std::map<IRInstr*, Interval> ranges;
+    int entry = blockPositions[fn->blocks[0]].first;
+    for (IRBlock* block : fn->blocks) {
+        int from = blockPositions[block].first;
+        int to = blockPositions[block].second;
+        std::map<IRInstr*, std::pair<int, int>> local;
+        auto touch = [&local](IRInstr* value, int position) {
+            auto it = local.find(value);
+            if (it == local.end()) {
+                local[value] = {position, position};
+            } else {
+                it->second.first = std::min(it->second.first, position);
+                it->second.second = std::max(it->second.second, position);
+            }
+        };
+
+        for (IRInstr* value : liveIn[block]) {
+            touch(value, from);
+        }
+        for (IRInstr* value : liveOut[block]) {
+            bool passesThrough = false;
+            for (IRBlock* successor : block->successors()) {
+                passesThrough = passesThrough || (liveIn[successor].count(value) != 0 && (value->op != IROp::PHI || value->block != successor));
+            }
+            touch(value, passesThrough ? to + 1 : to);
+        }
+        for (IRInstr* instr : block->instrs) {
+            int position = positions[instr];
+            if (isEmitted(instr)) {
+                std::vector<IRInstr*> instrUses;
+                emittedUses(instr, instrUses);
+                for (IRInstr* use : instrUses) {
+                    touch(use, position);
+                }
+            }
+            if (needsLocation(instr)) {
+                // parameters are all moved to their locations on entry
+                touch(instr, instr->op == IROp::PARAM ? entry : instr->op == IROp::PHI ? position : position + 1);
+            }
+        }
+
+        for (const auto& range : local) {
+            Interval &interval = ranges[range.first];
+            interval.value = range.first;
+            interval.ranges.push_back(range.second);
+        }
+        for (IRBlock* successor : block->successors()) {
+            for (IRInstr* phi : successor->instrs) {
+                if (phi->op == IROp::PHI && needsLocation(phi)) {
+                    Interval &interval = ranges[phi];
+                    interval.value = phi;
+                    interval.ranges.push_back({to + 1, to + 1});
+                }
+            }
+        }
+    }
+
+    for (auto& value : ranges) {
+        Interval &interval = value.second;
+        interval.start = interval.ranges.front().first;
+        interval.end = interval.ranges.front().second;
+        for (const std::pair<int, int> &range : interval.ranges) {
+            interval.start = std::min(interval.start, range.first);
+            interval.end = std::max(interval.end, range.second);
+            for (int call : callPositions) {
+                interval.crossesCall = interval.crossesCall || (range.first < call && range.second > call + 1);
+            }
+        }
+        intervals.push_back(interval);
+    }
+    std::sort(intervals.begin(), intervals.end(), [](const Interval &a, const Interval &b) {
+        return a.start != b.start ? a.start < b.start : a.value->id < b.value->id;
+    });
+}
+
+bool InstructionSelector::Interval::intersects(const Interval &other) const {
+    for (const std::pair<int, int> &range : ranges) {
+        for (const std::pair<int, int> &otherRange : other.ranges) {
+            if (range.first <= otherRange.second && otherRange.first <= range.second) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+std::string InstructionSelector::registerHint(IRInstr* value) {
+    // parameters stay in the register they are passed in
+    if (value->op == IROp::PARAM) {
+        std::vector<TypeKind> kinds;
+        for (IRType type : fn->paramTypes) {
+            kinds.push_back(typeKind(type));
+        }
+        std::vector<int> offsets;
+        std::vector<std::string> regs;
+        argumentLocations(kinds, offsets, regs);
+        std::string reg = regs[value->imm];
+        if (reg != "" && (reg[1] == 'f') == isFloat(value->type)) {
+            return reg;
+        }
+        return "";
+    }
+
+    // the moves of phis disappear if they are in the same register as their operands
+    for (IRInstr* user : value->users) {
+        auto it = locations.find(user);
+        if (user->op == IROp::PHI && it != locations.end() && !isMemory(it->second)) {
+            return it->second;
+        }
+    }
+    if (value->op == IROp::PHI) {
+        for (IRInstr* operand : value->operands) {
+            auto it = locations.find(operand);
+            if (it != locations.end() && !isMemory(it->second)) {
+                return it->second;
+            }
+        }
+    }
+
+    // arguments are computed into their argument register
+    if (value->users.size() == 1 && (value->users[0]->op == IROp::CALL || value->users[0]->op == IROp::TAILCALL)) {
+        IRInstr* call = value->users[0];
+        std::vector<TypeKind> kinds;
+        for (IRInstr* operand : call->operands) {
+            kinds.push_back(typeKind(operand->type));
+        }
+        std::vector<int> offsets;
+        std::vector<std::string> regs;
+        argumentLocations(kinds, offsets, regs);
+        int i = std::find(call->operands.begin(), call->operands.end(), value) - call->operands.begin();
+        if (regs[i] != "" && (regs[i][1] == 'f') == isFloat(value->type)) {
+            return regs[i];
+        }
+    }
+    return "";
+}
+
+void InstructionSelector::allocateRegisters() {
+    // values given each register so far
+    std::map<std::string, std::vector<Interval*>> assigned;
+    auto conflicts = [&assigned](const std::string &reg, const Interval &interval) {
+        std::vector<Interval*> result;
+        for (Interval* other : assigned[reg]) {
+            if (other->intersects(interval)) {
+                result.push_back(other);
+            }
+        }
+        return result;
+    };
+
+    for (Interval &interval : intervals) {
+        bool isFloatValue = isFloat(interval.value->type);
+        std::vector<std::string> candidates = isFloatValue ? calleeSavedFloatRegs : calleeSavedRegs;
+        if (!interval.crossesCall) {
+            const std::vector<std::string> &callerSaved = isFloatValue ? callerSavedFloatRegs : callerSavedRegs;
+            candidates.insert(candidates.begin(), callerSaved.begin(), callerSaved.end());
+        }
+
+        std::string reg;
+        std::string hint = registerHint(interval.value);
+        if (hint != "" && std::find(candidates.begin(), candidates.end(), hint) != candidates.end() && conflicts(hint, interval).empty()) {
+            reg = hint;
+        }
+        for (const std::string &candidate : candidates) {
+            if (reg == "" && conflicts(candidate, interval).empty()) {
+                reg = candidate;
+            }
+        }
+
+        if (reg == "") {
+            // the value that stays live the longest goes to the frame
+            Interval* victim = nullptr;
+            for (const std::string &candidate : candidates) {
+                std::vector<Interval*> others = conflicts(candidate, interval);
+                if (others.size() == 1 && others[0]->end > interval.end && (victim == nullptr || others[0]->end > victim->end)) {
+                    victim = others[0];
+                    reg = candidate;
+                }
+            }
+            if (victim == nullptr) {
+                spills[interval.value] = (int)spills.size();
+                continue;
+            }
+            spills[victim->value] = (int)spills.size();
+            locations.erase(victim->value);
+            std::vector<Interval*> &others = assigned[reg];
+            others.erase(std::find(others.begin(), others.end(), victim));
+        }
+
+        locations[interval.value] = reg;
+        assigned[reg].push_back(&interval);
+        if (std::find(calleeSavedRegs.begin(), calleeSavedRegs.end(), reg) != calleeSavedRegs.end()
+            || std::find(calleeSavedFloatRegs.begin(), calleeSavedFloatRegs.end(), reg) != calleeSavedFloatRegs.end()) {
+            usedCalleeSaved.insert(reg);
+        }
+    }
+}
+
+void InstructionSelector::layoutFrame() {
+    for (IRBlock* block : fn->blocks) {
+        for (IRInstr* instr : block->instrs) {
+            if (instr->op == IROp::CALL && live.count(instr) != 0) {
+                hasCalls = true;
+                std::vector<TypeKind> kinds;
+                for (IRInstr* operand : instr->operands) {
+                    kinds.push_back(typeKind(operand->type));
+                }
+                std::vector<int> offsets;
+                std::vector<std::string> regs;
+                outgoingSize = std::max(outgoingSize, argumentLocations(kinds, offsets, regs));
+            }
+        }
+    }
+
+    int offset = outgoingSize;
+    for (int bytes : fn->slots) {
+        int alignment = bytes >= 8 ? 8 : 4;
+        offset = (offset + alignment - 1) / alignment * alignment;
+        slotOffsets.push_back(offset);
+        offset += (bytes + 3) / 4 * 4;
+    }
+    offset = (offset + 7) / 8 * 8;
+    for (const auto& spill : spills) {
+        locations[spill.first] = std::to_string(offset + 8 * spill.second) + "($sp)";
+    }
+    offset += 8 * spills.size();
+
+    // floating point registers are saved as pairs
+    for (const std::string &reg : usedCalleeSaved) {
+        if (reg[1] == 'f') {
+            savedRegisters.push_back({reg, offset});
+            offset += 8;
+        }
+    }
+    int intSaved = 0;
+    for (const std::string &reg : usedCalleeSaved) {
+        intSaved += reg[1] == 's';
+    }
+    frameSize = (offset + 4 * intSaved + (hasCalls ? 4 : 0) + 7) / 8 * 8;
+
+    // $31 at the top, then the highest registers first
+    int top = frameSize - (hasCalls ? 8 : 4);
+    for (auto it = usedCalleeSaved.rbegin(); it != usedCalleeSaved.rend(); it++) {
+        if ((*it)[1] == 's') {
+            savedRegisters.push_back({*it, top});
+            top -= 4;
+        }
+    }
+}
+
+std::string InstructionSelector::scratchReg(IRType type, int i) {
+    if (isFloat(type)) {
+        return i == 0 ? "$f16" : "$f18";
+    }
+    return i == 0 ? "$t8" : "$t9";
+}
+
+std::string InstructionSelector::use(IRInstr* value, int scratch) {
+    if (value->isConstant(0)) {
+        return "$0";
+    }
+    std::string reg = scratchReg(value->type, scratch);
+    if (isRematerialized(value)) {
+        materialize(value, reg);
+        return reg;
+    }
+    const std::string &location = locations.at(value);
+    if (isMemory(location)) {
+        copy(value->type, reg, location);
+        return reg;
+    }
+    return location;
+}
+
+std::string InstructionSelector::target(IRInstr* instr) {
+    const std::string &location = locations.at(instr);
+    return isMemory(location) ? scratchReg(instr->type, 0) : location;
+}
+
+void InstructionSelector::define(IRInstr* instr, const std::string &reg) {
+    const std::string &location = locations.at(instr);
+    if (isMemory(location)) {
+        copy(instr->type, location, reg);
+    }
+}
+
+std::string InstructionSelector::address(IRInstr* pointer, int offset, const std::string &scratch) {
+    if (pointer->op == IROp::SLOT) {
+        return std::to_string(slotOffsets[pointer->imm] + offset) + "($sp)";
+    } else if (pointer->op == IROp::GLOBAL && isRematerialized(pointer)) {
+        *out << "lui " << scratch << ", %hi(" << symbol(pointer->name, offset) << ")" << std::endl;
+        return "%lo(" + symbol(pointer->name, offset) + ")(" + scratch + ")";
+    } else if (folded.count(pointer) != 0) {
+        return address(pointer->operands[0], offset + pointer->operands[1]->imm, scratch);
+    }
+    std::string base = use(pointer, scratch == "$t8" ? 0 : 1);
+    return std::to_string(offset) + "(" + base + ")";
+}
+
+void InstructionSelector::materialize(IRInstr* value, const std::string &reg) {
+    switch (value->op) {
+        case IROp::CONST:
+            if (value->type == IRType::WORD) {
+                if (value->imm == 0) {
+                    *out << "move " << reg << ", $0" << std::endl;
+                } else {
+                    *out << "li " << reg << ", " << value->imm << std::endl;
+                }
+            } else if (value->fimm == 0 && !std::signbit(value->fimm)) {
+                *out << "mtc1 $0, " << reg << std::endl;
+                if (value->type == IRType::DOUBLE) {
+                    *out << "mtc1 $0, " << oddReg(reg) << std::endl;
+                }
+            } else {
+                std::stringstream literal;
+                literal << std::showpoint << std::setprecision(value->type == IRType::FLOAT ? 9 : 17) << value->fimm;
+                *out << (value->type == IRType::FLOAT ? "li.s " : "li.d ") << reg << ", " << literal.str() << std::endl;
+            }
+            break;
+        case IROp::SLOT:
+            *out << "addiu " << reg << ", $sp, " << slotOffsets[value->imm] << std::endl;
+            break;
+        case IROp::GLOBAL:
+            *out << "lui " << reg << ", %hi(" << value->name << ")" << std::endl;
+            *out << "addiu " << reg << ", " << reg << ", %lo(" << value->name << ")" << std::endl;
+            break;
+        case IROp::STRING:
+        {
+            // the text is emitted once, the first time it is needed
+            auto it = stringLabels.find(value);
+            if (it == stringLabels.end()) {
+                it = stringLabels.insert({value, generateUniqueLabel("$LC")}).first;
+                *out << ".rdata" << std::endl;
+                *out << ".align 2" << std::endl;
+                *out << it->second << ":" << std::endl;
+                *out << ".ascii \"" << value->name << "\"" << std::endl;
+                *out << ".text" << std::endl;
+                *out << ".align 2" << std::endl;
+            }
+            *out << "lui " << reg << ", %hi(" << it->second << ")" << std::endl;
+            *out << "addiu " << reg << ", " << reg << ", %lo(" << it->second << ")" << std::endl;
+            break;
+        }
+        default:
+            throw std::runtime_error("InstructionSelector: can't rematerialize " + value->toString() + ".\n");
+    }
+}
+
+void InstructionSelector::copy(IRType type, const std::string &dst, const std::string &src) {
+    if (dst == src) {
+        return;
+    }
+    std::string suffix = type == IRType::FLOAT ? ".s " : type == IRType::DOUBLE ? ".d " : " ";
+    // floats passed in integer registers
+    bool intDst = !isMemory(dst) && dst[1] != 'f';
+    bool intSrc = !isMemory(src) && src[1] != 'f';
+    if (type == IRType::FLOAT && (intDst || intSrc)) {
+        type = IRType::WORD;
+        if (!isMemory(dst) && !isMemory(src)) {
+            *out << (intDst ? "mfc1 " + dst + ", " + src : "mtc1 " + src + ", " + dst) << std::endl;
+            return;
+        }
+    }
+    if (isMemory(dst) && isMemory(src)) {
+        std::string reg = scratchReg(type, 0);
+        copy(type, reg, src);
+        copy(type, dst, reg);
+    } else if (isMemory(dst)) {
+        *out << (isFloat(type) ? "s" + suffix : "sw ") << src << ", " << dst << std::endl;
+    } else if (isMemory(src)) {
+        *out << (isFloat(type) ? "l" + suffix : "lw ") << dst << ", " << src << std::endl;
+    } else {
+        *out << (isFloat(type) ? "mov" + suffix : "move ") << dst << ", " << src << std::endl;
+    }
+}
+
+InstructionSelector::Move InstructionSelector::moveFrom(IRInstr* value, const std::string &dst) {
+    Move move;
+    move.type = value->type;
+    move.dst = dst;
+    if (isRematerialized(value)) {
+        move.value = value;
+    } else {
+        move.src = locations.at(value);
+    }
+    return move;
+}
+
+void InstructionSelector::emitMove(const Move &move) {
+    if (move.value != nullptr) {
+        // doubles go through a floating point register before being split
+        bool direct = !isMemory(move.dst) && move.dst2 == "" && isFloat(move.type) == (move.dst[1] == 'f');
+        std::string reg = direct ? move.dst : scratchReg(move.type, 0);
+        materialize(move.value, reg);
+        if (move.dst2 != "") {
+            *out << "mfc1 " << move.dst << ", " << oddReg(reg) << std::endl;
+            *out << "mfc1 " << move.dst2 << ", " << reg << std::endl;
+        } else if (!direct) {
+            copy(move.type, move.dst, reg);
+        }
+    } else if (move.src2 != "") {
+        if (isMemory(move.dst)) {
+            *out << "sw " << move.src << ", " << move.dst << std::endl;
+            *out << "sw " << move.src2 << ", " << offsetBy(move.dst, 4) << std::endl;
+        } else {
+            *out << "mtc1 " << move.src << ", " << oddReg(move.dst) << std::endl;
+            *out << "mtc1 " << move.src2 << ", " << move.dst << std::endl;
+        }
+    } else if (move.dst2 != "") {
+        if (isMemory(move.src)) {
+            *out << "lw " << move.dst << ", " << move.src << std::endl;
+            *out << "lw " << move.dst2 << ", " << offsetBy(move.src, 4) << std::endl;
+        } else {
+            *out << "mfc1 " << move.dst << ", " << oddReg(move.src) << std::endl;
+            *out << "mfc1 " << move.dst2 << ", " << move.src << std::endl;
+        }
+    } else {
+        copy(move.type, move.dst, move.src);
+    }
+}
+
+void InstructionSelector::parallelMove(std::vector<Move> moves) {
+    auto reads = [](const Move &move, const std::string &location) {
+        return move.value == nullptr && location != "" && (move.src == location || move.src2 == location);
+    };
+    moves.erase(std::remove_if(moves.begin(), moves.end(), [](const Move &move) {
+        return move.value == nullptr && move.dst2 == "" && move.src2 == "" && move.dst == move.src;
+    }), moves.end());
+
+    while (!moves.empty()) {
+        // a move can be done once no other move still needs the value it overwrites
+        bool progress = false;
+        for (int i = 0; i < (int)moves.size() && !progress; i++) {
+            bool blocked = false;
+            for (int j = 0; j < (int)moves.size(); j++) {
+                blocked = blocked || (j != i && (reads(moves[j], moves[i].dst) || reads(moves[j], moves[i].dst2)));
+            }
+            if (!blocked) {
+                emitMove(moves[i]);
+                moves.erase(moves.begin() + i);
+                progress = true;
+            }
+        }
+        if (progress) {
+            continue;
+        }
+
+        // the moves form cycles, the value of one destination is moved out of the way
+        std::string location = moves[0].dst;
+        IRType type = IRType::WORD;
+        for (const Move &move : moves) {
+            if (reads(move, location)) {
+                type = move.type;
+            }
+        }
+        std::string scratch = isFloat(type) ? "$f18" : "$t9";
+        copy(type, scratch, location);
+        for (Move &move : moves) {
+            if (reads(move, location)) {
+                move.src = scratch;
+            }
+        }
+    }
+}
+
+void InstructionSelector::keepFrameForCalls() {
+    if (escapedSlots(fn).empty()) {
+        return;
+    }
+    for (IRBlock* block : fn->blocks) {
+        IRInstr* tailCall = block->terminator();
+        if (tailCall == nullptr || tailCall->op != IROp::TAILCALL) {
+            continue;
+        }
+        IRInstr* call = fn->newInstr(IROp::CALL, fn->returnType);
+        call->name = tailCall->name;
+        for (IRInstr* argument : tailCall->operands) {
+            call->addOperand(argument);
+        }
+        block->insertBeforeTerminator(call);
+        fn->erase(tailCall);
+        IRInstr* ret = fn->newInstr(IROp::RET, IRType::VOID);
+        ret->addOperand(call);
+        block->append(ret);
+    }
+}
+
+void InstructionSelector::compile(std::ostream &assemblyOut) {
+    out = &assemblyOut;
+
+    keepFrameForCalls();
+    fn->splitCriticalEdges();
+    markLive();
+    findFolded();
+    computeIntervals();
+    allocateRegisters();
+    layoutFrame();
+
+    for (IRBlock* block : fn->blocks) {
+        if (block->terminator() == nullptr) {
+            throw std::runtime_error("InstructionSelector: block " + block->name() + " of " + fn->name + " has no terminator.\n");
+        }
+        labels[block] = generateUniqueLabel(fn->name + "_" + block->name() + "_");
+    }
+
+    compilePrologue();
+    for (int i = 0; i < (int)fn->blocks.size(); i++) {
+        compileBlock(fn->blocks[i], i + 1 < (int)fn->blocks.size() ? fn->blocks[i + 1] : nullptr);
+    }
+}
+
+void InstructionSelector::compilePrologue() {
+    uint32_t mask = 0;
+    uint32_t fmask = 0;
+    int fmaskOffset = 0;
+    for (const std::pair<std::string, int> &saved : savedRegisters) {
+        int number = std::stoi(saved.first.substr(2));
+        if (saved.first[1] == 'f') {
+            fmask |= 3u << number;
+            fmaskOffset = saved.second + 4 - frameSize;
+        } else {
+            mask |= 1u << (16 + number);
+        }
+    }
+    if (hasCalls) {
+        mask |= 1u << 31;
+    }
+
+    *out << ".frame	$sp, " << frameSize << " , $31" << std::endl;
+    *out << std::hex << std::setfill('0') << ".mask	0x" << std::setw(8) << mask << "," << std::dec << (mask != 0 ? -4 : 0) << std::endl;
+    *out << std::hex << std::setfill('0') << ".fmask	0x" << std::setw(8) << fmask << "," << std::dec << fmaskOffset << std::endl;
+    *out << std::setfill(' ');
+    *out << ".set	noreorder" << std::endl;
+    *out << ".set	nomacro" << std::endl;
+
+    if (frameSize != 0) {
+        *out << "addiu $sp, $sp, -" << frameSize << std::endl;
+    }
+    if (hasCalls) {
+        *out << "sw $31, " << frameSize - 4 << "($sp)" << std::endl;
+    }
+    for (const std::pair<std::string, int> &saved : savedRegisters) {
+        *out << (saved.first[1] == 'f' ? "s.d " : "sw ") << saved.first << ", " << saved.second << "($sp)" << std::endl;
+    }
+
+    // parameters are moved from where they are passed to where they are kept
+    std::vector<TypeKind> kinds;
+    for (IRType type : fn->paramTypes) {
+        kinds.push_back(typeKind(type));
+    }
+    std::vector<int> offsets;
+    std::vector<std::string> regs;
+    argumentLocations(kinds, offsets, regs);
+    std::vector<Move> moves;
+    for (IRInstr* instr : fn->blocks[0]->instrs) {
+        if (instr->op != IROp::PARAM || !needsLocation(instr)) {
+            continue;
+        }
+        Move move;
+        move.type = instr->type;
+        move.dst = locations.at(instr);
+        std::string reg = regs[instr->imm];
+        if (reg == "") {
+            // in the argument area of the caller, right above this frame
+            move.src = std::to_string(frameSize + offsets[instr->imm]) + "($sp)";
+        } else if (instr->type == IRType::DOUBLE && reg[1] == 'a') {
+            move.src = reg;
+            move.src2 = "$a" + std::to_string(offsets[instr->imm] / 4 + 1);
+        } else {
+            move.src = reg;
+        }
+        moves.push_back(move);
+    }
+    parallelMove(moves);
+}
+
+void InstructionSelector::compileEpilogue() {
+    for (const std::pair<std::string, int> &saved : savedRegisters) {
+        *out << (saved.first[1] == 'f' ? "l.d " : "lw ") << saved.first << ", " << saved.second << "($sp)" << std::endl;
+    }
+    if (hasCalls) {
+        *out << "lw $31, " << frameSize - 4 << "($sp)" << std::endl;
+    }
+    if (frameSize != 0) {
+        *out << "addiu $sp, $sp, " << frameSize << std::endl;
+    }
+}
+
+void InstructionSelector::compileBlock(IRBlock* block, IRBlock* next) {
+    if (!block->preds.empty()) {
+        *out << labels[block] << ":" << std::endl;
+    }
+    for (IRInstr* instr : block->instrs) {
+        if (instr->isTerminator()) {
+            compileTerminator(instr, next);
+        } else if (isEmitted(instr)) {
+            *out << "# " << instr->toString() << std::endl;
+            compileInstr(instr);
+        }
+    }
+}
+
+void InstructionSelector::compileInstr(IRInstr* instr) {
+    switch (instr->op) {
+        case IROp::CALL:
+            compileCall(instr);
+            return;
+        case IROp::CONST:
+        case IROp::GLOBAL:
+        case IROp::STRING:
+        {
+            std::string reg = target(instr);
+            materialize(instr, reg);
+            define(instr, reg);
+            return;
+        }
+        case IROp::LOAD:
+        {
+            std::string reg = target(instr);
+            std::string op = instr->type == IRType::FLOAT ? "l.s " : instr->type == IRType::DOUBLE ? "l.d " : instr->isByte ? "lb " : "lw ";
+            std::string location = address(instr->operands[0], instr->imm, "$t8");
+            *out << op << reg << ", " << location << std::endl;
+            define(instr, reg);
+            return;
+        }
+        case IROp::STORE:
+        {
+            IRInstr* value = instr->operands[0];
+            std::string reg = use(value, 0);
+            std::string op = value->type == IRType::FLOAT ? "s.s " : value->type == IRType::DOUBLE ? "s.d " : instr->isByte ? "sb " : "sw ";
+            std::string location = address(instr->operands[1], instr->imm, "$t9");
+            *out << op << reg << ", " << location << std::endl;
+            return;
+        }
+        case IROp::SEXT8:
+        {
+            std::string value = use(instr->operands[0], 0);
+            std::string reg = target(instr);
+            *out << "sll " << reg << ", " << value << ", 24" << std::endl;
+            *out << "sra " << reg << ", " << reg << ", 24" << std::endl;
+            define(instr, reg);
+            return;
+        }
+        case IROp::FBITS:
+        {
+            IRInstr* operand = instr->operands[0];
+            std::string value = use(operand, 0);
+            std::string reg = target(instr);
+            *out << "mfc1 " << reg << ", " << (operand->type == IRType::DOUBLE ? oddReg(value) : value) << std::endl;
+            define(instr, reg);
+            return;
+        }
+        case IROp::NEG:
+        case IROp::NOT:
+        {
+            std::string value = use(instr->operands[0], 0);
+            std::string reg = target(instr);
+            if (instr->type == IRType::FLOAT || instr->type == IRType::DOUBLE) {
+                *out << (instr->type == IRType::FLOAT ? "neg.s " : "neg.d ") << reg << ", " << value << std::endl;
+            } else if (instr->op == IROp::NEG) {
+                *out << "subu " << reg << ", $0, " << value << std::endl;
+            } else {
+                *out << "nor " << reg << ", " << value << ", $0" << std::endl;
+            }
+            define(instr, reg);
+            return;
+        }
+        default:
+            break;
+    }
+    if (instr->isCompare()) {
+        compileCompare(instr);
+    } else {
+        compileBinary(instr);
+    }
+}
+
+void InstructionSelector::compileBinary(IRInstr* instr) {
+    IRInstr* right = instr->operands[1];
+    std::string left = use(instr->operands[0], 0);
+
+    if (isFloat(instr->type)) {
+        std::string rightReg = use(right, 1);
+        std::string reg = target(instr);
+        std::string suffix = instr->type == IRType::FLOAT ? ".s " : ".d ";
+        std::string op;
+        switch (instr->op) {
+            case IROp::ADD: op = "add"; break;
+            case IROp::SUB: op = "sub"; break;
+            case IROp::MUL: op = "mul"; break;
+            case IROp::DIV: op = "div"; break;
+            default:
+                throw std::runtime_error("InstructionSelector: " + instr->toString() + " is not supported.\n");
+        }
+        *out << op << suffix << reg << ", " << left << ", " << rightReg << std::endl;
+        define(instr, reg);
+        return;
+    }
+
+    // operations with a constant on the right have an immediate form or a cheaper sequence
+    bool isUnsigned = instr->op == IROp::DIVU || instr->op == IROp::REMU || instr->op == IROp::SHRU;
+    bool isRemainder = instr->op == IROp::REM || instr->op == IROp::REMU;
+    if (right->isConstant()) {
+        int c = right->imm;
+        std::string reg = target(instr);
+        bool done = true;
+        switch (instr->op) {
+            case IROp::ADD:
+                done = c >= -32768 && c <= 32767;
+                if (done) {
+                    *out << "addiu " << reg << ", " << left << ", " << c << std::endl;
+                }
+                break;
+            case IROp::SUB:
+                done = c > -32768 && c <= 32768;
+                if (done) {
+                    *out << "addiu " << reg << ", " << left << ", " << -c << std::endl;
+                }
+                break;
+            case IROp::MUL:
+                done = Pipeline::isEnabled("strength-reduce");
+                if (done) {
+                    multiplyByConstant(*out, reg, left, c);
+                }
+                break;
+            case IROp::DIV:
+            case IROp::DIVU:
+            case IROp::REM:
+            case IROp::REMU:
+            {
+                done = Pipeline::isEnabled("strength-reduce") && canDivideByConstant(c, isUnsigned);
+                uint32_t d = c < 0 ? 0u - (uint32_t)c : c;
+                if (done && !isUnsigned && isRemainder && d > 1 && (d & (d - 1)) != 0) {
+                    // x - x/d*d, the quotient is kept in $t9 since divideByConstant would need another register
+                    divideByConstant(*out, "$t9", left, d, false, false);
+                    multiplyByConstant(*out, "$t9", "$t9", d);
+                    *out << "subu " << reg << ", " << left << ", $t9" << std::endl;
+                } else if (done) {
+                    divideByConstant(*out, reg, left, c, isUnsigned, isRemainder);
+                }
+                break;
+            }
+            case IROp::AND:
+            case IROp::OR:
+            case IROp::XOR:
+                done = c >= 0 && c <= 65535;
+                if (done) {
+                    std::string op = instr->op == IROp::AND ? "andi " : instr->op == IROp::OR ? "ori " : "xori ";
+                    *out << op << reg << ", " << left << ", " << c << std::endl;
+                }
+                break;
+            case IROp::SHL:
+            case IROp::SHR:
+            case IROp::SHRU:
+            {
+                std::string op = instr->op == IROp::SHL ? "sll " : instr->op == IROp::SHR ? "sra " : "srl ";
+                *out << op << reg << ", " << left << ", " << (c & 31) << std::endl;
+                break;
+            }
+            default:
+                done = false;
+                break;
+        }
+        if (done) {
+            define(instr, reg);
+            return;
+        }
+    }
+
+    std::string rightReg = use(right, 1);
+    std::string reg = target(instr);
+    switch (instr->op) {
+        case IROp::ADD: *out << "addu " << reg << ", " << left << ", " << rightReg << std::endl; break;
+        case IROp::SUB: *out << "subu " << reg << ", " << left << ", " << rightReg << std::endl; break;
+        case IROp::MUL: *out << "mul " << reg << ", " << left << ", " << rightReg << std::endl; break;
+        case IROp::AND: *out << "and " << reg << ", " << left << ", " << rightReg << std::endl; break;
+        case IROp::OR:  *out << "or " << reg << ", " << left << ", " << rightReg << std::endl; break;
+        case IROp::XOR: *out << "xor " << reg << ", " << left << ", " << rightReg << std::endl; break;
+        case IROp::SHL: *out << "sllv " << reg << ", " << left << ", " << rightReg << std::endl; break;
+        case IROp::SHR: *out << "srav " << reg << ", " << left << ", " << rightReg << std::endl; break;
+        case IROp::SHRU: *out << "srlv " << reg << ", " << left << ", " << rightReg << std::endl; break;
+        case IROp::DIV:
+        case IROp::DIVU:
+        case IROp::REM:
+        case IROp::REMU:
+            *out << (isUnsigned ? "divu " : "div ") << left << ", " << rightReg << std::endl;
+            *out << (isRemainder ? "mfhi " : "mflo ") << reg << std::endl;
+            break;
+        default:
+            throw std::runtime_error("InstructionSelector: " + instr->toString() + " is not supported.\n");
+    }
+    define(instr, reg);
+}
+
+void InstructionSelector::compileCompare(IRInstr* instr) {
+    IRInstr* right = instr->operands[1];
+    std::string left = use(instr->operands[0], 0);
+
+    // the condition flag is turned into 0 or 1
+    if (isFloat(instr->operands[0]->type)) {
+        std::string rightReg = use(right, 1);
+        std::string reg = target(instr);
+        std::string suffix = instr->operands[0]->type == IRType::FLOAT ? ".s " : ".d ";
+        switch (instr->op) {
+            case IROp::SEQ:
+            case IROp::SNE: *out << "c.eq" << suffix << left << ", " << rightReg << std::endl; break;
+            case IROp::SLT: *out << "c.lt" << suffix << left << ", " << rightReg << std::endl; break;
+            case IROp::SLE: *out << "c.le" << suffix << left << ", " << rightReg << std::endl; break;
+            case IROp::SGT: *out << "c.lt" << suffix << rightReg << ", " << left << std::endl; break;
+            case IROp::SGE: *out << "c.le" << suffix << rightReg << ", " << left << std::endl; break;
+            default:
+                throw std::runtime_error("InstructionSelector: " + instr->toString() + " is not supported.\n");
+        }
+        std::string endLabel = generateUniqueLabel("end");
+        *out << "li " << reg << ", 1" << std::endl;
+        *out << (instr->op == IROp::SNE ? "bc1f " : "bc1t ") << endLabel << std::endl;
+        *out << "nop" << std::endl;
+        *out << "move " << reg << ", $0" << std::endl;
+        *out << endLabel << ":" << std::endl;
+        define(instr, reg);
+        return;
+    }
+
+    bool isUnsigned = isUnsignedCompare(instr->op);
+    std::string slt = isUnsigned ? "sltu " : "slt ";
+    std::string slti = isUnsigned ? "sltiu " : "slti ";
+    std::string reg;
+    switch (instr->op) {
+        case IROp::SEQ:
+        case IROp::SNE:
+            reg = target(instr);
+            if (right->isConstant(0)) {
+                reg = left;
+            } else if (fitsImmediate(right, 0, 65535)) {
+                *out << "xori " << reg << ", " << left << ", " << right->imm << std::endl;
+            } else {
+                std::string rightReg = use(right, 1);
+                *out << "xor " << reg << ", " << left << ", " << rightReg << std::endl;
+            }
+            if (instr->op == IROp::SEQ) {
+                *out << "sltiu " << target(instr) << ", " << reg << ", 1" << std::endl;
+            } else {
+                *out << "sltu " << target(instr) << ", $0, " << reg << std::endl;
+            }
+            reg = target(instr);
+            break;
+        case IROp::SLT:
+        case IROp::SLTU:
+        case IROp::SGE:
+        case IROp::SGEU:
+            reg = target(instr);
+            if (fitsImmediate(right, -32768, 32767)) {
+                *out << slti << reg << ", " << left << ", " << right->imm << std::endl;
+            } else {
+                std::string rightReg = use(right, 1);
+                *out << slt << reg << ", " << left << ", " << rightReg << std::endl;
+            }
+            if (instr->op == IROp::SGE || instr->op == IROp::SGEU) {
+                *out << "xori " << reg << ", " << reg << ", 1" << std::endl;
+            }
+            break;
+        default:
+        {
+            // a > b is b < a
+            std::string rightReg = use(right, 1);
+            reg = target(instr);
+            *out << slt << reg << ", " << rightReg << ", " << left << std::endl;
+            if (instr->op == IROp::SLE || instr->op == IROp::SLEU) {
+                *out << "xori " << reg << ", " << reg << ", 1" << std::endl;
+            }
+            break;
+        }
+    }
+    define(instr, reg);
+}
+
+void InstructionSelector::compileArguments(IRInstr* call) {
+    std::vector<TypeKind> kinds;
+    for (IRInstr* operand : call->operands) {
+        kinds.push_back(typeKind(operand->type));
+    }
+    std::vector<int> offsets;
+    std::vector<std::string> regs;
+    argumentLocations(kinds, offsets, regs);
+
+    // arguments in memory are stored first, that doesn't overwrite any register
+    std::vector<Move> moves;
+    for (int i = 0; i < (int)call->operands.size(); i++) {
+        IRInstr* value = call->operands[i];
+        if (regs[i] == "") {
+            std::string reg = use(value, 0);
+            if (value->type == IRType::WORD) {
+                *out << "sw " << reg << ", " << offsets[i] << "($sp)" << std::endl;
+            } else {
+                *out << (value->type == IRType::FLOAT ? "s.s " : "s.d ") << reg << ", " << offsets[i] << "($sp)" << std::endl;
+            }
+            continue;
+        }
+        Move move = moveFrom(value, regs[i]);
+        if (value->type == IRType::DOUBLE && regs[i][1] == 'a') {
+            move.dst2 = "$a" + std::to_string(offsets[i] / 4 + 1);
+        }
+        moves.push_back(move);
+    }
+    parallelMove(moves);
+}
+
+void InstructionSelector::compileCall(IRInstr* instr) {
+    compileArguments(instr);
+    *out << "jal " << instr->name << std::endl;
+    *out << "nop" << std::endl;
+
+    if (needsLocation(instr) && !instr->users.empty()) {
+        copy(instr->type, locations.at(instr), isFloat(instr->type) ? "$f0" : "$v0");
+    }
+}
+
+void InstructionSelector::compileBranch(IRInstr* cond, const std::string &label, bool jumpIf) {
+    if (folded.count(cond) == 0) {
+        std::string reg = use(cond, 0);
+        *out << (jumpIf ? "bne " : "beq ") << reg << ", $0, " << label << std::endl;
+        *out << "nop" << std::endl;
+        return;
+    }
+
+    IRInstr* left = cond->operands[0];
+    IRInstr* right = cond->operands[1];
+    std::string leftReg = use(left, 0);
+
+    // floating point comparisons set the condition flag
+    if (isFloat(left->type)) {
+        std::string rightReg = use(right, 1);
+        std::string suffix = left->type == IRType::FLOAT ? ".s " : ".d ";
+        switch (cond->op) {
+            case IROp::SEQ:
+            case IROp::SNE: *out << "c.eq" << suffix << leftReg << ", " << rightReg << std::endl; break;
+            case IROp::SLT: *out << "c.lt" << suffix << leftReg << ", " << rightReg << std::endl; break;
+            case IROp::SLE: *out << "c.le" << suffix << leftReg << ", " << rightReg << std::endl; break;
+            case IROp::SGT: *out << "c.lt" << suffix << rightReg << ", " << leftReg << std::endl; break;
+            case IROp::SGE: *out << "c.le" << suffix << rightReg << ", " << leftReg << std::endl; break;
+            default:
+                throw std::runtime_error("InstructionSelector: " + cond->toString() + " is not supported.\n");
+        }
+        bool onFlag = (cond->op != IROp::SNE) == jumpIf;
+        *out << (onFlag ? "bc1t " : "bc1f ") << label << std::endl;
+        *out << "nop" << std::endl;
+        return;
+    }
+
+    IROp op = jumpIf ? cond->op : invertCompare(cond->op);
+    bool isUnsigned = isUnsignedCompare(op);
+    std::string slt = isUnsigned ? "sltu " : "slt ";
+    std::string slti = isUnsigned ? "sltiu " : "slti ";
+
+    // signed comparisons with 0 have branches of their own
+    if (right->isConstant(0) && !isUnsigned && op != IROp::SEQ && op != IROp::SNE) {
+        std::string branch = op == IROp::SLT ? "bltz " : op == IROp::SLE ? "blez " : op == IROp::SGT ? "bgtz " : "bgez ";
+        *out << branch << leftReg << ", " << label << std::endl;
+        *out << "nop" << std::endl;
+        return;
+    }
+
+    // a <= c is a < c + 1 as long as c + 1 doesn't overflow
+    bool plusOne = (op == IROp::SLE || op == IROp::SGT || op == IROp::SLEU || op == IROp::SGTU)
+        && fitsImmediate(right, -32768, 32766) && !(isUnsigned && right->imm == -1);
+    std::string branch;
+    switch (op) {
+        case IROp::SEQ:
+        case IROp::SNE:
+        {
+            std::string rightReg = use(right, 1);
+            *out << (op == IROp::SEQ ? "beq " : "bne ") << leftReg << ", " << rightReg << ", " << label << std::endl;
+            *out << "nop" << std::endl;
+            return;
+        }
+        case IROp::SLT:
+        case IROp::SLTU:
+        case IROp::SGE:
+        case IROp::SGEU:
+            if (fitsImmediate(right, -32768, 32767)) {
+                *out << slti << "$t8, " << leftReg << ", " << right->imm << std::endl;
+            } else {
+                std::string rightReg = use(right, 1);
+                *out << slt << "$t8, " << leftReg << ", " << rightReg << std::endl;
+            }
+            branch = op == IROp::SLT || op == IROp::SLTU ? "bne " : "beq ";
+            break;
+        default:
+            if (plusOne) {
+                *out << slti << "$t8, " << leftReg << ", " << right->imm + 1 << std::endl;
+                branch = op == IROp::SLE || op == IROp::SLEU ? "bne " : "beq ";
+            } else {
+                std::string rightReg = use(right, 1);
+                *out << slt << "$t8, " << rightReg << ", " << leftReg << std::endl;
+                branch = op == IROp::SGT || op == IROp::SGTU ? "bne " : "beq ";
+            }
+            break;
+    }
+    *out << branch << "$t8, $0, " << label << std::endl;
+    *out << "nop" << std::endl;
+}
+
+void InstructionSelector::compileTerminator(IRInstr* instr, IRBlock* next) {
+    *out << "# " << instr->toString() << std::endl;
+    switch (instr->op) {
+        case IROp::JUMP:
+        {
+            // the values of the phis of the target are set on the way
+            IRBlock* target = instr->targets[0];
+            std::vector<Move> moves;
+            for (IRInstr* phi : target->instrs) {
+                if (phi->op == IROp::PHI && needsLocation(phi)) {
+                    moves.push_back(moveFrom(phi->operands[target->predIndex(instr->block)], locations.at(phi)));
+                }
+            }
+            parallelMove(moves);
+            if (target != next) {
+                *out << "j " << labels[target] << std::endl;
+                *out << "nop" << std::endl;
+            }
+            break;
+        }
+        case IROp::BRANCH:
+        {
+            IRBlock* trueBlock = instr->targets[0];
+            IRBlock* falseBlock = instr->targets[1];
+            if (falseBlock == next) {
+                compileBranch(instr->operands[0], labels[trueBlock], true);
+            } else if (trueBlock == next) {
+                compileBranch(instr->operands[0], labels[falseBlock], false);
+            } else {
+                compileBranch(instr->operands[0], labels[trueBlock], true);
+                *out << "j " << labels[falseBlock] << std::endl;
+                *out << "nop" << std::endl;
+            }
+            break;
+        }
+        case IROp::SWITCH:
+        {
+            std::vector<std::pair<int, std::string>> cases;
+            for (int i = 0; i < (int)instr->caseValues.size(); i++) {
+                cases.push_back({instr->caseValues[i], labels[instr->targets[i + 1]]});
+            }
+            compileSwitchDispatch(*out, use(instr->operands[0], 0), "$t9", cases, labels[instr->targets[0]]);
+            break;
+        }
+        case IROp::RET:
+            if (!instr->operands.empty() && instr->operands[0]->type != IRType::VOID) {
+                IRInstr* value = instr->operands[0];
+                Move move = moveFrom(value, isFloat(value->type) ? "$f0" : "$v0");
+                emitMove(move);
+            }
+            compileEpilogue();
+            *out << "jr $31" << std::endl;
+            *out << "nop" << std::endl;
+            break;
+        case IROp::TAILCALL:
+            compileArguments(instr);
+            compileEpilogue();
+            *out << "j " << instr->name << std::endl;
+            *out << "nop" << std::endl;
+            break;
+        default:
+            throw std::runtime_error("InstructionSelector: " + instr->toString() + " is not a terminator.\n");
+    }
+}
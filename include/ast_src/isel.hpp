@@ -0,0 +1,122 @@
+#pragma once
+
+#include "ir.hpp"
+
+/*
+    Instruction selection and register allocation for the IR of a function (see ir.hpp).
+
+    Each IR instruction becomes one or a few MIPS instructions. Constants and addresses of stack
+    slots and globals are not kept in registers, they are folded into the instructions using them
+    or recomputed where needed. A comparison only used by the branch after it is merged into it.
+
+    Values get registers by linear scan over their live ranges, taken in the layout order of the blocks,
+    a register can be given to several values whose ranges don't overlap.
+    Values live across a call only get callee saved registers, the ones that don't fit live in the frame.
+    Phis become moves at the end of their predecessors (critical edges are split first).
+
+    The frame is addressed through $sp, from the bottom up it holds the argument area for calls,
+    the stack slots, the spilled values, the callee saved registers and $31.
+*/
+class InstructionSelector
+{
+public:
+    InstructionSelector(IRFunction* _fn);
+
+    // writes the code of the function from the .frame directive to the last epilogue
+    void compile(std::ostream &assemblyOut);
+
+private:
+    // positions a value is live at, start and end bound all the ranges
+    struct Interval {
+        IRInstr* value = nullptr;
+        std::vector<std::pair<int, int>> ranges;
+        int start = 0;
+        int end = 0;
+        bool crossesCall = false;
+
+        bool intersects(const Interval &other) const;
+    };
+
+    /*
+        A move of a parallel move, all of them read their sources before any destination is written.
+        Locations are registers or "offset($sp)". Doubles passed in integer registers
+        use dst2 or src2 for the register holding the least significant word.
+        Constants and addresses are rematerialized from value instead of being read from src.
+    */
+    struct Move {
+        IRType type;
+        std::string dst;
+        std::string src;
+        std::string dst2;
+        std::string src2;
+        IRInstr* value = nullptr;
+    };
+
+    IRFunction* fn;
+    std::ostream* out = nullptr;
+
+    // instructions whose value is needed or that have side effects
+    std::set<IRInstr*> live;
+    // comparisons merged into branches and additions merged into the address of loads and stores
+    std::set<IRInstr*> folded;
+
+    std::map<IRBlock*, std::pair<int, int>> blockPositions;
+    std::map<IRInstr*, int> positions;
+    std::vector<int> callPositions;
+    std::vector<Interval> intervals;
+
+    // register or frame location of every value that needs one
+    std::map<IRInstr*, std::string> locations;
+    std::map<IRInstr*, int> spills;
+    std::set<std::string> usedCalleeSaved;
+
+    bool hasCalls = false;
+    int frameSize = 0;
+    int outgoingSize = 0;
+    std::vector<int> slotOffsets;
+    std::vector<std::pair<std::string, int>> savedRegisters;
+
+    std::map<IRBlock*, std::string> labels;
+    std::map<IRInstr*, std::string> stringLabels;
+
+    static bool isFloat(IRType type);
+    // values that are recomputed wherever they are used instead of being kept in a register
+    static bool isRematerialized(IRInstr* value);
+    bool needsLocation(IRInstr* value);
+    bool isEmitted(IRInstr* instr);
+    // values read by the code of instr, looking through folded operands
+    void emittedUses(IRInstr* instr, std::vector<IRInstr*> &uses);
+
+    // tail calls become calls and returns while the callee might be given the address of a stack slot
+    void keepFrameForCalls();
+    void markLive();
+    void findFolded();
+    void computeIntervals();
+    std::string registerHint(IRInstr* value);
+    void allocateRegisters();
+    void layoutFrame();
+
+    // register holding the value, loaded or computed into scratch register number i if needed
+    std::string use(IRInstr* value, int scratch);
+    // register to compute the value of instr into, define stores it if it lives in the frame
+    std::string target(IRInstr* instr);
+    void define(IRInstr* instr, const std::string &reg);
+    std::string scratchReg(IRType type, int i);
+    std::string address(IRInstr* pointer, int offset, const std::string &scratch);
+    void materialize(IRInstr* value, const std::string &reg);
+    void copy(IRType type, const std::string &dst, const std::string &src);
+    Move moveFrom(IRInstr* value, const std::string &dst);
+    void emitMove(const Move &move);
+    void parallelMove(std::vector<Move> moves);
+
+    void compilePrologue();
+    void compileEpilogue();
+    void compileBlock(IRBlock* block, IRBlock* next);
+    void compileInstr(IRInstr* instr);
+    void compileBinary(IRInstr* instr);
+    void compileCompare(IRInstr* instr);
+    void compileCall(IRInstr* instr);
+    void compileArguments(IRInstr* call);
+    void compileBranch(IRInstr* cond, const std::string &label, bool jumpIf);
+    void compileTerminator(IRInstr* instr, IRBlock* next);
+};
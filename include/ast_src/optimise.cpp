@@ -0,0 +1,897 @@
+#include "optimise.hpp"
+#include "inliner.hpp"
+#include "pipeline.hpp"
+
+#include <cstring>
+
+// the passes over the IR, by their name in the pipeline
+static const std::map<std::string, void (*)(IRFunction*)> irPasses = {
+    {"inline", Inliner::inlineCalls},
+    {"licm", hoistLoopInvariants},
+    {"cse", eliminateCommonSubexpressions},
+    {"induction-vars", reduceInductionVariables},
+    {"dce", eliminateDeadCode},
+};
+
+void optimiseFunction(IRFunction* fn) {
+    for (const Pipeline::Pass &pass : Pipeline::passes) {
+        auto it = irPasses.find(pass.name);
+        if (it != irPasses.end() && Pipeline::isEnabled(pass.name)) {
+            it->second(fn);
+        }
+    }
+}
+
+DominatorTree::DominatorTree(IRFunction* fn) {
+    // postorder by depth first search, the successors of a block are visited before it is added
+    std::vector<std::pair<IRBlock*, int>> stack = {{fn->blocks[0], 0}};
+    std::set<IRBlock*> visited = {fn->blocks[0]};
+    while (!stack.empty()) {
+        IRBlock* block = stack.back().first;
+        std::vector<IRBlock*> successors = block->successors();
+        int &next = stack.back().second;
+        if (next < (int)successors.size()) {
+            IRBlock* successor = successors[next++];
+            if (visited.insert(successor).second) {
+                stack.push_back({successor, 0});
+            }
+        } else {
+            order.push_back(block);
+            stack.pop_back();
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    for (int i = 0; i < (int)order.size(); i++) {
+        numbers[order[i]] = i;
+    }
+
+    // Cooper, Harvey and Kennedy, "A Simple, Fast Dominance Algorithm"
+    idoms[order[0]] = order[0];
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int i = 1; i < (int)order.size(); i++) {
+            IRBlock* block = order[i];
+            IRBlock* newIdom = nullptr;
+            for (IRBlock* pred : block->preds) {
+                if (idoms.count(pred) == 0) {
+                    continue;
+                }
+                IRBlock* other = pred;
+                while (newIdom != nullptr && other != newIdom) {
+                    while (numbers[other] > numbers[newIdom]) {
+                        other = idoms[other];
+                    }
+                    while (numbers[newIdom] > numbers[other]) {
+                        newIdom = idoms[newIdom];
+                    }
+                }
+                newIdom = other;
+            }
+            if (idoms[block] != newIdom) {
+                idoms[block] = newIdom;
+                changed = true;
+            }
+        }
+    }
+}
+
+IRBlock* DominatorTree::idom(IRBlock* block) const {
+    auto it = idoms.find(block);
+    if (it == idoms.end() || it->second == block) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+bool DominatorTree::dominates(IRBlock* a, IRBlock* b) const {
+    for (IRBlock* block = b; block != nullptr; block = idom(block)) {
+        if (block == a) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const std::vector<IRBlock*>& DominatorTree::reversePostorder() const {
+    return order;
+}
+
+// a block between the header of the loop and the blocks entering it from outside
+static void addPreheader(IRFunction* fn, IRLoop &loop, std::vector<IRLoop> &loops) {
+    IRBlock* header = loop.header;
+    std::vector<IRBlock*> outside;
+    std::vector<IRBlock*> inside;
+    for (IRBlock* pred : header->preds) {
+        (loop.blocks.count(pred) != 0 ? inside : outside).push_back(pred);
+    }
+    if (outside.empty()) {
+        return;
+    }
+    if (outside.size() == 1 && outside[0]->successors().size() == 1) {
+        loop.preheader = outside[0];
+        return;
+    }
+
+    IRBlock* preheader = fn->newBlock();
+    fn->blocks.pop_back();
+    fn->blocks.insert(std::find(fn->blocks.begin(), fn->blocks.end(), outside[0]) + 1, preheader);
+    for (IRBlock* pred : outside) {
+        for (IRBlock*& target : pred->terminator()->targets) {
+            if (target == header) {
+                target = preheader;
+            }
+        }
+        preheader->preds.push_back(pred);
+    }
+
+    // the phis of the header get the values from outside the loop through the preheader
+    for (IRInstr* phi : header->instrs) {
+        if (phi->op != IROp::PHI) {
+            continue;
+        }
+        std::vector<IRInstr*> insideValues;
+        std::vector<IRInstr*> outsideValues;
+        for (int i = 0; i < (int)header->preds.size(); i++) {
+            (loop.blocks.count(header->preds[i]) != 0 ? insideValues : outsideValues).push_back(phi->operands[i]);
+        }
+        IRInstr* incoming = outsideValues[0];
+        if (outsideValues.size() > 1) {
+            incoming = fn->newInstr(IROp::PHI, phi->type);
+            for (IRInstr* value : outsideValues) {
+                incoming->addOperand(value);
+            }
+            preheader->append(incoming);
+        }
+        phi->dropOperands();
+        for (IRInstr* value : insideValues) {
+            phi->addOperand(value);
+        }
+        phi->addOperand(incoming);
+    }
+    inside.push_back(preheader);
+    header->preds = inside;
+
+    IRInstr* jump = fn->newInstr(IROp::JUMP, IRType::VOID);
+    jump->targets.push_back(header);
+    preheader->append(jump);
+    loop.preheader = preheader;
+
+    // the preheader is inside the loops around this one
+    for (IRLoop &other : loops) {
+        if (&other != &loop && other.blocks.count(header) != 0) {
+            other.blocks.insert(preheader);
+        }
+    }
+}
+
+std::vector<IRLoop> findLoops(IRFunction* fn) {
+    DominatorTree dominators(fn);
+    std::vector<IRLoop> loops;
+    for (IRBlock* block : dominators.reversePostorder()) {
+        for (IRBlock* header : block->successors()) {
+            if (!dominators.dominates(header, block)) {
+                continue;
+            }
+
+            // a back edge, the loop is everything that reaches it without going through the header
+            auto loop = std::find_if(loops.begin(), loops.end(), [header](const IRLoop &other) {
+                return other.header == header;
+            });
+            if (loop == loops.end()) {
+                loops.push_back(IRLoop());
+                loop = loops.end() - 1;
+                loop->header = header;
+                loop->blocks.insert(header);
+            }
+            std::vector<IRBlock*> worklist = {block};
+            while (!worklist.empty()) {
+                IRBlock* member = worklist.back();
+                worklist.pop_back();
+                if (loop->blocks.insert(member).second) {
+                    worklist.insert(worklist.end(), member->preds.begin(), member->preds.end());
+                }
+            }
+        }
+    }
+
+    std::stable_sort(loops.begin(), loops.end(), [](const IRLoop &a, const IRLoop &b) {
+        return a.blocks.size() < b.blocks.size();
+    });
+    for (IRLoop &loop : loops) {
+        addPreheader(fn, loop, loops);
+    }
+    return loops;
+}
+
+static bool sameObject(IRInstr* a, IRInstr* b) {
+    return a->op == b->op && (a->op == IROp::SLOT ? a->imm == b->imm : a->name == b->name);
+}
+
+// the slot or global an address points into, nullptr if it isn't known
+static IRInstr* baseObject(IRInstr* address) {
+    if (address->op == IROp::SLOT || address->op == IROp::GLOBAL) {
+        return address;
+    } else if (address->op == IROp::ADD || address->op == IROp::SUB) {
+        // the difference of two addresses isn't an address into either
+        IRInstr* left = baseObject(address->operands[0]);
+        IRInstr* right = baseObject(address->operands[1]);
+        if (left != nullptr && right == nullptr) {
+            return left;
+        } else if (address->op == IROp::ADD && left == nullptr) {
+            return right;
+        }
+    }
+    return nullptr;
+}
+
+MemoryAccess memoryAccess(IRInstr* instr) {
+    MemoryAccess access;
+    IRInstr* address = instr->op == IROp::LOAD ? instr->operands[0] : instr->operands[1];
+    IRType type = instr->op == IROp::LOAD ? instr->type : instr->operands[0]->type;
+    access.size = instr->isByte ? 1 : type == IRType::DOUBLE ? 8 : 4;
+    access.offset = instr->imm;
+    while (address->op == IROp::ADD && address->operands[1]->isConstant()) {
+        access.offset += address->operands[1]->imm;
+        address = address->operands[0];
+    }
+    access.knownOffset = address->op == IROp::SLOT || address->op == IROp::GLOBAL;
+    access.object = baseObject(address);
+    return access;
+}
+
+// the address is used for something other than loads and stores through it
+static bool escapes(IRInstr* address) {
+    for (IRInstr* user : address->users) {
+        bool isAccess = user->op == IROp::LOAD || (user->op == IROp::STORE && user->operands[0] != address);
+        bool isOffset = (user->op == IROp::ADD || user->op == IROp::SUB) && !escapes(user);
+        if (!isAccess && !isOffset) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::set<int> escapedSlots(IRFunction* fn) {
+    std::set<int> escaped;
+    for (IRBlock* block : fn->blocks) {
+        for (IRInstr* instr : block->instrs) {
+            if (instr->op == IROp::SLOT && escapes(instr)) {
+                escaped.insert(instr->imm);
+            }
+        }
+    }
+    return escaped;
+}
+
+bool callMayAccess(const MemoryAccess& access, const std::set<int>& escaped) {
+    return access.object == nullptr || access.object->op == IROp::GLOBAL || escaped.count(access.object->imm) != 0;
+}
+
+bool mayAlias(const MemoryAccess& a, const MemoryAccess& b, const std::set<int>& escaped) {
+    if (a.object != nullptr && b.object != nullptr) {
+        if (!sameObject(a.object, b.object)) {
+            return false;
+        }
+        if (a.knownOffset && b.knownOffset) {
+            return a.offset < b.offset + b.size && b.offset < a.offset + a.size;
+        }
+        return true;
+    }
+    // a pointer that isn't known can point anywhere a call can reach
+    const MemoryAccess& known = a.object != nullptr ? a : b;
+    return callMayAccess(known, escaped);
+}
+
+// computations that can't fault and don't depend on anything but their operands
+static bool isPure(IRInstr* instr) {
+    switch (instr->op) {
+        case IROp::CONST: case IROp::SLOT: case IROp::GLOBAL: case IROp::STRING:
+        case IROp::ADD: case IROp::SUB: case IROp::MUL:
+        case IROp::AND: case IROp::OR: case IROp::XOR: case IROp::SHL: case IROp::SHR: case IROp::SHRU:
+        case IROp::NEG: case IROp::NOT: case IROp::SEXT8: case IROp::FBITS:
+            return true;
+        case IROp::DIV: case IROp::DIVU: case IROp::REM: case IROp::REMU:
+            return instr->type != IRType::WORD || (instr->operands[1]->isConstant() && instr->operands[1]->imm != 0);
+        default:
+            return instr->isCompare();
+    }
+}
+
+void hoistLoopInvariants(IRFunction* fn) {
+    std::vector<IRLoop> loops = findLoops(fn);
+    std::set<int> escaped = escapedSlots(fn);
+
+    for (IRLoop &loop : loops) {
+        if (loop.preheader == nullptr) {
+            continue;
+        }
+
+        // what the loop can write to
+        std::vector<MemoryAccess> stores;
+        bool hasCalls = false;
+        for (IRBlock* block : loop.blocks) {
+            for (IRInstr* instr : block->instrs) {
+                if (instr->op == IROp::STORE) {
+                    stores.push_back(memoryAccess(instr));
+                }
+                hasCalls = hasCalls || instr->op == IROp::CALL;
+            }
+        }
+        auto isInvariant = [&](IRInstr* instr) {
+            for (IRInstr* operand : instr->operands) {
+                if (loop.blocks.count(operand->block) != 0) {
+                    return false;
+                }
+            }
+            if (instr->op != IROp::LOAD) {
+                return isPure(instr);
+            }
+
+            // the load moves in front of the loop, so it must be valid even if the loop doesn't run
+            MemoryAccess access = memoryAccess(instr);
+            if (access.object == nullptr || !access.knownOffset || (hasCalls && callMayAccess(access, escaped))) {
+                return false;
+            }
+            for (const MemoryAccess &store : stores) {
+                if (mayAlias(access, store, escaped)) {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        // operands move before the instructions using them
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (IRBlock* block : fn->blocks) {
+                if (loop.blocks.count(block) == 0) {
+                    continue;
+                }
+                std::vector<IRInstr*> instrs = block->instrs;
+                for (IRInstr* instr : instrs) {
+                    if (isInvariant(instr)) {
+                        block->remove(instr);
+                        loop.preheader->insertBeforeTerminator(instr);
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+}
+
+static IRInstr* emitBefore(IRFunction* fn, IRBlock* block, IROp op, IRInstr* left, IRInstr* right) {
+    IRInstr* instr = fn->newInstr(op, IRType::WORD);
+    instr->addOperand(left);
+    instr->addOperand(right);
+    block->insertBeforeTerminator(instr);
+    return instr;
+}
+
+static IRInstr* constantBefore(IRFunction* fn, IRBlock* block, int value) {
+    IRInstr* instr = fn->newInstr(IROp::CONST, IRType::WORD);
+    instr->imm = value;
+    block->insertBeforeTerminator(instr);
+    return instr;
+}
+
+// base + value * scale in front of the terminator of block
+static IRInstr* scaledBefore(IRFunction* fn, IRBlock* block, IRInstr* base, IRInstr* value, int scale) {
+    if (value->isConstant()) {
+        int offset = value->imm * scale;
+        return offset == 0 ? base : emitBefore(fn, block, IROp::ADD, base, constantBefore(fn, block, offset));
+    }
+    IRInstr* offset = scale == 1 ? value : emitBefore(fn, block, IROp::MUL, value, constantBefore(fn, block, scale));
+    return emitBefore(fn, block, IROp::ADD, base, offset);
+}
+
+static bool isAddressOf(IRInstr* user, IRInstr* address) {
+    return (user->op == IROp::LOAD && user->operands[0] == address) || (user->op == IROp::STORE && user->operands[1] == address);
+}
+
+// the loop is only left by the branch at the end of its header
+static bool exitsOnlyFromHeader(const IRLoop &loop) {
+    for (IRBlock* block : loop.blocks) {
+        IROp op = block->terminator()->op;
+        if (op == IROp::RET || op == IROp::TAILCALL) {
+            return false;
+        }
+        for (IRBlock* successor : block->successors()) {
+            if (loop.blocks.count(successor) == 0 && block != loop.header) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// base + i * scale, a pointer walking through an array as the counter i of the loop goes up
+struct DerivedPointer {
+    IRInstr* base = nullptr;
+    int scale = 0;
+    IRInstr* pointer = nullptr;
+    // it is loaded or stored through on every iteration, so it stays inside the array
+    bool accessedEveryIteration = false;
+};
+
+/*
+    Rewrites the exit test of the loop to compare the pointer with its value at the bound.
+    i < n becomes an unsigned comparison with base + max(init, n) * scale, since i never goes below init
+    the loop stops at the same point even when it doesn't run at all.
+*/
+static bool replaceExitTest(IRFunction* fn, const IRLoop &loop, IRInstr* counter, IRInstr* init, int stride, const DerivedPointer &derived) {
+    IRInstr* branch = loop.header->terminator();
+    if (branch->op != IROp::BRANCH || !exitsOnlyFromHeader(loop)) {
+        return false;
+    }
+    IRInstr* compare = branch->operands[0];
+    if (compare->block != loop.header || compare->users.size() != 1) {
+        return false;
+    }
+
+    IROp op = compare->op;
+    IRInstr* bound = nullptr;
+    if (compare->operands[0] == counter && (op == IROp::SLT || op == IROp::SNE || op == IROp::SEQ)) {
+        bound = compare->operands[1];
+    } else if (compare->operands[1] == counter && (op == IROp::SGT || op == IROp::SNE || op == IROp::SEQ)) {
+        bound = compare->operands[0];
+        op = op == IROp::SGT ? IROp::SLT : op;
+    }
+    if (bound == nullptr || loop.blocks.count(bound->block) != 0) {
+        return false;
+    }
+
+    IRBlock* preheader = loop.preheader;
+    IRInstr* limit;
+    if (op == IROp::SLT) {
+        if (stride <= 0 || derived.scale <= 0) {
+            return false;
+        }
+        if (init->isConstant() && bound->isConstant()) {
+            limit = scaledBefore(fn, preheader, derived.base, constantBefore(fn, preheader, std::max(init->imm, bound->imm)), derived.scale);
+        } else {
+            // bound + ((init - bound) & -(bound < init))
+            IRInstr* difference = emitBefore(fn, preheader, IROp::SUB, init, bound);
+            IRInstr* below = emitBefore(fn, preheader, IROp::SLT, bound, init);
+            IRInstr* mask = fn->newInstr(IROp::NEG, IRType::WORD);
+            mask->addOperand(below);
+            preheader->insertBeforeTerminator(mask);
+            IRInstr* end = emitBefore(fn, preheader, IROp::ADD, bound, emitBefore(fn, preheader, IROp::AND, difference, mask));
+            limit = scaledBefore(fn, preheader, derived.base, end, derived.scale);
+        }
+        op = IROp::SLTU;
+    } else {
+        limit = scaledBefore(fn, preheader, derived.base, bound, derived.scale);
+    }
+
+    IRInstr* test = fn->newInstr(op, IRType::WORD);
+    test->addOperand(derived.pointer);
+    test->addOperand(limit);
+    loop.header->insertBeforeTerminator(test);
+    compare->replaceAllUsesWith(test);
+    fn->erase(compare);
+    return true;
+}
+
+void reduceInductionVariables(IRFunction* fn) {
+    std::vector<IRLoop> loops = findLoops(fn);
+    DominatorTree dominators(fn);
+
+    for (IRLoop &loop : loops) {
+        if (loop.preheader == nullptr) {
+            continue;
+        }
+        IRBlock* header = loop.header;
+        std::vector<IRBlock*> latches;
+        for (IRBlock* pred : header->preds) {
+            if (loop.blocks.count(pred) != 0) {
+                latches.push_back(pred);
+            }
+        }
+        auto everyIteration = [&](IRBlock* block) {
+            for (IRBlock* latch : latches) {
+                if (!dominators.dominates(block, latch)) {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        std::vector<IRInstr*> phis;
+        for (IRInstr* instr : header->instrs) {
+            if (instr->op == IROp::PHI && instr->type == IRType::WORD) {
+                phis.push_back(instr);
+            }
+        }
+        for (IRInstr* counter : phis) {
+            // counter = phi [init, counter + stride], with the same step from every latch
+            IRInstr* init = nullptr;
+            IRInstr* step = nullptr;
+            bool isBasic = true;
+            for (int i = 0; i < (int)header->preds.size(); i++) {
+                IRInstr* value = counter->operands[i];
+                if (loop.blocks.count(header->preds[i]) == 0) {
+                    init = value;
+                } else {
+                    isBasic = isBasic && (step == nullptr || step == value);
+                    step = value;
+                }
+            }
+            if (!isBasic || step == nullptr || (step->op != IROp::ADD && step->op != IROp::SUB)
+                || step->operands[0] != counter || !step->operands[1]->isConstant()) {
+                continue;
+            }
+            int stride = step->op == IROp::ADD ? step->operands[1]->imm : -step->operands[1]->imm;
+
+            // base + counter * scale in the loop, with the multiplication if there is one
+            std::vector<std::tuple<IRInstr*, IRInstr*, int>> addresses;
+            std::vector<IRInstr*> counterUsers = counter->users;
+            for (IRInstr* user : counterUsers) {
+                if (loop.blocks.count(user->block) == 0) {
+                    continue;
+                }
+                if (user->op == IROp::ADD && !user->operands[1]->isConstant()) {
+                    bool isAccessed = std::any_of(user->users.begin(), user->users.end(), [user](IRInstr* access) {
+                        return isAddressOf(access, user);
+                    });
+                    if (isAccessed) {
+                        addresses.push_back({user, nullptr, 1});
+                    }
+                } else if ((user->op == IROp::MUL || user->op == IROp::SHL) && user->operands[0] == counter
+                           && user->operands[1]->isConstant()) {
+                    int scale = user->op == IROp::MUL ? user->operands[1]->imm : 1 << user->operands[1]->imm;
+                    for (IRInstr* add : user->users) {
+                        if (add->op == IROp::ADD && loop.blocks.count(add->block) != 0) {
+                            addresses.push_back({add, user, scale});
+                        }
+                    }
+                }
+            }
+
+            std::vector<DerivedPointer> pointers;
+            std::set<IRInstr*> replaced;
+            for (auto &address : addresses) {
+                IRInstr* add = std::get<0>(address);
+                IRInstr* index = std::get<1>(address) != nullptr ? std::get<1>(address) : counter;
+                int scale = std::get<2>(address);
+                IRInstr* base = add->operands[add->operands[0] == index ? 1 : 0];
+                if (scale == 0 || loop.blocks.count(base->block) != 0 || !replaced.insert(add).second) {
+                    continue;
+                }
+
+                auto derived = std::find_if(pointers.begin(), pointers.end(), [base, scale](const DerivedPointer &other) {
+                    return other.base == base && other.scale == scale;
+                });
+                if (derived == pointers.end()) {
+                    // a phi of its own, stepped along with the counter
+                    pointers.push_back(DerivedPointer());
+                    derived = pointers.end() - 1;
+                    derived->base = base;
+                    derived->scale = scale;
+                    derived->pointer = fn->newInstr(IROp::PHI, IRType::WORD);
+                    IRInstr* start = scaledBefore(fn, loop.preheader, base, init, scale);
+                    IRInstr* next = emitBefore(fn, step->block, IROp::ADD, derived->pointer, constantBefore(fn, step->block, stride * scale));
+                    for (IRBlock* pred : header->preds) {
+                        derived->pointer->addOperand(loop.blocks.count(pred) != 0 ? next : start);
+                    }
+                    header->insertAfterPhis(derived->pointer);
+                }
+                for (IRInstr* user : add->users) {
+                    derived->accessedEveryIteration = derived->accessedEveryIteration || (isAddressOf(user, add) && everyIteration(user->block));
+                }
+                add->replaceAllUsesWith(derived->pointer);
+                fn->erase(add);
+                if (std::get<1>(address) != nullptr && std::get<1>(address)->users.empty()) {
+                    fn->erase(std::get<1>(address));
+                }
+            }
+
+            // the counter isn't needed anymore if it was only used for indexing and the exit test
+            for (const DerivedPointer &derived : pointers) {
+                if (derived.accessedEveryIteration && replaceExitTest(fn, loop, counter, init, stride, derived)) {
+                    break;
+                }
+            }
+            bool isUnused = std::all_of(counter->users.begin(), counter->users.end(), [step](IRInstr* user) {
+                return user == step;
+            }) && std::all_of(step->users.begin(), step->users.end(), [counter](IRInstr* user) {
+                return user == counter;
+            });
+            if (isUnused) {
+                counter->dropOperands();
+                fn->erase(step);
+                fn->erase(counter);
+            }
+        }
+    }
+}
+
+// what makes two instructions compute the same value
+struct ValueKey {
+    IROp op;
+    IRType type;
+    int imm;
+    uint64_t fbits;
+    std::string name;
+    std::vector<IRInstr*> operands;
+
+    bool operator<(const ValueKey &other) const {
+        return std::tie(op, type, imm, fbits, name, operands) < std::tie(other.op, other.type, other.imm, other.fbits, other.name, other.operands);
+    }
+};
+
+static ValueKey valueKey(IRInstr* instr) {
+    ValueKey key = {instr->op, instr->type, instr->imm, 0, instr->name, instr->operands};
+    std::memcpy(&key.fbits, &instr->fimm, sizeof(key.fbits));
+    switch (instr->op) {
+        case IROp::ADD: case IROp::MUL: case IROp::AND: case IROp::OR: case IROp::XOR: case IROp::SEQ: case IROp::SNE:
+            std::sort(key.operands.begin(), key.operands.end());
+            break;
+        default:
+            break;
+    }
+    return key;
+}
+
+// a value in memory known from an earlier load or store
+struct KnownMemory {
+    IRInstr* address;
+    int imm;
+    IRType type;
+    bool isByte;
+    MemoryAccess access;
+    IRInstr* value;
+};
+
+void eliminateCommonSubexpressions(IRFunction* fn) {
+    DominatorTree dominators(fn);
+    std::set<int> escaped = escapedSlots(fn);
+    std::map<IRBlock*, std::vector<IRBlock*>> children;
+    for (IRBlock* block : dominators.reversePostorder()) {
+        if (dominators.idom(block) != nullptr) {
+            children[dominators.idom(block)].push_back(block);
+        }
+    }
+
+    // values computed in the blocks dominating the current one
+    std::map<ValueKey, IRInstr*> available;
+    std::map<IRBlock*, std::vector<ValueKey>> added;
+    std::vector<std::pair<IRBlock*, int>> stack = {{fn->blocks[0], 0}};
+    while (!stack.empty()) {
+        IRBlock* block = stack.back().first;
+        int &next = stack.back().second;
+        if (next > 0) {
+            if (next <= (int)children[block].size()) {
+                stack.push_back({children[block][next++ - 1], 0});
+            } else {
+                for (const ValueKey &key : added[block]) {
+                    available.erase(key);
+                }
+                stack.pop_back();
+            }
+            continue;
+        }
+        next = 1;
+
+        // constants and addresses are recomputed where they are used (see isel.hpp), only reuse them nearby
+        std::map<ValueKey, IRInstr*> local;
+        // memory is only followed inside the block, stores and calls on other paths could change it
+        std::vector<KnownMemory> memory;
+        std::vector<IRInstr*> instrs = block->instrs;
+        for (IRInstr* instr : instrs) {
+            if (instr->op == IROp::LOAD) {
+                auto known = std::find_if(memory.begin(), memory.end(), [instr](const KnownMemory &other) {
+                    return other.address == instr->operands[0] && other.imm == instr->imm
+                        && other.type == instr->type && other.isByte == instr->isByte;
+                });
+                if (known != memory.end()) {
+                    instr->replaceAllUsesWith(known->value);
+                    fn->erase(instr);
+                } else {
+                    memory.push_back({instr->operands[0], instr->imm, instr->type, instr->isByte, memoryAccess(instr), instr});
+                }
+            } else if (instr->op == IROp::STORE) {
+                MemoryAccess access = memoryAccess(instr);
+                memory.erase(std::remove_if(memory.begin(), memory.end(), [&](const KnownMemory &other) {
+                    return mayAlias(access, other.access, escaped);
+                }), memory.end());
+                // a char read back is the stored value truncated
+                if (!instr->isByte) {
+                    memory.push_back({instr->operands[1], instr->imm, instr->operands[0]->type, false, access, instr->operands[0]});
+                }
+            } else if (instr->op == IROp::CALL) {
+                memory.erase(std::remove_if(memory.begin(), memory.end(), [&](const KnownMemory &other) {
+                    return callMayAccess(other.access, escaped);
+                }), memory.end());
+            } else if (instr->op != IROp::PHI && !instr->hasSideEffects()) {
+                bool isLeaf = instr->op == IROp::CONST || instr->op == IROp::SLOT || instr->op == IROp::GLOBAL || instr->op == IROp::STRING;
+                std::map<ValueKey, IRInstr*> &values = isLeaf ? local : available;
+                ValueKey key = valueKey(instr);
+                auto it = values.find(key);
+                if (it != values.end()) {
+                    instr->replaceAllUsesWith(it->second);
+                    fn->erase(instr);
+                } else {
+                    values[key] = instr;
+                    if (!isLeaf) {
+                        added[block].push_back(key);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// operations on constants and the branches testing them, inlining leaves some behind
+static void foldConstantBranches(IRFunction* fn) {
+    // operands are computed before the instructions using them, other than in phis
+    std::vector<IRBlock*> order = DominatorTree(fn).reversePostorder();
+    for (IRBlock* block : order) {
+        for (IRInstr* instr : block->instrs) {
+            // constants go on the right like in IRBuilder::binary
+            bool isCommutative = instr->op == IROp::ADD || instr->op == IROp::MUL || instr->op == IROp::AND
+                || instr->op == IROp::OR || instr->op == IROp::XOR || instr->op == IROp::SEQ || instr->op == IROp::SNE;
+            if (isCommutative && instr->operands[0]->isConstant() && !instr->operands[1]->isConstant()) {
+                std::swap(instr->operands[0], instr->operands[1]);
+            }
+            int value;
+            if (instr->type == IRType::WORD && instr->operands.size() == 2 && instr->operands[0]->isConstant()
+                && instr->operands[1]->isConstant() && foldConstants(instr->op, instr->operands[0]->imm, instr->operands[1]->imm, value)) {
+                instr->dropOperands();
+                instr->op = IROp::CONST;
+                instr->imm = value;
+            }
+        }
+
+        IRInstr* terminator = block->terminator();
+        if ((terminator->op != IROp::BRANCH && terminator->op != IROp::SWITCH) || !terminator->operands[0]->isConstant()) {
+            continue;
+        }
+        int value = terminator->operands[0]->imm;
+        IRBlock* target;
+        if (terminator->op == IROp::BRANCH) {
+            target = terminator->targets[value != 0 ? 0 : 1];
+        } else {
+            auto it = std::find(terminator->caseValues.begin(), terminator->caseValues.end(), value);
+            target = terminator->targets[it == terminator->caseValues.end() ? 0 : it - terminator->caseValues.begin() + 1];
+        }
+        for (IRBlock* successor : block->successors()) {
+            if (successor != target) {
+                fn->removeEdge(block, successor);
+            }
+        }
+        terminator->dropOperands();
+        terminator->op = IROp::JUMP;
+        terminator->targets = {target};
+        terminator->caseValues.clear();
+    }
+    fn->removeUnreachableBlocks();
+}
+
+// phis left with a single value once edges are gone, and blocks only entered from the end of the one before
+static void mergeBlocks(IRFunction* fn) {
+    for (IRBlock* block : fn->blocks) {
+        std::vector<IRInstr*> instrs = block->instrs;
+        for (IRInstr* phi : instrs) {
+            if (phi->op == IROp::PHI && phi->operands.size() == 1) {
+                phi->replaceAllUsesWith(phi->operands[0]);
+                fn->erase(phi);
+            }
+        }
+    }
+
+    for (int i = 0; i < (int)fn->blocks.size(); i++) {
+        IRBlock* block = fn->blocks[i];
+        IRInstr* jump = block->terminator();
+        while (jump->op == IROp::JUMP && jump->targets[0]->preds.size() == 1 && jump->targets[0] != fn->blocks[0] && jump->targets[0] != block) {
+            IRBlock* next = jump->targets[0];
+            fn->erase(jump);
+            for (IRInstr* instr : next->instrs) {
+                instr->block = block;
+                block->instrs.push_back(instr);
+            }
+            next->instrs.clear();
+            for (IRBlock* successor : block->successors()) {
+                std::replace(successor->preds.begin(), successor->preds.end(), next, block);
+            }
+            int position = std::find(fn->blocks.begin(), fn->blocks.end(), next) - fn->blocks.begin();
+            fn->blocks.erase(fn->blocks.begin() + position);
+            delete next;
+            if (position < i) {
+                i--;
+            }
+            jump = block->terminator();
+        }
+    }
+}
+
+// stores nothing reads afterwards, before another store to the same place or to slots never read at all
+static void removeDeadStores(IRFunction* fn) {
+    std::set<int> escaped = escapedSlots(fn);
+    std::set<int> loaded;
+    for (IRBlock* block : fn->blocks) {
+        for (IRInstr* instr : block->instrs) {
+            if (instr->op == IROp::LOAD) {
+                MemoryAccess access = memoryAccess(instr);
+                if (access.object != nullptr && access.object->op == IROp::SLOT) {
+                    loaded.insert(access.object->imm);
+                }
+            }
+        }
+    }
+
+    for (IRBlock* block : fn->blocks) {
+        // accesses that are written again later in the block without being read in between
+        std::vector<MemoryAccess> overwritten;
+        for (int i = (int)block->instrs.size() - 1; i >= 0; i--) {
+            IRInstr* instr = block->instrs[i];
+            if (instr->op == IROp::STORE) {
+                MemoryAccess access = memoryAccess(instr);
+                bool isLocal = access.object != nullptr && access.object->op == IROp::SLOT && escaped.count(access.object->imm) == 0;
+                bool isCovered = std::any_of(overwritten.begin(), overwritten.end(), [&access](const MemoryAccess &later) {
+                    return access.object != nullptr && later.object != nullptr && sameObject(later.object, access.object) && access.knownOffset && later.knownOffset
+                        && later.offset <= access.offset && access.offset + access.size <= later.offset + later.size;
+                });
+                if ((isLocal && loaded.count(access.object->imm) == 0) || isCovered) {
+                    fn->erase(instr);
+                } else {
+                    overwritten.push_back(access);
+                }
+            } else if (instr->op == IROp::LOAD) {
+                MemoryAccess access = memoryAccess(instr);
+                overwritten.erase(std::remove_if(overwritten.begin(), overwritten.end(), [&](const MemoryAccess &later) {
+                    return mayAlias(access, later, escaped);
+                }), overwritten.end());
+            } else if (instr->op == IROp::CALL) {
+                overwritten.erase(std::remove_if(overwritten.begin(), overwritten.end(), [&](const MemoryAccess &later) {
+                    return callMayAccess(later, escaped);
+                }), overwritten.end());
+            }
+        }
+    }
+}
+
+// instructions without side effects whose values nothing needs
+static void removeUnusedValues(IRFunction* fn) {
+    std::set<IRInstr*> live;
+    std::vector<IRInstr*> worklist;
+    for (IRBlock* block : fn->blocks) {
+        for (IRInstr* instr : block->instrs) {
+            if (instr->hasSideEffects() && live.insert(instr).second) {
+                worklist.push_back(instr);
+            }
+        }
+    }
+    while (!worklist.empty()) {
+        IRInstr* instr = worklist.back();
+        worklist.pop_back();
+        for (IRInstr* operand : instr->operands) {
+            if (live.insert(operand).second) {
+                worklist.push_back(operand);
+            }
+        }
+    }
+
+    // dead values can use each other, none of them is deleted before all of them are unused
+    std::vector<IRInstr*> dead;
+    for (IRBlock* block : fn->blocks) {
+        for (IRInstr* instr : block->instrs) {
+            if (live.count(instr) == 0) {
+                instr->dropOperands();
+                dead.push_back(instr);
+            }
+        }
+    }
+    for (IRInstr* instr : dead) {
+        fn->erase(instr);
+    }
+}
+
+void eliminateDeadCode(IRFunction* fn) {
+    foldConstantBranches(fn);
+    mergeBlocks(fn);
+    removeDeadStores(fn);
+    removeUnusedValues(fn);
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "ir.hpp"
+
+/*
+    Optimisations of the IR of a function, between lowering and instruction selection.
+    optimiseFunction runs the ones enabled in pipeline.hpp, in the order listed there.
+*/
+void optimiseFunction(IRFunction* fn);
+
+// dominators of the blocks of a function, until its control flow graph changes
+class DominatorTree
+{
+public:
+    DominatorTree(IRFunction* fn);
+
+    // nullptr for the entry
+    IRBlock* idom(IRBlock* block) const;
+    bool dominates(IRBlock* a, IRBlock* b) const;
+    // reachable blocks, every block after its immediate dominator
+    const std::vector<IRBlock*>& reversePostorder() const;
+
+private:
+    std::vector<IRBlock*> order;
+    std::map<IRBlock*, int> numbers;
+    std::map<IRBlock*, IRBlock*> idoms;
+};
+
+// a natural loop, the blocks from which a back edge to its header can be reached without leaving it
+struct IRLoop {
+    IRBlock* header = nullptr;
+    std::set<IRBlock*> blocks;
+    // the only block outside the loop jumping to the header, and only to it
+    IRBlock* preheader = nullptr;
+};
+
+// loops that share a header are one loop, inner loops come before the loops containing them
+std::vector<IRLoop> findLoops(IRFunction* fn);
+
+/*
+    A memory access of a load or store: the stack slot or global it is known to be in if any,
+    and the bytes it touches when the offset into them is known.
+*/
+struct MemoryAccess {
+    IRInstr* object = nullptr;
+    bool knownOffset = false;
+    int offset = 0;
+    int size = 0;
+};
+
+MemoryAccess memoryAccess(IRInstr* instr);
+
+// stack slots whose address is used for anything other than loads and stores, by number
+std::set<int> escapedSlots(IRFunction* fn);
+
+// escaped slots can be accessed through any pointer and by any call
+bool mayAlias(const MemoryAccess& a, const MemoryAccess& b, const std::set<int>& escaped);
+bool callMayAccess(const MemoryAccess& access, const std::set<int>& escaped);
+
+/*
+    Loop invariant code motion. Computations whose operands don't change in a loop move
+    to its preheader, innermost loops first so they can keep moving out of the outer ones.
+    Only instructions that can't fault are moved since the loop might not run at all,
+    loads too when no store or call in the loop can write what they read.
+*/
+void hoistLoopInvariants(IRFunction* fn);
+
+/*
+    Global value numbering. Computations repeated in a block dominated by the one computing
+    them first reuse that value. Loads reuse the value of an earlier load or store of the
+    same address in their block if no store or call in between may have written it.
+*/
+void eliminateCommonSubexpressions(IRFunction* fn);
+
+/*
+    Strength reduction of induction variables. Addresses base + i * size of a counter i stepped by a
+    constant each iteration get a pointer of their own that is stepped along with it. When the counter
+    is then only used by the exit test, the test compares the pointer instead and the counter goes away.
+*/
+void reduceInductionVariables(IRFunction* fn);
+
+/*
+    Dead code elimination. Branches on constants become jumps and the blocks that can't be reached
+    anymore are removed, blocks only entered from the end of another one are merged into it.
+    Stores overwritten later in their block before anything can read them are removed,
+    as are stores to stack slots that are never read, and then every value nothing uses.
+*/
+void eliminateDeadCode(IRFunction* fn);
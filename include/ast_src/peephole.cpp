@@ -0,0 +1,337 @@
+#include "peephole.hpp"
+#include "pipeline.hpp"
+
+static bool isInstruction(const std::vector<AsmLine> &lines, int i, const std::string &op) {
+    return i >= 0 && i < (int)lines.size() && lines[i].kind == AsmLine::Kind::INSTRUCTION && lines[i].op == op;
+}
+
+static AsmLine makeInstruction(const std::string &op, const std::vector<std::string> &args) {
+    AsmLine line;
+    line.kind = AsmLine::Kind::INSTRUCTION;
+    line.op = op;
+    line.args = args;
+    return line;
+}
+
+static bool isStackAdjust(const AsmLine &line) {
+    return line.kind == AsmLine::Kind::INSTRUCTION && line.op == "addiu" && line.args.size() == 3
+        && line.args[0] == "$sp" && line.args[1] == "$sp";
+}
+
+// the move instruction for a register, "" if it isn't one that can be moved
+static std::string moveFor(const std::string &op) {
+    if (op == "lw" || op == "sw") {
+        return "move";
+    } else if (op == "l.s" || op == "s.s") {
+        return "mov.s";
+    } else if (op == "l.d" || op == "s.d") {
+        return "mov.d";
+    }
+    return "";
+}
+
+// format of the floating point value an instruction produces: 's', 'd' or 0
+static char resultFormat(const std::string &op) {
+    if (op == "l.s" || op == "lwc1" || op == "mtc1" || op.rfind("cvt.s.", 0) == 0) {
+        return 's';
+    } else if (op == "l.d" || op == "ldc1" || op.rfind("cvt.d.", 0) == 0) {
+        return 'd';
+    } else if (op.size() > 2 && op[op.size() - 2] == '.' && op.rfind("cvt.", 0) != 0 && op.rfind("c.", 0) != 0) {
+        char format = op.back();
+        return format == 's' || format == 'd' ? format : 0;
+    }
+    return 0;
+}
+
+// format of the floating point values an instruction reads
+static char operandFormat(const std::string &op) {
+    if (op == "mfc1" || op == "swc1") {
+        return 's';
+    } else if (op == "sdc1") {
+        return 'd';
+    } else if (op.size() > 2 && op[op.size() - 2] == '.') {
+        return op.back();
+    }
+    return 0;
+}
+
+// move $t0, $t0
+static bool removeSelfMove(std::vector<AsmLine> &lines, int i) {
+    const AsmLine &line = lines[i];
+    if ((line.op == "move" || line.op == "mov.s" || line.op == "mov.d") && line.args.size() == 2 && line.args[0] == line.args[1]) {
+        lines.erase(lines.begin() + i);
+        return true;
+    }
+    return false;
+}
+
+// addiu $t0, $t1, 0 => move $t0, $t1 and addiu $t0, $0, 5 => li $t0, 5
+static bool simplifyAddZero(std::vector<AsmLine> &lines, int i) {
+    AsmLine &line = lines[i];
+    if (line.args.size() != 3) {
+        return false;
+    }
+    const std::vector<std::string> &args = line.args;
+    if (line.op == "addiu" && args[2] == "0") {
+        line = makeInstruction("move", {args[0], args[1]});
+        return true;
+    }
+    if (line.op == "addiu" && args[1] == "$0") {
+        line = makeInstruction("li", {args[0], args[2]});
+        return true;
+    }
+    if ((line.op == "addu" || line.op == "or" || line.op == "subu") && args[2] == "$0") {
+        line = makeInstruction("move", {args[0], args[1]});
+        return true;
+    }
+    if ((line.op == "addu" || line.op == "or") && args[1] == "$0") {
+        line = makeInstruction("move", {args[0], args[2]});
+        return true;
+    }
+    return false;
+}
+
+// j L; nop; L:
+static bool removeBranchToNext(std::vector<AsmLine> &lines, int i) {
+    const AsmLine &line = lines[i];
+    if (!isBranch(line) || line.op == "jal" || line.op == "jr" || !isInstruction(lines, i + 1, "nop")) {
+        return false;
+    }
+    std::string target = branchTarget(line);
+    for (int k = i + 2; k < (int)lines.size(); k++) {
+        if (lines[k].kind == AsmLine::Kind::LABEL && lines[k].text == target) {
+            lines.erase(lines.begin() + i, lines.begin() + i + 2);
+            return true;
+        }
+        if (lines[k].kind == AsmLine::Kind::INSTRUCTION || lines[k].kind == AsmLine::Kind::DIRECTIVE) {
+            break;
+        }
+    }
+    return false;
+}
+
+// the instructions after a jump and its delay slot up to the next label, such as the code after a return
+static bool removeUnreachable(std::vector<AsmLine> &lines, int i) {
+    const std::string &op = lines[i].op;
+    if (op != "j" && op != "b" && op != "jr") {
+        return false;
+    }
+    int delaySlot = nextLine(lines, i, false);
+    if (delaySlot >= (int)lines.size() || lines[delaySlot].kind != AsmLine::Kind::INSTRUCTION) {
+        return false;
+    }
+    bool changed = false;
+    for (int k = nextLine(lines, delaySlot, false); k < (int)lines.size() && lines[k].kind == AsmLine::Kind::INSTRUCTION; k = nextLine(lines, k - 1, false)) {
+        lines.erase(lines.begin() + k);
+        changed = true;
+    }
+    return changed;
+}
+
+// a value spilled to the stack and immediately popped again (see pushReg and popReg)
+static bool removePushPop(std::vector<AsmLine> &lines, int i) {
+    int store = nextLine(lines, i, false);
+    int load = nextLine(lines, store, false);
+    int pop = nextLine(lines, load, false);
+    if (!isStackAdjust(lines[i]) || lines[i].args[2] != "-8" || pop >= (int)lines.size() || !isStackAdjust(lines[pop]) || lines[pop].args[2] != "8") {
+        return false;
+    }
+    const AsmLine &s = lines[store];
+    const AsmLine &l = lines[load];
+    if (s.kind != AsmLine::Kind::INSTRUCTION || l.kind != AsmLine::Kind::INSTRUCTION
+        || s.args.size() != 2 || l.args.size() != 2 || s.args[1] != "0($sp)" || l.args[1] != "0($sp)"
+        || !((s.op == "sw" && l.op == "lw") || (s.op == "s.d" && l.op == "l.d"))) {
+        return false;
+    }
+
+    AsmLine move = makeInstruction(moveFor(s.op), {l.args[0], s.args[0]});
+    lines.erase(lines.begin() + pop);
+    lines.erase(lines.begin() + load);
+    lines.erase(lines.begin() + store);
+    lines[i] = move;
+    return true;
+}
+
+// addiu $sp, $sp, -8; addiu $sp, $sp, -16
+static bool mergeStackAdjust(std::vector<AsmLine> &lines, int i) {
+    int next = nextLine(lines, i, false);
+    if (!isStackAdjust(lines[i]) || next >= (int)lines.size() || !isStackAdjust(lines[next])) {
+        return false;
+    }
+    int total = std::stoi(lines[i].args[2]) + std::stoi(lines[next].args[2]);
+    if (total < -32768 || total > 32767) {
+        return false;
+    }
+    lines.erase(lines.begin() + next);
+    if (total == 0) {
+        lines.erase(lines.begin() + i);
+    } else {
+        lines[i].args[2] = std::to_string(total);
+    }
+    return true;
+}
+
+// sw $t0, -8($fp); lw $t1, -8($fp) => sw $t0, -8($fp); move $t1, $t0
+static bool forwardStoreToLoad(std::vector<AsmLine> &lines, int i) {
+    int next = nextLine(lines, i, false);
+    if (next >= (int)lines.size()) {
+        return false;
+    }
+    const AsmLine &store = lines[i];
+    AsmLine &load = lines[next];
+    if (load.kind != AsmLine::Kind::INSTRUCTION || store.args.size() != 2 || load.args.size() != 2
+        || store.args[1] != load.args[1] || moveFor(store.op) == "" || moveFor(store.op) != moveFor(load.op)
+        || store.op[0] != 's' || load.op[0] != 'l') {
+        return false;
+    }
+    load = makeInstruction(moveFor(store.op), {load.args[0], store.args[0]});
+    return true;
+}
+
+// lw $t0, -8($fp); lw $t0, -8($fp)
+static bool removeRepeatedLoad(std::vector<AsmLine> &lines, int i) {
+    int next = nextLine(lines, i, false);
+    if (next >= (int)lines.size()) {
+        return false;
+    }
+    const AsmLine &first = lines[i];
+    const AsmLine &second = lines[next];
+    std::vector<std::string> reads, writes;
+    if (second.kind != AsmLine::Kind::INSTRUCTION || first.op != second.op || first.args != second.args
+        || moveFor(first.op) == "" || first.op[0] != 'l' || !instructionRegisters(first, reads, writes)
+        || std::find(reads.begin(), reads.end(), writes[0]) != reads.end()) {
+        return false;
+    }
+    lines.erase(lines.begin() + next);
+    return true;
+}
+
+static bool overlaps(const std::vector<std::string> &regs, const std::vector<std::string> &others) {
+    return std::find_first_of(regs.begin(), regs.end(), others.begin(), others.end()) != regs.end();
+}
+
+/*
+    move $t0, $s0 followed by reads of $t0 => the reads use $s0 directly.
+    The move is removed once $t0 isn't needed anymore.
+*/
+static bool propagateCopy(std::vector<AsmLine> &lines, int i) {
+    const AsmLine move = lines[i];
+    if ((move.op != "move" && move.op != "mov.s" && move.op != "mov.d") || move.args.size() != 2 || move.args[0] == move.args[1]
+        || move.args[0] == "$sp" || move.args[0] == "$fp" || move.args[0] == "$31") {
+        return false;
+    }
+    // a double copy is both registers of the pair
+    std::vector<std::string> reads, writes, sourceRegs, copyRegs;
+    instructionHalves(move, sourceRegs, copyRegs);
+    const std::string &copy = move.args[0];
+    const std::string &source = move.args[1];
+
+    bool changed = false;
+    bool dead = false;
+    int k = i;
+    while (true) {
+        k = nextLine(lines, k, false);
+        if (k >= (int)lines.size() || lines[k].kind != AsmLine::Kind::INSTRUCTION) {
+            dead = isDeadAt(lines, k, copyRegs);
+            break;
+        }
+        if (!instructionHalves(lines[k], reads, writes)) {
+            break;
+        }
+        if (overlaps(reads, copyRegs)) {
+            // a copy of a single can't be read as a double and the other way round
+            if ((move.op != "move" && operandFormat(lines[k].op) != move.op.back()) || !replaceReads(lines[k], copy, source)) {
+                break;
+            }
+            changed = true;
+        }
+        if (overlaps(writes, copyRegs)) {
+            // writing half of a double copy leaves the other half in use until it is written as well
+            dead = isDeadAt(lines, k, copyRegs);
+            break;
+        }
+        if (isBranch(lines[k])) {
+            dead = isDeadAt(lines, k, copyRegs);
+            break;
+        }
+        if (overlaps(writes, sourceRegs)) {
+            dead = isDeadAt(lines, k + 1, copyRegs);
+            break;
+        }
+    }
+
+    if (dead) {
+        lines.erase(lines.begin() + i);
+        return true;
+    }
+    return changed;
+}
+
+// addu $t0, $t1, $t2; move $s0, $t0 => addu $s0, $t1, $t2
+static bool coalesceMove(std::vector<AsmLine> &lines, int i) {
+    const AsmLine &move = lines[i];
+    if ((move.op != "move" && move.op != "mov.s" && move.op != "mov.d") || move.args.size() != 2 || move.args[0] == move.args[1]) {
+        return false;
+    }
+    int def = prevLine(lines, i, false);
+    if (def < 0 || lines[def].kind != AsmLine::Kind::INSTRUCTION || isBranch(lines[def])) {
+        return false;
+    }
+    // floating point values must have the format of the move
+    char format = resultFormat(lines[def].op);
+    if ((move.op == "move" && (format != 0 || move.args[1][1] == 'f')) || (move.op != "move" && format != move.op.back())) {
+        return false;
+    }
+
+    std::vector<std::string> reads, writes;
+    instructionHalves(move, reads, writes);
+    AsmLine rewritten = lines[def];
+    if (!replaceWrite(rewritten, move.args[1], move.args[0]) || !isDeadAt(lines, i + 1, reads)) {
+        return false;
+    }
+    lines[def] = rewritten;
+    lines.erase(lines.begin() + i);
+    return true;
+}
+
+const std::vector<Peephole::Rule> Peephole::rules = {
+    {"self-move", removeSelfMove},
+    {"add-zero", simplifyAddZero},
+    {"branch-to-next", removeBranchToNext},
+    {"unreachable", removeUnreachable},
+    {"push-pop", removePushPop},
+    {"merge-stack-adjust", mergeStackAdjust},
+    {"store-to-load", forwardStoreToLoad},
+    {"repeated-load", removeRepeatedLoad},
+    {"copy-propagation", propagateCopy},
+    {"coalesce-move", coalesceMove},
+};
+
+std::set<std::string> Peephole::disabledRules;
+std::map<std::string, int> Peephole::stats;
+
+void Peephole::optimise(std::vector<AsmLine> &lines) {
+    // a rule firing can create new opportunities for the others
+    bool changed = true;
+    for (int pass = 0; changed && pass < 16; pass++) {
+        changed = false;
+        for (int i = 0; i < (int)lines.size(); i++) {
+            if (lines[i].kind != AsmLine::Kind::INSTRUCTION) {
+                continue;
+            }
+            for (const Rule &rule : rules) {
+                if (disabledRules.count(rule.name) == 0 && rule.apply(lines, i)) {
+                    stats[rule.name]++;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void Peephole::reportStats() {
+    for (const Rule &rule : rules) {
+        Pipeline::remark("peephole", rule.name + " fired " + std::to_string(stats[rule.name]) + " times");
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "ast.hpp"
+
+#include <set>
+
+/*
+    Peephole optimisation of the assembly of a function (see assembly.hpp).
+
+    Every rule looks at the instruction on one line and the few lines around it
+    and rewrites them if they match its pattern. Rules are tried in order on every line
+    until none of them fire anymore.
+
+    The patterns are mostly waste at the boundaries between nodes, such as values
+    that are computed into a temporary only to be moved somewhere else.
+*/
+class Peephole
+{
+public:
+    struct Rule {
+        std::string name;
+        // returns true if the lines were changed
+        bool (*apply)(std::vector<AsmLine> &lines, int i);
+    };
+
+    static const std::vector<Rule> rules;
+
+    // set from the command line
+    static std::set<std::string> disabledRules;
+
+    static void optimise(std::vector<AsmLine> &lines);
+
+    // how many times each rule fired over the whole program, reported with -Rpass=peephole
+    static void reportStats();
+
+private:
+    static std::map<std::string, int> stats;
+};
@@ -0,0 +1,77 @@
+#include "pipeline.hpp"
+
+#include <iomanip>
+#include <stdexcept>
+
+const std::vector<Pipeline::Pass> Pipeline::passes = {
+    {"fold", "ast", "evaluate constant expressions at compile time", {"O1", "O2", "Os"}},
+    {"regalloc", "ast", "keep scalar locals in registers instead of the frame", {"O1", "O2", "Os"}},
+    {"leaf-frames", "ast", "leave out the frame and $31 of functions that don't need them", {"O1", "O2", "Os"}},
+    {"arg-regs", "ast", "evaluate call arguments straight into their argument registers", {"O1", "O2", "Os"}},
+    {"tail-calls", "ast", "turn calls in tail position into jumps", {"O2", "Os"}},
+    {"ir", "ir", "compile functions through the SSA IR instead of straight from the AST", {"O1", "O2", "Os"}},
+    {"inline", "ir", "substitute the bodies of small functions for calls of them", {"O2", "Os"}},
+    {"licm", "ir", "move loop invariant computations out of loops", {"O1", "O2", "Os"}},
+    {"cse", "ir", "reuse repeated computations and loads instead of doing them again", {"O1", "O2", "Os"}},
+    {"induction-vars", "ir", "walk arrays in loops with pointers instead of indexing them", {"O2", "Os"}},
+    {"dce", "ir", "remove unreachable blocks, dead stores and unused computations", {"O1", "O2", "Os"}},
+    {"strength-reduce", "isel", "multiply and divide by constants with shifts and adds", {"O1", "O2"}},
+    {"peephole", "asm", "rewrite short sequences of instructions (see peephole.hpp)", {"O1", "O2", "Os"}},
+    {"delay-slots", "asm", "fill branch delay slots with useful instructions", {"O1", "O2", "Os"}},
+};
+
+std::string Pipeline::level = "O2";
+std::map<std::string, bool> Pipeline::overrides;
+std::set<std::string> Pipeline::remarks;
+std::set<std::string> Pipeline::missedRemarks;
+
+const Pipeline::Pass& Pipeline::find(const std::string &name) {
+    for (const Pass &pass : passes) {
+        if (pass.name == name) {
+            return pass;
+        }
+    }
+    throw std::runtime_error("Unknown pass " + name + "\n");
+}
+
+void Pipeline::setLevel(const std::string &_level) {
+    if (_level != "O" && _level != "O0" && _level != "O1" && _level != "O2" && _level != "Os") {
+        throw std::runtime_error("Unknown optimisation level -" + _level + "\n");
+    }
+    // -O on its own is -O1, like in gcc
+    level = _level == "O" ? "O1" : _level;
+}
+
+void Pipeline::setPass(const std::string &name, bool enabled) {
+    overrides[find(name).name] = enabled;
+}
+
+bool Pipeline::isEnabled(const std::string &name) {
+    auto it = overrides.find(name);
+    if (it != overrides.end()) {
+        return it->second;
+    }
+    return find(name).levels.count(level) != 0;
+}
+
+const std::string& Pipeline::getLevel() {
+    return level;
+}
+
+void Pipeline::enableRemarks(const std::string &name, bool missed) {
+    (missed ? missedRemarks : remarks).insert(find(name).name);
+}
+
+void Pipeline::remark(const std::string &name, const std::string &message, bool missed) {
+    if ((missed ? missedRemarks : remarks).count(name) != 0) {
+        std::cerr << "remark: " << message << " [-Rpass" << (missed ? "-missed=" : "=") << name << "]" << std::endl;
+    }
+}
+
+void Pipeline::print(std::ostream &out) {
+    out << "-" << level << std::endl;
+    for (const Pass &pass : passes) {
+        out << std::left << std::setw(18) << pass.name << std::setw(6) << pass.stage
+            << std::setw(5) << (isEnabled(pass.name) ? "on" : "off") << pass.description << std::endl;
+    }
+}
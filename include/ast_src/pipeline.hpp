@@ -0,0 +1,54 @@
+#pragma once
+
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/*
+    The optimisation passes of the compiler and the options choosing which of them run.
+
+    Passes are listed in the order they run in. -O1, -O2 and -Os enable the passes of
+    their level (-O is -O1), -O0 none of them, -f<pass> and -fno-<pass> turn a single pass on or off whatever the level,
+    independently of where they are on the command line. Without a level -O2 is used.
+*/
+class Pipeline
+{
+public:
+    struct Pass {
+        std::string name;
+        // what the pass works on: ast, ir, isel or asm
+        std::string stage;
+        std::string description;
+        // levels that enable the pass
+        std::set<std::string> levels;
+    };
+
+    static const std::vector<Pass> passes;
+
+    // these throw for levels and passes that don't exist
+    static void setLevel(const std::string &level);
+    static void setPass(const std::string &name, bool enabled);
+
+    static bool isEnabled(const std::string &name);
+    static const std::string& getLevel();
+
+    /*
+        -Rpass=<pass> and -Rpass-missed=<pass> write remarks to stderr about what a pass did
+        and what it decided not to do.
+    */
+    static void enableRemarks(const std::string &name, bool missed);
+    static void remark(const std::string &name, const std::string &message, bool missed = false);
+
+    // the passes in order, and whether they run with the current options
+    static void print(std::ostream &out);
+
+private:
+    static std::string level;
+    static std::map<std::string, bool> overrides;
+    static std::set<std::string> remarks;
+    static std::set<std::string> missedRemarks;
+
+    static const Pass& find(const std::string &name);
+};
@@ -1,4 +1,5 @@
 #include "primitive.hpp"
+#include "ir.hpp"
 
 AST_ConstInt::AST_ConstInt(int _value):
     value(_value)
@@ -13,24 +14,27 @@ AST* AST_ConstInt::deepCopy(){
 }
 
 void AST_ConstInt::compile(std::ostream &assemblyOut){
-    assemblyOut << std::endl << "# start const int " << value << std::endl;
-    
-    // load constant into register
-    assemblyOut << "addiu $t0, $0, " << value << std::endl;
+    compileAndDiscard(assemblyOut);
+}
+
+void AST_ConstInt::compileToReg(std::ostream &assemblyOut, const std::string &reg){
+    assemblyOut << "# const int " << value << std::endl;
+    assemblyOut << "li " << reg << ", " << value << std::endl;
+}
 
-    // store constant to top of stack
-    assemblyOut << "sw $t0, 0($sp)" << std::endl;
-    assemblyOut << "addiu $sp, $sp, -8" << std::endl;
+IRInstr* AST_ConstInt::lowerToValue(IRBuilder &builder){
+    return builder.constant(value);
+}
 
-    assemblyOut << "# end const int " << value << std::endl << std::endl;
+bool AST_ConstInt::hasSideEffects(){
+    return false;
 }
 
-AST* AST_ConstInt::getType() {
-    std::string typeName = "int";
-    return new AST_Type(&typeName);
+AST* AST_ConstInt::computeType() {
+    return AST_Type::get(TypeKind::INT);
 }
 
-std::string AST_ConstInt::getTypeName(){
+std::string AST_ConstInt::computeTypeName(){
     return "int";
 }
 
@@ -51,24 +55,27 @@ AST* AST_ConstFloat::deepCopy(){
 }
 
 void AST_ConstFloat::compile(std::ostream &assemblyOut){
-    assemblyOut << std::endl << "# start const float " << value << std::endl;
+    compileAndDiscard(assemblyOut);
+}
 
-    // load constant into register
-    assemblyOut << "li.s $f4, " << value << std::endl;
+void AST_ConstFloat::compileToReg(std::ostream &assemblyOut, const std::string &reg){
+    assemblyOut << "# const float " << value << std::endl;
+    assemblyOut << "li.s " << reg << ", " << value << std::endl;
+}
 
-    // store constant to top of stack
-    assemblyOut << "s.s $f4, 0($sp)" << std::endl;
-    assemblyOut << "addiu $sp, $sp, -8" << std::endl;
+IRInstr* AST_ConstFloat::lowerToValue(IRBuilder &builder){
+    return builder.constant(IRType::FLOAT, value);
+}
 
-    assemblyOut << "# end const float " << value << std::endl << std::endl;
+bool AST_ConstFloat::hasSideEffects(){
+    return false;
 }
 
-AST* AST_ConstFloat::getType() {
-    std::string typeName = "float";
-    return new AST_Type(&typeName);
+AST* AST_ConstFloat::computeType() {
+    return AST_Type::get(TypeKind::FLOAT);
 }
 
-std::string AST_ConstFloat::getTypeName(){
+std::string AST_ConstFloat::computeTypeName(){
     return "float";
 }
 
@@ -89,24 +96,27 @@ AST* AST_ConstDouble::deepCopy(){
 }
 
 void AST_ConstDouble::compile(std::ostream &assemblyOut){
-    assemblyOut << std::endl << "# start const double " << value << std::endl;
+    compileAndDiscard(assemblyOut);
+}
 
-    // load constant into register
-    assemblyOut << "li.d $f4, " << value << std::endl;
+void AST_ConstDouble::compileToReg(std::ostream &assemblyOut, const std::string &reg){
+    assemblyOut << "# const double " << value << std::endl;
+    assemblyOut << "li.d " << reg << ", " << value << std::endl;
+}
 
-    // store constant to top of stack
-    assemblyOut << "s.d $f4, 0($sp)" << std::endl;
-    assemblyOut << "addiu $sp, $sp, -8" << std::endl;
+IRInstr* AST_ConstDouble::lowerToValue(IRBuilder &builder){
+    return builder.constant(IRType::DOUBLE, value);
+}
 
-    assemblyOut << "# end const double " << value << std::endl << std::endl;
+bool AST_ConstDouble::hasSideEffects(){
+    return false;
 }
 
-AST* AST_ConstDouble::getType() {
-    std::string typeName = "double";
-    return new AST_Type(&typeName);
+AST* AST_ConstDouble::computeType() {
+    return AST_Type::get(TypeKind::DOUBLE);
 }
 
-std::string AST_ConstDouble::getTypeName(){
+std::string AST_ConstDouble::computeTypeName(){
     return "double";
 }
 
@@ -127,28 +137,31 @@ AST* AST_ConstChar::deepCopy(){
 }
 
 void AST_ConstChar::compile(std::ostream &assemblyOut){
-    assemblyOut << std::endl << "# start const char (" << (int)value << ")" << std::endl;
-    
-    // load constant into register
-    assemblyOut << "li $t0, " << (int)value << std::endl;
+    compileAndDiscard(assemblyOut);
+}
 
-    // store constant to top of stack
-    assemblyOut << "sw $t0, 0($sp)" << std::endl;
-    assemblyOut << "addiu $sp, $sp, -8" << std::endl;
+void AST_ConstChar::compileToReg(std::ostream &assemblyOut, const std::string &reg){
+    assemblyOut << "# const char (" << (int)value << ")" << std::endl;
+    assemblyOut << "li " << reg << ", " << (int)value << std::endl;
+}
 
-    assemblyOut << "# end const char (" << (int)value << ")" << std::endl << std::endl;
+IRInstr* AST_ConstChar::lowerToValue(IRBuilder &builder){
+    return builder.constant((int)value);
 }
 
-AST* AST_ConstChar::getType() {
-    std::string typeName = "char";
-    return new AST_Type(&typeName);
+bool AST_ConstChar::hasSideEffects(){
+    return false;
+}
+
+AST* AST_ConstChar::computeType() {
+    return AST_Type::get(TypeKind::CHAR);
 }
 
 int AST_ConstChar::getIntValue() {
     return value;
 }
 
-AST_ConstStr::AST_ConstStr(std::string* _value):
+AST_ConstStr::AST_ConstStr(const std::string* _value):
     value(*_value)
 { }
 
@@ -161,6 +174,10 @@ AST* AST_ConstStr::deepCopy(){
 }
 
 void AST_ConstStr::compile(std::ostream &assemblyOut){
+    compileAndDiscard(assemblyOut);
+}
+
+void AST_ConstStr::compileToReg(std::ostream &assemblyOut, const std::string &reg){
     std::string label = generateUniqueLabel("$LC");
     
     assemblyOut << std::endl << "# start const str '" << value << "'" << std::endl;
@@ -174,18 +191,25 @@ void AST_ConstStr::compile(std::ostream &assemblyOut){
     assemblyOut << ".text" << std::endl;
     assemblyOut << ".align 2" << std::endl;
 
-    assemblyOut << "lui $t0, %hi(" << label << ")" << std::endl;
-    assemblyOut << "addiu $t0, %lo(" << label << ")" << std::endl;
-    assemblyOut << "sw $t0, 0($sp)" << std::endl;
-    assemblyOut << "addiu $sp, $sp, -8" << std::endl;
+    assemblyOut << "lui " << reg << ", %hi(" << label << ")" << std::endl;
+    assemblyOut << "addiu " << reg << ", " << reg << ", %lo(" << label << ")" << std::endl;
+}
+
+IRInstr* AST_ConstStr::lowerToValue(IRBuilder &builder){
+    IRInstr* address = builder.emit(IROp::STRING, IRType::WORD);
+    address->name = value;
+    return address;
+}
+
+bool AST_ConstStr::hasSideEffects(){
+    return false;
 }
 
-AST* AST_ConstStr::getType(){
-    std::string typeName = "pointer";
-    return new AST_Type(&typeName);
+AST* AST_ConstStr::computeType(){
+    return new AST_Pointer(AST_Type::get(TypeKind::CHAR));
 }
 
-AST_Variable::AST_Variable(std::string* _name) :
+AST_Variable::AST_Variable(const std::string* _name) :
     name(*_name)
 {
     isVar = true;
@@ -193,6 +217,9 @@ AST_Variable::AST_Variable(std::string* _name) :
 
 void AST_Variable::generateFrames(Frame* _frame){
     frame = _frame;
+    if (RegisterAllocator::current != nullptr) {
+        RegisterAllocator::current->referenceVariable(_frame, name);
+    }
 }
 
 AST* AST_Variable::deepCopy(){
@@ -200,54 +227,57 @@ AST* AST_Variable::deepCopy(){
 }
 
 void AST_Variable::compile(std::ostream &assemblyOut) {
-    std::string varType = this->getType()->getTypeName();
+    compileAndDiscard(assemblyOut);
+}
 
-    assemblyOut << std::endl << "# start " << varType << " variable read " << name << std::endl;
+void AST_Variable::compileToReg(std::ostream &assemblyOut, const std::string &reg) {
+    TypeKind varType = this->getType()->getTypeKind();
 
-    // if left of assign load address otherwise load value
-    if(returnPtr || (frame->getVarAddress(name).first == -1 && varType == "pointer")){
-        assemblyOut << "# (reading address)" << std::endl;
-        
-        varAddressToReg(assemblyOut, frame, "$t0", name);
+    assemblyOut << "# " << this->getType()->getTypeName() << " variable read " << name << std::endl;
 
-        // store value in memory
-        assemblyOut << "sw $t0, 0($sp)" << std::endl;
+    // if left of assign load address otherwise load value
+    if(returnPtr || (frame->getVarAddress(name).first == -1 && varType == TypeKind::POINTER)){
+        varAddressToReg(assemblyOut, frame, reg, name);
     }
-    else{   
-        assemblyOut << "# (reading value)" << std::endl;
-
-        if (varType == "float") {
-            varToReg(assemblyOut, frame, "$f4", name);
-
-            // store value in memory
-            assemblyOut << "s.s $f4, 0($sp)" << std::endl;
-        } else if (varType == "double") {
-            varToReg(assemblyOut, frame, "$f4", name);
-
-            // store value in memory
-            assemblyOut << "s.d $f4, 0($sp)" << std::endl;
-        } else {
-            varToReg(assemblyOut, frame, "$t0", name);
+    else{
+        varToReg(assemblyOut, frame, reg, name);
+    }
+}
 
-            // store value in memory
-            assemblyOut << "sw $t0, 0($sp)" << std::endl;
-        }
+IRInstr* AST_Variable::lowerToValue(IRBuilder &builder) {
+    // global arrays are read as their address, see compileToReg
+    TypeKind varType = this->getType()->getTypeKind();
+    if(returnPtr || (frame->getVarAddress(name).first == -1 && varType == TypeKind::POINTER)){
+        return builder.variableAddress(frame, name);
     }
+    return builder.readVariable(frame, name);
+}
 
-    assemblyOut << "addiu $sp, $sp, -8" << std::endl;
+bool AST_Variable::hasSideEffects(){
+    return false;
+}
 
-    assemblyOut << "# end " << varType << " variable read " << name << std::endl << std::endl;
+AST* AST_Variable::fold(){
+    int value;
+    if (!returnPtr && frame->getEnumConstant(name, value)) {
+        return makeConstant(this, value);
+    }
+    return this;
 }
 
-AST* AST_Variable::getType(){
+AST* AST_Variable::computeType(){
     return frame->getVarType(name);
 }
 
+std::string AST_Variable::getName(){
+    return name;
+}
+
 int AST_Variable::getBytes(){
     return getType()->getBytes();
 }
 
-std::string AST_Variable::getTypeName() {
+std::string AST_Variable::computeTypeName() {
     return getType()->getTypeName();
 }
 
@@ -259,14 +289,20 @@ void AST_Variable::updateVariable(std::ostream &assemblyOut, Frame* currentFrame
     assemblyOut << "# end var update " << name << std::endl << std::endl;
 }
 
-AST_Type::AST_Type(std::string* _name) :
-    name(*_name)
+void AST_Variable::lowerUpdate(IRBuilder &builder, IRInstr* value) {
+    builder.writeVariable(frame, name, value);
+}
+
+AST_Type::AST_Type(const std::string* _name) :
+    name(*_name),
+    kind(kindOf(*_name))
 {
-    bytes = size_of_type[*_name];
+    bytes = builtins.at(*_name).bytes;
 }
 
-AST_Type::AST_Type(std::string* _name, const std::map<std::string, std::string> &attributeNameTypeMap) :
-     name(*_name)
+AST_Type::AST_Type(const std::string* _name, const std::map<std::string, std::string> &attributeNameTypeMap) :
+     name(*_name),
+     kind(kindOf(*_name))
 {
     bytes = 0;
     for (auto attribute : attributeNameTypeMap) {
@@ -276,26 +312,51 @@ AST_Type::AST_Type(std::string* _name, const std::map<std::string, std::string>
             // array
             std::string typeName = attribute.second.substr(0, attribute.second.find("*"));
             int size = std::stoi(attribute.second.substr(attribute.second.find("*")+1));
-            bytes += size_of_type[typeName] * size;
+            bytes += builtins.at(typeName).bytes * size;
         } else if (attribute.second == "char") {
-            // size_of_type map contains incorrect char size
+            // builtins contains incorrect char size
             bytes += 1;
         } else {
-            bytes += size_of_type[attribute.second];
+            bytes += builtins.at(attribute.second).bytes;
         }
     }
 }
 
-std::unordered_map<std::string, int> AST_Type::size_of_type = {
-    {"int", 4}, // Intentionally wrong so that char can be treated as int for binary/unary operations (e.g. using lw instead of lb)
-    {"char", 1},
-    {"float", 4},
-    {"double", 8},
-    {"unsigned", 4},
-    {"void", 4},
-    {"struct", -1}, // Size needs to be computed dynamically
+const std::unordered_map<std::string, AST_Type::Builtin> AST_Type::builtins = {
+    {"int", {TypeKind::INT, 4}}, // Intentionally wrong so that char can be treated as int for binary/unary operations (e.g. using lw instead of lb)
+    {"char", {TypeKind::CHAR, 1}},
+    {"float", {TypeKind::FLOAT, 4}},
+    {"double", {TypeKind::DOUBLE, 8}},
+    {"unsigned", {TypeKind::UNSIGNED, 4}},
+    {"void", {TypeKind::VOID, 4}},
+    {"pointer", {TypeKind::POINTER, 4}},
+    {"struct", {TypeKind::STRUCT, -1}}, // Size needs to be computed dynamically
 };
 
+AST_Type* AST_Type::get(TypeKind kind) {
+    static std::map<TypeKind, AST_Type*> canonical;
+    AST_Type*& type = canonical[kind];
+    if (type == nullptr) {
+        for (const auto& builtin : builtins) {
+            if (builtin.second.kind == kind && kind != TypeKind::POINTER && kind != TypeKind::STRUCT) {
+                type = new AST_Type(Symbols::intern(builtin.first));
+            }
+        }
+        if (type == nullptr) {
+            throw std::runtime_error("AST_Type: get: pointers and structs have no shared type.\n");
+        }
+    }
+    return type;
+}
+
+TypeKind AST_Type::kindOf(const std::string &name) {
+    auto builtin = builtins.find(name);
+    if (builtin == builtins.end()) {
+        throw std::runtime_error("AST_Type: Unknown type " + name + ".\n");
+    }
+    return builtin->second.kind;
+}
+
 void AST_Type::generateFrames(Frame* _frame){
     frame = _frame;
 }
@@ -312,7 +373,7 @@ int AST_Type::getBytes(){
     return bytes;
 }
 
-std::string AST_Type::getTypeName() {
+std::string AST_Type::computeTypeName() {
     return name;
 }
 
@@ -320,7 +381,7 @@ AST_ArrayType::AST_ArrayType(AST* _type, int _size) :
     type(_type),
     size(_size)
 {
-    if (_type->getTypeName() == "char") {
+    if (_type->getTypeKind() == TypeKind::CHAR) {
         bytes = size;
     } else {
         bytes = _type->getBytes() * size;
@@ -341,7 +402,7 @@ void AST_ArrayType::compile(std::ostream &assemblyOut) {
     throw std::runtime_error("ArrayType should never be compiled.\n");
 }
 
-AST* AST_ArrayType::getType(){
+AST* AST_ArrayType::computeType(){
     return type;
 }
 
@@ -349,7 +410,7 @@ int AST_ArrayType::getBytes(){
     return bytes;
 }
 
-std::string AST_ArrayType::getTypeName(){
+std::string AST_ArrayType::computeTypeName(){
     return "pointer";
 }
 
@@ -357,10 +418,6 @@ int AST_ArrayType::getSize() {
     return this->size;
 }
 
-AST_ArrayType::~AST_ArrayType(){
-    delete type;
-}
-
 AST_Pointer::AST_Pointer(AST* _type) :
     type(_type)
 {}
@@ -379,7 +436,7 @@ void AST_Pointer::compile(std::ostream &assemblyOut) {
     throw std::runtime_error("PointerType should never be compiled.\n");
 }
 
-AST* AST_Pointer::getType(){
+AST* AST_Pointer::computeType(){
     return type;
 }
 
@@ -387,14 +444,10 @@ int AST_Pointer::getBytes(){
     return 4;
 }
 
-std::string AST_Pointer::getTypeName(){
+std::string AST_Pointer::computeTypeName(){
     return "pointer";
 }
 
-AST_Pointer::~AST_Pointer(){
-    delete type;
-}
-
 void AST_NoEffect::generateFrames(Frame* _frame) {
      frame = _frame;
 }
@@ -402,3 +455,6 @@ void AST_NoEffect::generateFrames(Frame* _frame) {
 void AST_NoEffect::compile(std::ostream &assemblyOut) {
     // Do nothing 
 }
+
+void AST_NoEffect::lower(IRBuilder &builder) {
+}
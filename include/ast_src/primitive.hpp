@@ -16,8 +16,11 @@ public:
     void generateFrames(Frame* _frame = nullptr) override;
     AST* deepCopy() override;
     void compile(std::ostream &assemblyOut) override;
-    AST* getType() override;
-    std::string getTypeName() override;
+    void compileToReg(std::ostream &assemblyOut, const std::string &reg) override;
+    IRInstr* lowerToValue(IRBuilder &builder) override;
+    bool hasSideEffects() override;
+    AST* computeType() override;
+    std::string computeTypeName() override;
 
     int getIntValue() override;
 };
@@ -33,8 +36,11 @@ public:
     void generateFrames(Frame* _frame = nullptr) override;
     AST* deepCopy() override;
     void compile(std::ostream &assemblyOut) override;
-    AST* getType() override;
-    std::string getTypeName() override;
+    void compileToReg(std::ostream &assemblyOut, const std::string &reg) override;
+    IRInstr* lowerToValue(IRBuilder &builder) override;
+    bool hasSideEffects() override;
+    AST* computeType() override;
+    std::string computeTypeName() override;
 
     float getFloatValue() override;
 };
@@ -50,8 +56,11 @@ public:
     void generateFrames(Frame* _frame = nullptr) override;
     AST* deepCopy() override;
     void compile(std::ostream &assemblyOut) override;
-    AST* getType() override;
-    std::string getTypeName() override;
+    void compileToReg(std::ostream &assemblyOut, const std::string &reg) override;
+    IRInstr* lowerToValue(IRBuilder &builder) override;
+    bool hasSideEffects() override;
+    AST* computeType() override;
+    std::string computeTypeName() override;
 
     double getDoubleValue() override;
 };
@@ -67,7 +76,10 @@ public:
     void generateFrames(Frame* _frame = nullptr) override;
     AST* deepCopy() override;
     void compile(std::ostream &assemblyOut) override;
-    AST* getType() override;
+    void compileToReg(std::ostream &assemblyOut, const std::string &reg) override;
+    IRInstr* lowerToValue(IRBuilder &builder) override;
+    bool hasSideEffects() override;
+    AST* computeType() override;
 
     int getIntValue() override;
 };
@@ -76,31 +88,38 @@ class AST_ConstStr
     : public AST
 {
 private:
-    std::string value;
+    const std::string &value;
 public:
-    AST_ConstStr(std::string* _value);
+    AST_ConstStr(const std::string* _value);
 
     void generateFrames(Frame* _frame = nullptr) override;
     AST* deepCopy() override;
     void compile(std::ostream &assemblyOut) override;
-    AST* getType() override;
+    void compileToReg(std::ostream &assemblyOut, const std::string &reg) override;
+    IRInstr* lowerToValue(IRBuilder &builder) override;
+    bool hasSideEffects() override;
+    AST* computeType() override;
 };
 
 class AST_Variable
     : public AST
 {
 private:
-    std::string name;
+    const std::string &name;
 
 public:
-    AST_Variable(std::string* _name);
+    AST_Variable(const std::string* _name);
 
     void generateFrames(Frame* _frame = nullptr) override;
     AST* deepCopy() override;
     void compile(std::ostream &assemblyOut) override;
-    AST* getType() override;
+    AST* fold() override;
+    void compileToReg(std::ostream &assemblyOut, const std::string &reg) override;
+    bool hasSideEffects() override;
+    AST* computeType() override;
     int getBytes() override;
-    std::string getTypeName() override;
+    std::string computeTypeName() override;
+    std::string getName() override;
 
     /*
         reg is the register that contains the new value.
@@ -108,27 +127,45 @@ public:
         Example: If register is $v0, then reg = "$v0".
     */
     void updateVariable(std::ostream &assemblyOut, Frame* currentFrame, std::string reg) override;
+
+    IRInstr* lowerToValue(IRBuilder &builder) override;
+    void lowerUpdate(IRBuilder &builder, IRInstr* value) override;
 };
 
 class AST_Type
     : public AST
 {
 private:
-    std::string name;
+    const std::string &name;
+    TypeKind kind;
     int bytes;
+
+    struct Builtin {
+        TypeKind kind;
+        int bytes;
+    };
+    // kind and size of the type names, struct sizes are computed from their members
+    static const std::unordered_map<std::string, Builtin> builtins;
+
 public:
-    AST_Type(std::string* name);
+    AST_Type(const std::string* name);
 
     // Used for struct type
-    AST_Type(std::string* name, const std::map<std::string, std::string> &attributeNameTypeMap);
+    AST_Type(const std::string* name, const std::map<std::string, std::string> &attributeNameTypeMap);
+
+    /*
+        The node of a built in type (INT to VOID), shared by everything of that type,
+        so these types are the same exactly when they are the same pointer.
+    */
+    static AST_Type* get(TypeKind kind);
+    // throws for names that aren't types
+    static TypeKind kindOf(const std::string &name);
 
-    static std::unordered_map<std::string, int> size_of_type;
-    
     void generateFrames(Frame* _frame = nullptr) override;
     AST* deepCopy() override;
     void compile(std::ostream &assemblyOut) override;
     int getBytes() override;
-    std::string getTypeName() override;
+    std::string computeTypeName() override;
 };
 
 class AST_ArrayType
@@ -144,12 +181,10 @@ public:
     void generateFrames(Frame* _frame = nullptr) override;
     AST* deepCopy() override;
     void compile(std::ostream &assemblyOut) override;
-    AST* getType() override;
+    AST* computeType() override;
     int getBytes() override;
-    std::string getTypeName() override;
+    std::string computeTypeName() override;
     int getSize() override;
-
-    ~AST_ArrayType();
 };
 
 class AST_Pointer
@@ -163,11 +198,9 @@ public:
     void generateFrames(Frame* _frame = nullptr) override;
     AST* deepCopy() override;
     void compile(std::ostream &assemblyOut) override;
-    AST* getType() override;
+    AST* computeType() override;
     int getBytes() override;
-    std::string getTypeName() override;
-
-    ~AST_Pointer();
+    std::string computeTypeName() override;
 };
 
 // For parser
@@ -177,4 +210,5 @@ class AST_NoEffect
 public:
     void generateFrames(Frame* _frame = nullptr) override;
     void compile(std::ostream &assemblyOut) override;
+    void lower(IRBuilder &builder) override;
 };
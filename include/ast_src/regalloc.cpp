@@ -0,0 +1,309 @@
+#include "regalloc.hpp"
+#include "expression.hpp"
+#include "pipeline.hpp"
+
+#include <iomanip>
+
+RegisterAllocator* RegisterAllocator::current = nullptr;
+
+const std::vector<std::string> RegisterAllocator::intRegs = {
+    "$s0", "$s1", "$s2", "$s3", "$s4", "$s5", "$s6", "$s7"
+};
+// doubles need an even/odd pair so only even registers are used
+const std::vector<std::string> RegisterAllocator::floatRegs = {
+    "$f20", "$f22", "$f24", "$f26", "$f28", "$f30"
+};
+
+void RegisterAllocator::declareVariable(Frame* frame, const std::string& name, AST* type, bool isParameter) {
+    TypeKind kind = type->getTypeKind();
+    if (kind == TypeKind::INT || kind == TypeKind::UNSIGNED || kind == TypeKind::CHAR || kind == TypeKind::POINTER) {
+        candidates[{frame, name}] = false;
+    } else if (kind == TypeKind::FLOAT || kind == TypeKind::DOUBLE) {
+        candidates[{frame, name}] = true;
+    }
+
+    references.push_back({frame, name, isParameter ? 0 : point++});
+}
+
+void RegisterAllocator::addVariable(Frame* frame, const std::string& name) {
+    variables.push_back({frame, name});
+}
+
+void RegisterAllocator::setParameterRegister(Frame* frame, const std::string& name, const std::string& reg) {
+    parameterRegs[{frame, name}] = reg;
+}
+
+void RegisterAllocator::setArgumentRegisters(const std::vector<std::string>& regs) {
+    argumentRegs = regs;
+}
+
+void RegisterAllocator::recordCall(AST_FunctionCall* call) {
+    calls.push_back(call);
+}
+
+void RegisterAllocator::referenceVariable(Frame* frame, const std::string& name) {
+    references.push_back({frame, name, point++});
+}
+
+void RegisterAllocator::takeAddress(Frame* frame, const std::string& name) {
+    addressReferences.push_back({frame, name, point++});
+}
+
+void RegisterAllocator::startLoop() {
+    openLoops.push_back(point++);
+}
+
+void RegisterAllocator::endLoop() {
+    loops.push_back({openLoops.back(), point++});
+    openLoops.pop_back();
+}
+
+void RegisterAllocator::allocate(Frame* fnFrame) {
+    // variables can only be resolved now since parameters are added after the body
+    for (const Reference& reference : addressReferences) {
+        Frame* varFrame = reference.frame->getVarFrame(reference.name);
+        candidates.erase({varFrame, reference.name});
+        if (varFrame != nullptr) {
+            varFrame->setAddressTaken(reference.name);
+        }
+    }
+
+    // everything that isn't a candidate anymore has to stay in memory
+    for (const std::pair<Frame*, std::string>& variable : variables) {
+        if (candidates.count(variable) == 0) {
+            fnFrame->hasAddressedLocals = true;
+        }
+    }
+
+    // with -fno-regalloc every variable lives in the frame
+    if (!Pipeline::isEnabled("regalloc")) {
+        candidates.clear();
+    }
+
+    for (AST_FunctionCall* call : calls) {
+        if (!call->isTailCall || !call->canTailCall(fnFrame)) {
+            hasCalls = true;
+        } else if (call->getName() == fnFrame->fn->getName() && fnFrame->tailCallLabel == "") {
+            fnFrame->tailCallLabel = generateUniqueLabel("tailCall");
+        }
+    }
+
+    // nothing overwrites the argument registers if there are no calls
+    if (!hasCalls) {
+        for (const auto& parameterReg : parameterRegs) {
+            auto candidate = candidates.find(parameterReg.first);
+            if (candidate != candidates.end() && parameterReg.second != "" && candidate->second == (parameterReg.second[1] == 'f')) {
+                parameterReg.first.first->setVarReg(parameterReg.first.second, parameterReg.second);
+                candidates.erase(candidate);
+            }
+        }
+    }
+
+    std::map<std::pair<Frame*, std::string>, LiveRange> ranges;
+    for (const Reference& reference : references) {
+        std::pair<Frame*, std::string> key = {reference.frame->getVarFrame(reference.name), reference.name};
+        auto candidate = candidates.find(key);
+        if (candidate == candidates.end()) {
+            continue;
+        }
+
+        auto it = ranges.find(key);
+        if (it == ranges.end()) {
+            ranges[key] = {key.first, key.second, candidate->second, reference.point, reference.point};
+        } else {
+            it->second.start = std::min(it->second.start, reference.point);
+            it->second.end = std::max(it->second.end, reference.point);
+        }
+    }
+
+    // a variable defined before a loop and used inside it is live until the loop ends
+    std::vector<LiveRange> sortedRanges;
+    for (auto& range : ranges) {
+        LiveRange& liveRange = range.second;
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (const std::pair<int, int>& loop : loops) {
+                if (liveRange.start < loop.first && liveRange.end > loop.first && liveRange.end < loop.second) {
+                    liveRange.end = loop.second;
+                    changed = true;
+                }
+            }
+        }
+        sortedRanges.push_back(liveRange);
+    }
+    std::sort(sortedRanges.begin(), sortedRanges.end(), [](const LiveRange& a, const LiveRange& b) {
+        return a.start < b.start;
+    });
+
+    // linear scan, done separately for both register kinds
+    // caller saved registers don't have to be preserved, but only functions without calls can use them
+    std::vector<std::string> leafRegs;
+    if (!hasCalls && Pipeline::isEnabled("leaf-frames")) {
+        for (const char* reg : {"$v1", "$a0", "$a1", "$a2", "$a3"}) {
+            if (std::find(argumentRegs.begin(), argumentRegs.end(), reg) == argumentRegs.end()) {
+                leafRegs.push_back(reg);
+            }
+        }
+    }
+
+    std::vector<std::string> usedRegs;
+    for (bool isFloat : {false, true}) {
+        std::vector<std::string> regs = isFloat ? floatRegs : leafRegs;
+        if (!isFloat) {
+            regs.insert(regs.end(), intRegs.begin(), intRegs.end());
+        }
+        std::vector<std::string> freeRegs(regs.rbegin(), regs.rend());
+        // active ranges sorted by increasing end point
+        std::vector<std::pair<LiveRange, std::string>> active;
+
+        for (const LiveRange& range : sortedRanges) {
+            if (range.isFloat != isFloat) {
+                continue;
+            }
+
+            // expire ranges that ended before this one starts
+            while (!active.empty() && active.front().first.end < range.start) {
+                freeRegs.push_back(active.front().second);
+                active.erase(active.begin());
+            }
+
+            std::string reg;
+            if (!freeRegs.empty()) {
+                reg = freeRegs.back();
+                freeRegs.pop_back();
+            } else if (active.back().first.end > range.end) {
+                // spill the range that ends last
+                reg = active.back().second;
+                active.back().first.frame->setVarReg(active.back().first.name, "");
+                active.pop_back();
+            } else {
+                continue;
+            }
+
+            range.frame->setVarReg(range.name, reg);
+            bool isCalleeSaved = std::find(leafRegs.begin(), leafRegs.end(), reg) == leafRegs.end();
+            if (isCalleeSaved && std::find(usedRegs.begin(), usedRegs.end(), reg) == usedRegs.end()) {
+                usedRegs.push_back(reg);
+            }
+
+            auto position = std::find_if(active.begin(), active.end(), [&](const std::pair<LiveRange, std::string>& a) {
+                return a.first.end > range.end;
+            });
+            active.insert(position, {range, reg});
+        }
+    }
+
+    for (const std::string& reg : usedRegs) {
+        fnFrame->addSavedRegister(reg);
+    }
+
+    // the frame holds the variables in memory, saved registers and the return address
+    bool usesMemory = !usedRegs.empty();
+    for (const std::pair<Frame*, std::string>& variable : variables) {
+        if (variable.first->getVarReg(variable.second) == "") {
+            usesMemory = true;
+        }
+    }
+    bool isLeaf = Pipeline::isEnabled("leaf-frames");
+    fnFrame->savesReturnAddress = hasCalls || !isLeaf;
+    fnFrame->hasStackFrame = hasCalls || usesMemory || !isLeaf;
+}
+
+void saveCalleeSavedRegs(std::ostream &assemblyOut, Frame* fnFrame) {
+    for (const std::pair<std::string, int>& savedRegister : fnFrame->getSavedRegisters()) {
+        if (savedRegister.first[1] == 'f') {
+            assemblyOut << "s.d " << savedRegister.first << ", -" << savedRegister.second << "($fp)" << std::endl;
+        } else {
+            assemblyOut << "sw " << savedRegister.first << ", -" << savedRegister.second << "($fp)" << std::endl;
+        }
+    }
+}
+
+void restoreCalleeSavedRegs(std::ostream &assemblyOut, Frame* fnFrame) {
+    for (const std::pair<std::string, int>& savedRegister : fnFrame->getSavedRegisters()) {
+        if (savedRegister.first[1] == 'f') {
+            assemblyOut << "l.d " << savedRegister.first << ", -" << savedRegister.second << "($fp)" << std::endl;
+        } else {
+            assemblyOut << "lw " << savedRegister.first << ", -" << savedRegister.second << "($fp)" << std::endl;
+        }
+    }
+}
+
+void compilePrologue(std::ostream &assemblyOut, Frame* fnFrame) {
+    if (!fnFrame->hasStackFrame) {
+        assemblyOut << ".frame	$sp, 0 , $31" << std::endl;
+        assemblyOut << ".mask	0x00000000,0" << std::endl;
+        assemblyOut << ".fmask	0x00000000,0" << std::endl;
+        assemblyOut << ".set	noreorder" << std::endl;
+        assemblyOut << ".set	nomacro" << std::endl;
+        return;
+    }
+
+    // offsets are relative to the stack pointer on entry, of the highest register saved
+    // $31 and $fp are at the top of the frame, the other registers below $fp
+    int storeSize = fnFrame->getStoreSize();
+    uint32_t mask = 1u << 30;
+    uint32_t fmask = 0;
+    int maskOffset = -4;
+    int fmaskOffset = 0;
+    int highestFloat = -1;
+    for (const std::pair<std::string, int>& savedRegister : fnFrame->getSavedRegisters()) {
+        int number = std::stoi(savedRegister.first.substr(2));
+        if (savedRegister.first[1] == 'f') {
+            // saved with s.d, so both registers of the pair
+            fmask |= 3u << number;
+            if (number > highestFloat) {
+                highestFloat = number;
+                fmaskOffset = 4 - storeSize - savedRegister.second;
+            }
+        } else {
+            mask |= 1u << (16 + number);
+        }
+    }
+    if (fnFrame->savesReturnAddress) {
+        mask |= 1u << 31;
+        maskOffset = -8;
+    }
+
+    std::stringstream masks;
+    masks << std::hex << std::setfill('0') << ".mask	0x" << std::setw(8) << mask << "," << std::dec << maskOffset << std::endl;
+    masks << std::hex << std::setfill('0') << ".fmask	0x" << std::setw(8) << fmask << "," << std::dec << fmaskOffset << std::endl;
+
+    assemblyOut << ".frame	$fp, " << storeSize + fnFrame->getVarStoreSize() << " , $31" << std::endl;
+    assemblyOut << masks.str();
+    assemblyOut << ".set	noreorder" << std::endl;
+    assemblyOut << ".set	nomacro" << std::endl;
+
+    // $31 and $fp are stored at the top of the frame
+    assemblyOut << "addiu $sp, $sp, -" << storeSize << std::endl;
+    if (fnFrame->savesReturnAddress) {
+        assemblyOut << "sw $31, 8($sp)" << std::endl;
+    }
+    assemblyOut << "sw $fp, 12($sp)" << std::endl;
+    assemblyOut << "move $fp, $sp" << std::endl;
+
+    // space for the variables in the frame
+    assemblyOut << "addiu $sp, $sp, -" << fnFrame->getVarStoreSize() << std::endl;
+
+    saveCalleeSavedRegs(assemblyOut, fnFrame);
+}
+
+void compileEpilogue(std::ostream &assemblyOut, Frame* fnFrame, const std::string& tailCallee) {
+    if (fnFrame->hasStackFrame) {
+        restoreCalleeSavedRegs(assemblyOut, fnFrame);
+        assemblyOut << "move $sp, $fp" << std::endl;
+        if (fnFrame->savesReturnAddress) {
+            assemblyOut << "lw $31, 8($sp)" << std::endl;
+        }
+        assemblyOut << "lw $fp, 12($sp)" << std::endl;
+        assemblyOut << "addiu $sp, $sp, " << fnFrame->getStoreSize() << std::endl;
+    }
+
+    if (tailCallee != "") {
+        assemblyOut << "j " << tailCallee << std::endl;
+    } else {
+        assemblyOut << "jr $31" << std::endl;
+    }
+    assemblyOut << "nop" << std::endl;
+}
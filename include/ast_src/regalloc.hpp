@@ -0,0 +1,107 @@
+#pragma once
+
+#include "ast.hpp"
+
+class AST_FunctionCall;
+
+/*
+    Linear scan register allocation for local variables.
+
+    While the frames of a function are generated, every declaration and reference of a variable
+    is recorded at a program point (the order in which generateFrames visits the nodes).
+    Once the whole function has been visited, the live range of each local is the interval
+    between its first and last reference, extended to the end of any loop it is live around.
+
+    Scalar locals whose address is never taken are then assigned callee saved registers
+    ($s0-$s7 and $f20-$f30) in order of their start point. If none are left, the live range
+    ending last is kept in memory instead.
+
+    Tail calls (see AST_FunctionCall::canTailCall) don't count as calls.
+    Functions that make no calls keep their parameters in the registers they are passed in
+    and can use the argument registers that are left over and $v1 before any callee saved ones.
+    The allocation also decides how much of a stack frame the function needs (see Frame::hasStackFrame).
+
+    -fno-regalloc keeps every variable in the frame, -fno-leaf-frames gives every function
+    a full frame and only callee saved registers.
+*/
+class RegisterAllocator
+{
+private:
+    struct Reference {
+        Frame* frame;
+        std::string name;
+        int point;
+    };
+
+    struct LiveRange {
+        Frame* frame;
+        std::string name;
+        bool isFloat;
+        int start;
+        int end;
+    };
+
+    std::vector<Reference> references;
+    std::vector<Reference> addressReferences;
+
+    // variables that could be held in a register, identified by the frame they are declared in
+    std::map<std::pair<Frame*, std::string>, bool> candidates;
+
+    // start and end points of every loop
+    std::vector<std::pair<int, int>> loops;
+    std::vector<int> openLoops;
+
+    // registers the parameters are passed in
+    std::map<std::pair<Frame*, std::string>, std::string> parameterRegs;
+    std::vector<std::string> argumentRegs;
+    std::vector<AST_FunctionCall*> calls;
+    bool hasCalls = false;
+
+    // every variable of the function, including the ones that can't be held in registers
+    std::vector<std::pair<Frame*, std::string>> variables;
+
+    int point = 0;
+
+    static const std::vector<std::string> intRegs;
+    static const std::vector<std::string> floatRegs;
+
+public:
+    /*
+        Allocator of the function whose frames are currently being generated.
+        nullptr outside of functions.
+    */
+    static RegisterAllocator* current;
+
+    // parameters are live from the start of the function
+    void declareVariable(Frame* frame, const std::string& name, AST* type, bool isParameter = false);
+    // called by Frame::addVariable
+    void addVariable(Frame* frame, const std::string& name);
+    void setParameterRegister(Frame* frame, const std::string& name, const std::string& reg);
+    // all registers used to pass the parameters, including the ones not kept in them
+    void setArgumentRegisters(const std::vector<std::string>& regs);
+    void recordCall(AST_FunctionCall* call);
+    void referenceVariable(Frame* frame, const std::string& name);
+    void takeAddress(Frame* frame, const std::string& name);
+
+    void startLoop();
+    void endLoop();
+
+    /*
+        Assigns registers to the variables of the function.
+        The callee saved registers that are used get a slot in fnFrame.
+    */
+    void allocate(Frame* fnFrame);
+};
+
+// preserve callee saved registers in the function prologue and epilogue
+// expects $fp to point to the frame of the function
+void saveCalleeSavedRegs(std::ostream &assemblyOut, Frame* fnFrame);
+void restoreCalleeSavedRegs(std::ostream &assemblyOut, Frame* fnFrame);
+
+/*
+    Prologue and epilogue for the frame decided by RegisterAllocator::allocate,
+    including the .frame/.mask/.fmask directives. The epilogue returns from the function,
+    or jumps to tailCallee which then returns to the caller instead.
+*/
+void compilePrologue(std::ostream &assemblyOut, Frame* fnFrame);
+void compileEpilogue(std::ostream &assemblyOut, Frame* fnFrame, const std::string& tailCallee = "");
@@ -1,4 +1,6 @@
 #include "statement.hpp"
+#include "structure.hpp"
+#include "ir.hpp"
 
 AST_Return::AST_Return(AST* _expr) :
     expr(_expr)
@@ -6,9 +8,20 @@ AST_Return::AST_Return(AST* _expr) :
 
 void AST_Return::generateFrames(Frame* _frame){
     frame = _frame;
+    AST_FunctionCall* call = dynamic_cast<AST_FunctionCall*>(expr);
+    if (call != nullptr) {
+        call->isTailCall = true;
+    }
     expr->generateFrames(_frame);
 }
 
+AST* AST_Return::fold(){
+    if (expr != nullptr) {
+        expr = expr->fold();
+    }
+    return this;
+}
+
 AST* AST_Return::deepCopy(){
     AST* new_expr = expr->deepCopy();
     return new AST_Return(new_expr);
@@ -20,45 +33,51 @@ void AST_Return::compile(std::ostream &assemblyOut) {
 
     // get info on corresponding function
     std::pair<int, AST*> fnInfo = frame->getFnInfo();
+    Frame* fnFrame = frame->getFnFrame();
+
+    AST_FunctionCall* call = dynamic_cast<AST_FunctionCall*>(expr);
+    if (call != nullptr && call->isTailCall && call->canTailCall(fnFrame)) {
+        call->compileTailCall(assemblyOut, fnFrame);
+        assemblyOut << "# end " << retLab << std::endl << std::endl;
+        return;
+    }
 
     if (expr == nullptr) {
         // return 0 by default
         assemblyOut << "addiu $v0, $0, $0" << std::endl;
     } else {
         // evaluate expression
-        expr->compile(assemblyOut);
+        std::string reg = allocateReg(usesFloatReg(expr));
+        expr->compileToReg(assemblyOut, reg);
         
-        // set return register to value on top of stack
-        std::string fnTypeName = fnInfo.second->getTypeName();
-        if(fnTypeName == "float")
-            assemblyOut << "l.s $f0, 8($sp)" << std::endl;
-        else if(fnTypeName == "double")
-            assemblyOut << "l.d $f0, 8($sp)" << std::endl;
+        // set return register
+        TypeKind fnKind = fnInfo.second->getTypeKind();
+        if(fnKind == TypeKind::FLOAT)
+            assemblyOut << "mov.s $f0, " << reg << std::endl;
+        else if(fnKind == TypeKind::DOUBLE)
+            assemblyOut << "mov.d $f0, " << reg << std::endl;
         else
-            assemblyOut << "lw $v0, 8($sp)" << std::endl;;
-        // no need to shift stack pointer since return will end a scope anyway
+            assemblyOut << "move $v0, " << reg << std::endl;
+        freeReg(reg);
     }
 
-    // skip through frames between current frame and function frame
-    for(int i = 0; i < fnInfo.first; i++){
-        assemblyOut << "lw $fp, 12($fp)" << std::endl;
-    }
-
-    // exit last frame properly
-    assemblyOut << "move $sp, $fp" << std::endl;
-    assemblyOut << "lw $31, 8($sp)" << std::endl;
-    assemblyOut << "lw $fp, 12($sp)" << std::endl;
-    assemblyOut << "addiu $sp, $sp, " << frame->getStoreSize() << std::endl;
-    
-    // jump back to wherever you called the function from
-    assemblyOut << "jr $31" << std::endl;
-    assemblyOut << "nop" << std::endl;
+    // nested scopes share the frame of the function so it can be left directly
+    compileEpilogue(assemblyOut, fnFrame);
 
     assemblyOut << "# end " << retLab << std::endl << std::endl;
 }
 
-AST_Return::~AST_Return() {
-    delete expr;
+void AST_Return::lower(IRBuilder &builder) {
+    // self recursive tail calls need the start of the function to jump to
+    AST_FunctionCall* call = dynamic_cast<AST_FunctionCall*>(expr);
+    if (call != nullptr && call->isTailCall && call->canTailCall(builder.fnFrame)
+        && (call->getName() != builder.fnFrame->fn->getName() || builder.tailCallTarget != nullptr)) {
+        call->lowerTailCall(builder);
+        return;
+    }
+
+    // return 0 by default
+    builder.ret(expr != nullptr ? expr->lowerToValue(builder) : builder.constant(0));
 }
 
 void AST_Break::generateFrames(Frame* _frame) {
@@ -75,26 +94,21 @@ void AST_Break::compile(std::ostream &assemblyOut) {
 
     auto endLoopLabel = frame->getEndLoopLabelName();
 
-    // skip through frames between current frame and loop frame
-    for(int i = 0; i < endLoopLabel.second - 1 ; i++){
-        assemblyOut << "lw $fp, 12($fp)" << std::endl;
-    }
-
-    // exit last frame properly
-    if (endLoopLabel.second != 0) {
-        assemblyOut << "move $sp, $fp" << std::endl;
-        assemblyOut << "lw $31, 8($sp)" << std::endl;
-        assemblyOut << "lw $fp, 12($sp)" << std::endl;
-        assemblyOut << "addiu $sp, $sp, " << frame->getStoreSize() << std::endl;
-    }
-
     // jumps to the end of a loop
+    // no frames need to be exited since scopes share the frame of the function
     assemblyOut << "j " << endLoopLabel.first << std::endl;
     assemblyOut << "nop" << std::endl;
 
     assemblyOut << "# end " << breakLabel << std::endl << std::endl;
 }
 
+void AST_Break::lower(IRBuilder &builder) {
+    if (builder.breakTargets.empty()) {
+        throw IRUnsupported("AST_Break: break outside of a loop or switch.\n");
+    }
+    builder.jump(builder.breakTargets.back());
+}
+
 void AST_Continue::generateFrames(Frame* _frame) {
     frame = _frame;
 }
@@ -109,19 +123,6 @@ void AST_Continue::compile(std::ostream &assemblyOut) {
 
     auto startLoopLabel = frame->getStartLoopLabelName();
 
-    // skip through frames between current frame and loop frame
-    for(int i = 0; i < startLoopLabel.second - 1 ; i++){
-        assemblyOut << "lw $fp, 12($fp)" << std::endl;
-    }
-
-    // exit last frame properly
-    if (startLoopLabel.second != 0) {
-         assemblyOut << "move $sp, $fp" << std::endl;
-        assemblyOut << "lw $31, 8($sp)" << std::endl;
-        assemblyOut << "lw $fp, 12($sp)" << std::endl;
-        assemblyOut << "addiu $sp, $sp, " << frame->getStoreSize() << std::endl;
-    }
-
     // jumps to the begining of a loop
     assemblyOut << "j " << startLoopLabel.first << std::endl;
     assemblyOut << "nop" << std::endl;
@@ -129,6 +130,13 @@ void AST_Continue::compile(std::ostream &assemblyOut) {
     assemblyOut << "# end " << continueLab << std::endl << std::endl;
 }
 
+void AST_Continue::lower(IRBuilder &builder) {
+    if (builder.continueTargets.empty()) {
+        throw IRUnsupported("AST_Continue: continue outside of a loop.\n");
+    }
+    builder.jump(builder.continueTargets.back());
+}
+
 AST_IfStmt::AST_IfStmt(AST* _cond, AST* _then, AST* _other) :
     cond(_cond),
     then(_then),
@@ -147,6 +155,15 @@ void AST_IfStmt::generateFrames(Frame* _frame){
     }
 }
 
+AST* AST_IfStmt::fold(){
+    cond = AST_UnOp::foldCondition(cond);
+    then = then->fold();
+    if (other != nullptr) {
+        other = other->fold();
+    }
+    return this;
+}
+
 AST* AST_IfStmt::deepCopy(){
     AST* new_cond = cond->deepCopy();
     AST* new_then = then->deepCopy();
@@ -161,31 +178,22 @@ void AST_IfStmt::compile(std::ostream &assemblyOut) {
     std::string ifLab = generateUniqueLabel("if");
     assemblyOut << std::endl << "# start " << ifLab << std::endl;
 
-    // compile condition code
-    cond->compile(assemblyOut);
-    // load result of cond expression into register
-    // use $t6 as lower $t registers might be used in other compile functions called on right
-    assemblyOut << "lw $t6, 8($sp)" << std::endl;
-    assemblyOut << "addiu $sp, $sp, 8" << std::endl;
-   
     std::string elseLabel = generateUniqueLabel("elseLabel");
     std::string endLabel = generateUniqueLabel("endLabel");
 
     // branch if condition is false
-    assemblyOut << "beq $t6, $0, " << elseLabel << std::endl;
-    assemblyOut << "nop" << std::endl;
+    cond->compileBranch(assemblyOut, other != nullptr ? elseLabel : endLabel, false);
 
     // compile then
     then->compile(assemblyOut);
 
-    // always jump to end after going through if branch
-    assemblyOut << "j " << endLabel << std::endl;
-    assemblyOut << "nop" << std::endl;
-
-    // set else label position
-    assemblyOut << elseLabel << ":" << std::endl;
     if (other != nullptr) {
+        // jump to end after going through if branch
+        assemblyOut << "j " << endLabel << std::endl;
+        assemblyOut << "nop" << std::endl;
+
         // compile other
+        assemblyOut << elseLabel << ":" << std::endl;
         other->compile(assemblyOut);
     }
 
@@ -195,12 +203,27 @@ void AST_IfStmt::compile(std::ostream &assemblyOut) {
     assemblyOut << "# end " << ifLab << std::endl << std::endl;
 }
 
-AST_IfStmt::~AST_IfStmt(){
-    delete cond;
-    delete then;
+void AST_IfStmt::lower(IRBuilder &builder) {
+    IRBlock* thenBlock = builder.fn->newBlock();
+    IRBlock* endBlock = builder.fn->newBlock();
+    IRBlock* elseBlock = other != nullptr ? builder.fn->newBlock() : endBlock;
+
+    cond->lowerBranch(builder, thenBlock, elseBlock);
+
+    builder.sealBlock(thenBlock);
+    builder.setBlock(thenBlock);
+    then->lower(builder);
+    builder.jump(endBlock);
+
     if (other != nullptr) {
-        delete other;
-    } 
+        builder.sealBlock(elseBlock);
+        builder.setBlock(elseBlock);
+        other->lower(builder);
+        builder.jump(endBlock);
+    }
+
+    builder.sealBlock(endBlock);
+    builder.setBlock(endBlock);
 }
 
 AST_WhileStmt::AST_WhileStmt(AST* _cond, AST* _body):
@@ -210,9 +233,21 @@ AST_WhileStmt::AST_WhileStmt(AST* _cond, AST* _body):
 
 void AST_WhileStmt::generateFrames(Frame* _frame){
     frame = _frame;
+    if (RegisterAllocator::current != nullptr) {
+        RegisterAllocator::current->startLoop();
+    }
     cond->generateFrames(_frame);
     // we don't need a new frame here for the same reason we don't need one for the if statemnt
     body->generateFrames(_frame);
+    if (RegisterAllocator::current != nullptr) {
+        RegisterAllocator::current->endLoop();
+    }
+}
+
+AST* AST_WhileStmt::fold(){
+    cond = AST_UnOp::foldCondition(cond);
+    body = body->fold();
+    return this;
 }
 
 AST* AST_WhileStmt::deepCopy(){
@@ -225,6 +260,7 @@ void AST_WhileStmt::compile(std::ostream &assemblyOut){
     std::string whileLab = generateUniqueLabel("while");
     assemblyOut << std::endl << "# start " << whileLab << std::endl; 
 
+    std::string bodyLabel = generateUniqueLabel("loopBody");
     std::string startLoopLabel = generateUniqueLabel("startLoop");
     std::string endLoopLabel = generateUniqueLabel("endLoop");
 
@@ -232,24 +268,19 @@ void AST_WhileStmt::compile(std::ostream &assemblyOut){
     // needed for continue and break statements
     frame->setLoopLabelNames(startLoopLabel, endLoopLabel);
 
-    // set start of loop label position
-    assemblyOut << startLoopLabel << ":" << std::endl;
-
-    // load result of condition into register
-    cond->compile(assemblyOut);
-    assemblyOut << "lw $t6, 8($sp)" << std::endl;
-    assemblyOut << "addiu $sp, $sp, 8" << std::endl;
-
-    // branch if condition is false
-    assemblyOut << "beq $t6, $0, " << endLoopLabel << std::endl;
+    // the condition is placed after the body so each iteration only takes a single branch
+    assemblyOut << "j " << startLoopLabel << std::endl;
     assemblyOut << "nop" << std::endl;
 
     // compile body
+    assemblyOut << bodyLabel << ":" << std::endl;
     body->compile(assemblyOut);
-    
-    // always jump back to start of loop
-    assemblyOut << "j " << startLoopLabel << std::endl;
-    assemblyOut << "nop" << std::endl;
+
+    // set start of loop label position (continue evaluates the condition)
+    assemblyOut << startLoopLabel << ":" << std::endl;
+
+    // branch back to the body if condition is true
+    cond->compileBranch(assemblyOut, bodyLabel, true);
 
     // set end of loop label position
     assemblyOut << endLoopLabel << ":" << std::endl;
@@ -260,9 +291,33 @@ void AST_WhileStmt::compile(std::ostream &assemblyOut){
     assemblyOut << "# end " << whileLab << std::endl << std::endl;
 }
 
-AST_WhileStmt::~AST_WhileStmt(){
-    delete cond;
-    delete body;
+void AST_WhileStmt::lower(IRBuilder &builder) {
+    IRBlock* condBlock = builder.fn->newBlock();
+    IRBlock* bodyBlock = builder.fn->newBlock();
+    IRBlock* endBlock = builder.fn->newBlock();
+
+    // the condition can't be sealed before the end of the body, which jumps back to it
+    builder.jump(condBlock);
+    int condPosition = builder.layoutPosition();
+    builder.setBlock(condBlock);
+    cond->lowerBranch(builder, bodyBlock, endBlock);
+
+    int bodyPosition = builder.layoutPosition();
+    builder.sealBlock(bodyBlock);
+    builder.setBlock(bodyBlock);
+    builder.breakTargets.push_back(endBlock);
+    builder.continueTargets.push_back(condBlock);
+    body->lower(builder);
+    builder.breakTargets.pop_back();
+    builder.continueTargets.pop_back();
+    builder.jump(condBlock);
+
+    builder.sealBlock(condBlock);
+    builder.sealBlock(endBlock);
+
+    // the condition is placed after the body like in compile
+    builder.rotateLayout(condPosition, bodyPosition);
+    builder.setBlock(endBlock);
 }
 
 AST_SwitchStmt::AST_SwitchStmt(AST* _value, AST* _body):
@@ -276,6 +331,12 @@ void AST_SwitchStmt::generateFrames(Frame* _frame){
     body->generateFrames(_frame);
 }
 
+AST* AST_SwitchStmt::fold(){
+    value = value->fold();
+    body = body->fold();
+    return this;
+}
+
 void AST_SwitchStmt::compile(std::ostream &assemblyOut){
     std::string switchStmt = generateUniqueLabel("switchStmt");
     assemblyOut << std::endl << "# start " << switchStmt << std::endl;
@@ -284,36 +345,28 @@ void AST_SwitchStmt::compile(std::ostream &assemblyOut){
     std::string endSwitchLabel = generateUniqueLabel("endSwitch");
     frame->setLoopLabelNames("", endSwitchLabel);
 
-    value->compile(assemblyOut);
-
-    // load top of stack into register
-    assemblyOut << "lw $t4, 8($sp)" << std::endl;
-    assemblyOut << "addiu $sp, $sp, 8" << std::endl;
+    // value is kept in a register while jumping to the matching case
+    std::string valueReg = allocateReg(false);
+    value->compileToReg(assemblyOut, valueReg);
 
     // Every switch statement will have exactly one block that encapsulates its cases (body of switch).
-    // The below logic will jump into one of these cases and while doing so jump over the
-    // beginning of the block. The beginning of the block is normally responsible for opening
-    // a new frame.
-    // Therefore, we must open this new frame manually to counter this problem. The frame will be closed
-    // by the end of block as normal.
-    assemblyOut << "addiu $sp, $sp, -" << body->frame->getStoreSize() << std::endl;
-    assemblyOut << "sw $31, 8($sp)" << std::endl;
-    assemblyOut << "sw $fp, 12($sp)" << std::endl;
-    assemblyOut << "move $fp, $sp" << std::endl;
-    assemblyOut << "addiu $sp, $sp, -" << body->frame->getVarStoreSize() << std::endl;
-
-    auto caseLabelToValueMapping = frame->getCaseLabelValueMapping();
-    for (const auto &labelValue : caseLabelToValueMapping) {
+    // The below logic will jump into one of these cases, skipping the beginning of the block.
+    // This is fine since blocks don't open frames of their own.
+    std::vector<std::pair<int, std::string>> cases;
+    std::string defaultLabel = endSwitchLabel;
+    for (const auto &labelValue : frame->getCaseLabelValueMapping()) {
         if (hasEnding(labelValue.first, "default") == true) {
-            assemblyOut << "j " << labelValue.first << std::endl;
-            assemblyOut << "nop" << std::endl;
+            defaultLabel = labelValue.first;
         } else {
-            assemblyOut << "li $t5, " << labelValue.second << std::endl;    
-
-            assemblyOut << "beq $t4, $t5, " << labelValue.first << std::endl;
-            assemblyOut << "nop" << std::endl;
+            cases.push_back({labelValue.second, labelValue.first});
         }
     }
+    std::sort(cases.begin(), cases.end());
+
+    std::string indexReg = allocateReg(false);
+    compileSwitchDispatch(assemblyOut, valueReg, indexReg, cases, defaultLabel);
+    freeReg(indexReg);
+    freeReg(valueReg);
 
     // case statements
     body->compile(assemblyOut);
@@ -326,9 +379,50 @@ void AST_SwitchStmt::compile(std::ostream &assemblyOut){
     assemblyOut << "# end " << switchStmt << std::endl; 
 }
 
-AST_SwitchStmt::~AST_SwitchStmt(){
-    delete value;
-    delete body;
+void AST_SwitchStmt::lower(IRBuilder &builder) {
+    IRInstr* switchValue = value->lowerToValue(builder);
+    IRBlock* endBlock = builder.fn->newBlock();
+
+    // cases are entered from the dispatch and by falling through from the case before them
+    std::vector<std::pair<int, IRBlock*>> cases;
+    IRBlock* defaultBlock = endBlock;
+    for (const auto &labelValue : frame->getCaseLabelValueMapping()) {
+        IRBlock* caseBlock = builder.fn->newBlock();
+        builder.caseBlocks[labelValue.first] = caseBlock;
+        if (hasEnding(labelValue.first, "default") == true) {
+            defaultBlock = caseBlock;
+        } else {
+            cases.push_back({labelValue.second, caseBlock});
+        }
+    }
+    std::stable_sort(cases.begin(), cases.end(), [](const std::pair<int, IRBlock*>& a, const std::pair<int, IRBlock*>& b) {
+        return a.first < b.first;
+    });
+
+    IRInstr* dispatch = builder.emit(IROp::SWITCH, IRType::VOID, {switchValue});
+    dispatch->targets.push_back(defaultBlock);
+    for (const std::pair<int, IRBlock*>& caseValue : cases) {
+        dispatch->caseValues.push_back(caseValue.first);
+        dispatch->targets.push_back(caseValue.second);
+    }
+    for (IRBlock* target : dispatch->targets) {
+        builder.fn->addEdge(dispatch->block, target);
+    }
+
+    builder.breakTargets.push_back(endBlock);
+    body->lower(builder);
+    builder.breakTargets.pop_back();
+    builder.jump(endBlock);
+
+    // every case has to be in the body
+    for (IRBlock* target : dispatch->targets) {
+        if (target != endBlock && !builder.isStarted(target)) {
+            throw IRUnsupported("AST_SwitchStmt: case outside of the body of the switch.\n");
+        }
+    }
+
+    builder.sealBlock(endBlock);
+    builder.setBlock(endBlock);
 }
 
 AST_CaseStmt::AST_CaseStmt(AST* _body, int _value):
@@ -358,6 +452,11 @@ void AST_CaseStmt::generateFrames(Frame* _frame){
     body->generateFrames(_frame);
 }
 
+AST* AST_CaseStmt::fold(){
+    body = body->fold();
+    return this;
+}
+
 void AST_CaseStmt::compile(std::ostream &assemblyOut){
     std::string caseStmt = generateUniqueLabel("caseStmt");
     assemblyOut << std::endl << "# start " << caseStmt << std::endl;
@@ -369,8 +468,14 @@ void AST_CaseStmt::compile(std::ostream &assemblyOut){
     assemblyOut << "# end " << caseStmt << std::endl; 
 }
 
-AST_CaseStmt::~AST_CaseStmt(){
-    delete body;
+void AST_CaseStmt::lower(IRBuilder &builder) {
+    IRBlock* caseBlock = builder.caseBlocks.at(caseStartLabel);
+
+    // falls through from the case before
+    builder.jump(caseBlock);
+    builder.sealBlock(caseBlock);
+    builder.setBlock(caseBlock);
+    body->lower(builder);
 }
 
 AST_Block::AST_Block(AST* _body):
@@ -385,6 +490,13 @@ void AST_Block::generateFrames(Frame* _frame){
     }
 }
 
+AST* AST_Block::fold(){
+    if (body != nullptr) {
+        body = body->fold();
+    }
+    return this;
+}
+
 AST* AST_Block::deepCopy(){
     AST* new_body = nullptr;
     if(body != nullptr){
@@ -398,33 +510,18 @@ void AST_Block::compile(std::ostream &assemblyOut) {
     assemblyOut << std::endl << "# start " << blockname << std::endl;
     if(frame->fn != nullptr) assemblyOut << "# ( funciton block ) " << std::endl;
 
-    else{
-        // increase size of current frame by required ammount for storing previous state data
-        // currently storing only $31, and $fp
-        assemblyOut << "addiu $sp, $sp, -" << frame->getStoreSize() << std::endl;
-        assemblyOut << "sw $31, 8($sp)" << std::endl;
-        assemblyOut << "sw $fp, 12($sp)" << std::endl;
-        assemblyOut << "move $fp, $sp" << std::endl;
-
-        // move stack pointer down to allocate space for temporary variables in frame
-        assemblyOut << "addiu $sp, $sp, -" << frame->getVarStoreSize() << std::endl;
-    }
-
+    // the scope of the block only exists at compile time, its variables are
+    // part of the frame of the function (see Frame::addVariable)
     if (body != nullptr) {
         body->compile(assemblyOut);
     }
-
-    if(frame->fn == nullptr){
-        // move fp back to start of frame and re-instate previous frame
-        assemblyOut << "move $sp, $fp" << std::endl;
-        assemblyOut << "lw $31, 8($sp)" << std::endl;
-        assemblyOut << "lw $fp, 12($sp)" << std::endl;
-        assemblyOut << "addiu $sp, $sp, " << frame->getStoreSize() << std::endl;
-    }
     
     assemblyOut << "# end " << blockname << std::endl << std::endl;
 }
 
-AST_Block::~AST_Block(){
-    delete body;
+void AST_Block::lower(IRBuilder &builder) {
+    if (body != nullptr) {
+        body->lower(builder);
+    }
 }
+
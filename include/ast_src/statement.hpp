@@ -21,8 +21,8 @@ public:
     void generateFrames(Frame* _frame = nullptr) override;
     AST* deepCopy() override;
     void compile(std::ostream &assemblyOut) override;
-
-    ~AST_Return();
+    void lower(IRBuilder &builder) override;
+    AST* fold() override;
 };
 
 class AST_Break
@@ -32,6 +32,7 @@ public:
     void generateFrames(Frame* _frame = nullptr) override;
     AST* deepCopy() override;
     void compile(std::ostream &assemblyOut) override;
+    void lower(IRBuilder &builder) override;
 };
 
 class AST_Continue
@@ -41,6 +42,7 @@ public:
     void generateFrames(Frame* _frame = nullptr) override;
     AST* deepCopy() override;
     void compile(std::ostream &assemblyOut) override;
+    void lower(IRBuilder &builder) override;
 };
 
 class AST_IfStmt
@@ -57,8 +59,8 @@ public:
     void generateFrames(Frame* _frame = nullptr) override;
     AST* deepCopy() override;
     void compile(std::ostream &assemblyOut) override;
-
-    ~AST_IfStmt();
+    void lower(IRBuilder &builder) override;
+    AST* fold() override;
 };
 
 /*
@@ -79,8 +81,8 @@ public:
     void generateFrames(Frame* _frame = nullptr) override;
     AST* deepCopy() override;
     void compile(std::ostream& assemblyOut) override;
-
-    ~AST_WhileStmt();
+    void lower(IRBuilder &builder) override;
+    AST* fold() override;
 };
 
 class AST_SwitchStmt
@@ -95,8 +97,8 @@ public:
 
     void generateFrames(Frame* _frame = nullptr) override;
     void compile(std::ostream& assemblyOut) override;
-
-    ~AST_SwitchStmt();
+    void lower(IRBuilder &builder) override;
+    AST* fold() override;
 };
 
 class AST_CaseStmt
@@ -118,8 +120,8 @@ public:
 
     void generateFrames(Frame* _frame = nullptr) override;
     void compile(std::ostream& assemblyOut) override;
-
-    ~AST_CaseStmt();
+    void lower(IRBuilder &builder) override;
+    AST* fold() override;
 };
 
 /*
@@ -140,6 +142,6 @@ public:
     void generateFrames(Frame* _frame = nullptr) override;
     AST* deepCopy() override;
     void compile(std::ostream& assemblyOut) override;
-
-    ~AST_Block();
+    void lower(IRBuilder &builder) override;
+    AST* fold() override;
 };
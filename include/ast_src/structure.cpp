@@ -1,5 +1,10 @@
 #include "structure.hpp"
 #include "expression.hpp"
+#include "peephole.hpp"
+#include "ir.hpp"
+#include "isel.hpp"
+#include "optimise.hpp"
+#include "pipeline.hpp"
 
 AST_Sequence::AST_Sequence(AST* _first, AST* _second) :
     first(_first),
@@ -12,6 +17,12 @@ void AST_Sequence::generateFrames(Frame* _frame){
     second->generateFrames(_frame);
 }
 
+AST* AST_Sequence::fold(){
+    first = first->fold();
+    second = second->fold();
+    return this;
+}
+
 AST* AST_Sequence::deepCopy(){
     AST* new_first = first->deepCopy();
     AST* new_second = second->deepCopy();
@@ -23,6 +34,11 @@ void AST_Sequence::compile(std::ostream &assemblyOut) {
     second->compile(assemblyOut);
 }
 
+void AST_Sequence::lower(IRBuilder &builder) {
+    first->lower(builder);
+    second->lower(builder);
+}
+
 void AST_Sequence::setStructName(std::string newName) {
     this->structName = newName;
 }
@@ -31,12 +47,7 @@ std::string AST_Sequence::getStructName() {
     return this->structName;
 }
 
-AST_Sequence::~AST_Sequence(){
-    delete first;
-    delete second;
-}
-
-AST_FunDeclaration::AST_FunDeclaration(AST* _type, std::string* _name, AST* _body, std::vector<std::pair<AST*,std::string>>* _params) :
+AST_FunDeclaration::AST_FunDeclaration(AST* _type, const std::string* _name, AST* _body, std::vector<std::pair<AST*,std::string>>* _params) :
     type(_type),
     name(*_name),
     body(_body),
@@ -54,16 +65,53 @@ void AST_FunDeclaration::generateFrames(Frame* _frame){
     // we don't need to generate a new frame here since the block statement that will be the body
     // will handle generating the new frame
     if (body != nullptr) {
+        // collect live ranges of the local variables while generating the frames of the body
+        RegisterAllocator allocator;
+        RegisterAllocator* parentAllocator = RegisterAllocator::current;
+        RegisterAllocator::current = &allocator;
+
         body->generateFrames(_frame);
         body->frame->fn = this;
         // declare parameters as variables in the frame
-        if(params != nullptr)
+        if(params != nullptr){
+            std::vector<TypeKind> kinds;
             for(std::pair<AST*,std::string> param: *params){
                 body->frame->addVariable(param.second, param.first, param.first->getBytes());
+                allocator.declareVariable(body->frame, param.second, param.first, true);
+                kinds.insert(kinds.begin(), param.first->getTypeKind());
+            }
+
+            // chars are truncated when they are stored so they can't stay in the register they are passed in
+            std::vector<int> offsets;
+            std::vector<std::string> regs;
+            argumentLocations(kinds, offsets, regs);
+            std::vector<std::string> argumentRegs;
+            for(int arg_i = 0; arg_i < (int)kinds.size(); arg_i++){
+                if(regs[arg_i] != "")
+                    argumentRegs.push_back(regs[arg_i]);
+                if(regs[arg_i] != "" && regs[arg_i][1] == 'a' && kinds[arg_i] == TypeKind::DOUBLE)
+                    argumentRegs.push_back(std::string("$a") + std::to_string(offsets[arg_i] / 4 + 1));
+            }
+            allocator.setArgumentRegisters(argumentRegs);
+            for(int i = 0; i < (int)params->size(); i++){
+                int arg_i = params->size() - 1 - i;
+                if(kinds[arg_i] != TypeKind::CHAR)
+                    allocator.setParameterRegister(body->frame, params->at(i).second, regs[arg_i]);
             }
+        }
+
+        RegisterAllocator::current = parentAllocator;
+        allocator.allocate(body->frame);
     } 
 }
 
+AST* AST_FunDeclaration::fold(){
+    if (body != nullptr) {
+        body = body->fold();
+    }
+    return this;
+}
+
 AST* AST_FunDeclaration::deepCopy(){
     AST* new_type = type->deepCopy();
     AST* new_body = nullptr;
@@ -83,192 +131,199 @@ AST* AST_FunDeclaration::deepCopy(){
 void AST_FunDeclaration::compile(std::ostream &assemblyOut) {
     assemblyOut << std::endl << "# start function declaration for "<< name << std::endl;
     if (body != nullptr) {
-        // function header
-        assemblyOut << ".text" << std::endl;
-        assemblyOut << ".align  2" << std::endl;
-        assemblyOut << ".global " << name << std::endl;
-        assemblyOut << ".set	nomips16" << std::endl;
-        assemblyOut << ".set	nomicromips" << std::endl;
-        assemblyOut << ".ent    " << name << std::endl;
-        assemblyOut << ".type   " << name << ", @function" << std::endl;
-
-        // create label
-        assemblyOut << name << ":" << std::endl;
-
-        // function header 2
-        assemblyOut << ".frame	$fp, " << body->frame->getStoreSize() << " , $31" << std::endl;
-        assemblyOut << ".mask	0x40000000,-4" << std::endl;
-        assemblyOut << ".fmask	0x00000000,0" << std::endl;
-        assemblyOut << ".set	noreorder" << std::endl;
-        assemblyOut << ".set	nomacro" << std::endl;
-
-        // increase size of current frame by required ammount for storing previous state data
-        // currently storing only $31, and $fp
-        assemblyOut << "addiu $sp, $sp, -" << body->frame->getStoreSize() << std::endl;
-        assemblyOut << "sw $31, 8($sp)" << std::endl;
-        assemblyOut << "sw $fp, 12($sp)" << std::endl;
-        assemblyOut << "move $fp, $sp" << std::endl;
-
-        // move stack pointer down to allocate space for temporary variables in frame
-        assemblyOut << "addiu $sp, $sp, -" << body->frame->getVarStoreSize() << std::endl;
-
-        // copy over arguments from call
-        if(params != nullptr){
-            // state variables
-            bool allowFReg = true;
-            bool loadFromReg = true;
-            int availableAReg = 0;
-            int availableFReg = 12;
-            int memOffset = 0;
-            // i is position in vector, arg_i is position in argument order
-            for(int i = params->size() - 1, arg_i = 0; arg_i < params->size(); i--, arg_i++){
-                // parameterInfo
-                std::pair<AST*, std::string> param = params->at(i);
-                std::string paramTypeName = param.first->getTypeName();
-
-                // comment
-                assemblyOut << std::endl << "# start loading parameter " << param.second << " in " << name << std::endl;
-                            
-                bool useMem = !loadFromReg;
-
-                // load from register
-                if(loadFromReg){
-                    if(paramTypeName == "float" || paramTypeName == "double"){
-                        // this part is the same for floats and doubles
-                        if(allowFReg){
-                            assemblyOut << "# (reading a " << paramTypeName << " type from f reg)" << std::endl;
-                            std::string reg = std::string("$f") + std::to_string(availableFReg);
-                            regToVar(assemblyOut, body->frame, reg, param.second);
-                            
-                            // update state
-                            availableFReg += 2;
-                            availableAReg++;
-                            memOffset += 4;
-                            if(paramTypeName == "double"){
-                                availableAReg++;
-                                memOffset += 4;
-                            }
+        // compiling straight from the AST also handles everything the IR doesn't
+        std::stringstream functionOut;
+        IRFunction* fn = Pipeline::isEnabled("ir") ? lowerFunction() : nullptr;
+        if (fn != nullptr) {
+            optimiseFunction(fn);
+            if (IRFunction::dump) {
+                fn->print(std::cerr);
+            }
+            compileHeader(functionOut);
+            InstructionSelector(fn).compile(functionOut);
+            compileFooter(functionOut);
+            delete fn;
+        } else {
+            compileFunction(functionOut);
+        }
 
-                            if(availableFReg == 16)
-                                allowFReg = false;
-                            if(availableAReg == 4)
-                                loadFromReg = false;
-                        }
-                        else{
-                            assemblyOut << "# (reading a " << paramTypeName << " type from a reg)" << std::endl;
-                            
-                            if(paramTypeName == "double"){
-                                if(availableAReg % 2){
-                                    memOffset += 4;
-                                    availableAReg++;
-                                }
-                                
-                                if(availableAReg < 4){
-                                    std::string reg = std::string("$a") + std::to_string(availableAReg);
-                                    std::string reg_2 = std::string("$a") + std::to_string(availableAReg+1);
-                                    regToVar(assemblyOut, body->frame, reg, param.second, reg_2);
-
-                                    // update state
-                                    availableAReg += 2;
-                                    memOffset += 8;
-                                }
-                                else{
-                                    loadFromReg = false;
-                                    useMem = true;
-                                }
-                            }
-                            else{
-                                std::string reg = std::string("$a") + std::to_string(availableAReg);
-                                regToVar(assemblyOut, body->frame, reg, param.second);
-                                
-                                // update state
-                                availableAReg++;
-                                memOffset += 4;
-                            }
+        if (Pipeline::isEnabled("peephole") || Pipeline::isEnabled("delay-slots")) {
+            std::vector<AsmLine> lines = parseAssembly(functionOut);
+            if (Pipeline::isEnabled("peephole")) {
+                Peephole::optimise(lines);
+            }
+            if (Pipeline::isEnabled("delay-slots")) {
+                fillDelaySlots(lines);
+            }
+            printAssembly(assemblyOut, lines);
+        } else {
+            assemblyOut << functionOut.str();
+        }
+    }
+    assemblyOut << "# end function declaration for " << name << std::endl << std::endl;
+}
 
-                            // check state
-                            if(availableAReg == 4)
-                                loadFromReg = false;
-                        }
-                    }
-                    else{
-                        assemblyOut << "# (reading a integer type)" << std::endl;
-                        std::string reg = std::string("$a") + std::to_string(availableAReg);
-                        regToVar(assemblyOut, body->frame, reg, param.second);
-
-                        // update state
-                        availableAReg++;
-                        allowFReg = false;
-                        memOffset += 4;
-
-                        if(availableAReg == 4)
-                            loadFromReg = false;
-                    }
-                }
-                // load from memory
-                if(useMem){
-                    if(paramTypeName == "float"){
-                        assemblyOut << "# (reading a floating type from memory)" << std::endl;
-                        assemblyOut << "l.s $f4, " << memOffset + body->frame->getStoreSize() << "($fp)" << std::endl;
-                        regToVar(assemblyOut, body->frame, "$f4", param.second);
-
-                        // update state
-                        memOffset += 4;
-                    }
-                    else if(paramTypeName == "double"){
-                        if(memOffset % 8){
-                            memOffset += 4;
-                        }
+void AST_FunDeclaration::compileHeader(std::ostream &assemblyOut) {
+    assemblyOut << ".text" << std::endl;
+    assemblyOut << ".align  2" << std::endl;
+    assemblyOut << ".global " << name << std::endl;
+    assemblyOut << ".set	nomips16" << std::endl;
+    assemblyOut << ".set	nomicromips" << std::endl;
+    assemblyOut << ".ent    " << name << std::endl;
+    assemblyOut << ".type   " << name << ", @function" << std::endl;
+
+    // create label
+    assemblyOut << name << ":" << std::endl;
+}
 
-                        assemblyOut << "# (reading a double type from memory)" << std::endl;
-                        assemblyOut << "l.d $f4, " << memOffset + body->frame->getStoreSize() << "($fp)" << std::endl;
-                        regToVar(assemblyOut, body->frame, "$f4", param.second);
+void AST_FunDeclaration::compileFooter(std::ostream &assemblyOut) {
+    assemblyOut << ".set	macro" << std::endl;
+    assemblyOut << ".set	reorder" << std::endl;
+    assemblyOut << ".end    " << name << std::endl;
+    assemblyOut << ".size	" << name << ", .-" << name << std::endl;
+}
 
-                        // update state
-                        memOffset += 8;
-                    }
-                    else{
-                        assemblyOut << "# (reading a integer type from memory)" << std::endl;
-                        assemblyOut << "lw $t0, " << memOffset + body->frame->getStoreSize() << "($fp)" << std::endl;
-                        regToVar(assemblyOut, body->frame, "$t0", param.second);
+void AST_FunDeclaration::compileFunction(std::ostream &assemblyOut) {
+    compileHeader(assemblyOut);
 
-                        // update state
-                        memOffset += 4;
-                    }
+    // function header 2 and setting up the frame
+    compilePrologue(assemblyOut, body->frame);
+
+    // copy over arguments from call
+    std::vector<std::string> paramRegs;
+    if(params != nullptr){
+        // parameters are stored in reverse order
+        std::vector<std::pair<AST*, std::string>> paramList(params->rbegin(), params->rend());
+        std::vector<TypeKind> kinds;
+        for(const std::pair<AST*, std::string>& param: paramList){
+            kinds.push_back(param.first->getTypeKind());
+        }
+        std::vector<int> paramOffsets;
+        argumentLocations(kinds, paramOffsets, paramRegs);
+
+        for(int i = 0; i < (int)paramList.size(); i++){
+            std::string paramName = paramList[i].second;
+            TypeKind paramKind = kinds[i];
+            std::string reg = paramRegs[i];
+
+            assemblyOut << std::endl << "# start loading parameter " << paramName << " in " << name << std::endl;
+
+            if(reg != "" && body->frame->getVarReg(paramName) == reg){
+                // kept in the register it was passed in (see RegisterAllocator)
+                // the temporary register pool must not hand it out
+                assemblyOut << "# (kept in " << reg << ")" << std::endl;
+                if(reg[1] == 'f')
+                    reserveReg(reg);
+            }
+            else if(reg != "" && paramKind == TypeKind::DOUBLE && reg[1] == 'a'){
+                assemblyOut << "# (reading a double type from a regs)" << std::endl;
+                std::string reg_2 = std::string("$a") + std::to_string(paramOffsets[i] / 4 + 1);
+                regToVar(assemblyOut, body->frame, reg, paramName, reg_2);
+            }
+            else if(reg != ""){
+                assemblyOut << "# (reading a " << paramList[i].first->getTypeName() << " type from " << reg << ")" << std::endl;
+                regToVar(assemblyOut, body->frame, reg, paramName);
+            }
+            else{
+                // stack arguments are in the argument area of the caller, right above this frame
+                std::string offset = body->frame->hasStackFrame
+                    ? std::to_string(paramOffsets[i] + body->frame->getStoreSize()) + "($fp)"
+                    : std::to_string(paramOffsets[i]) + "($sp)";
+                assemblyOut << "# (reading a " << paramList[i].first->getTypeName() << " type from memory)" << std::endl;
+                if(paramKind == TypeKind::FLOAT || paramKind == TypeKind::DOUBLE){
+                    assemblyOut << (paramKind == TypeKind::FLOAT ? "l.s" : "l.d") << " $f4, " << offset << std::endl;
+                    regToVar(assemblyOut, body->frame, "$f4", paramName);
+                }
+                else{
+                    assemblyOut << "lw $t0, " << offset << std::endl;
+                    regToVar(assemblyOut, body->frame, "$t0", paramName);
                 }
-                assemblyOut << "# loading parameter " << param.second << " in " << name << std::endl << std::endl;
             }
+            assemblyOut << "# loading parameter " << paramName << " in " << name << std::endl << std::endl;
         }
+    }
+
+    if(body->frame->tailCallLabel != ""){
+        assemblyOut << body->frame->tailCallLabel << ":" << std::endl;
+    }
 
-        // body
-        body->compile(assemblyOut);
+    // body
+    body->compile(assemblyOut);
+    for(const std::string& reg: paramRegs){
+        if(reg != "" && reg[1] == 'f')
+            freeReg(reg);
+    }
 
-        // load 0 into the return vairbale
-        // this code only ever get's called if a void function is used, all other functions will
-        // exit the scope with the code compiled by the return
-        assemblyOut << "move $v0, $0" << std::endl;
+    // load 0 into the return vairbale
+    // this code only ever get's called if a void function is used, all other functions will
+    // exit the scope with the code compiled by the return
+    assemblyOut << "move $v0, $0" << std::endl;
 
-        // move fp back to start of frame and re-instate previous frame
-        assemblyOut << "move $sp, $fp" << std::endl;
-        assemblyOut << "lw $31, 8($sp)" << std::endl;
-        assemblyOut << "lw $fp, 12($sp)" << std::endl;
-        assemblyOut << "addiu $sp, $sp, " << body->frame->getStoreSize() << std::endl;
-        
-        // jump back to wherever function was called from (this is only in place in case of void functions)
-        // normally return statement will handle jumping
-        assemblyOut << "jr $31" << std::endl;
-        assemblyOut << "nop" << std::endl;
-
-        // function footer
-        assemblyOut << ".set	macro" << std::endl;
-        assemblyOut << ".set	reorder" << std::endl;
-        assemblyOut << ".end    " << name << std::endl;
-        assemblyOut << ".size	" << name << ", .-" << name << std::endl;
+    // jump back to wherever function was called from (this is only in place in case of void functions)
+    // normally return statement will handle jumping
+    compileEpilogue(assemblyOut, body->frame);
+
+    compileFooter(assemblyOut);
+}
+
+IRFunction* AST_FunDeclaration::lowerFunction() {
+    if (body == nullptr) {
+        return nullptr;
     }
-    assemblyOut << "# end function declaration for " << name << std::endl << std::endl;
+    IRFunction* fn = new IRFunction();
+    fn->name = name;
+    fn->frame = body->frame;
+    try {
+        fn->returnType = irType(getTypeKind());
+        IRBuilder builder(fn, body->frame);
+
+        // the parameters are passed before anything else happens
+        std::vector<std::string> paramNames = getParamNames();
+        std::vector<IRInstr*> paramValues;
+        for (int i = 0; i < (int)paramNames.size(); i++) {
+            IRType paramType = irType(body->frame->getVarType(paramNames[i])->getTypeKind());
+            IRInstr* param = builder.emit(IROp::PARAM, paramType);
+            param->imm = i;
+            fn->paramTypes.push_back(paramType);
+            paramValues.push_back(param);
+        }
+        for (int i = 0; i < (int)paramNames.size(); i++) {
+            builder.writeVariable(body->frame, paramNames[i], paramValues[i]);
+        }
+
+        // self recursive tail calls jump back to here with new values for the parameters
+        if (body->frame->tailCallLabel != "") {
+            builder.tailCallTarget = fn->newBlock();
+            builder.jump(builder.tailCallTarget);
+            builder.setBlock(builder.tailCallTarget);
+        }
+
+        body->lower(builder);
+
+        // void functions return 0 like in compileFunction
+        if (!builder.isTerminated()) {
+            bool isFloat = fn->returnType == IRType::FLOAT || fn->returnType == IRType::DOUBLE;
+            builder.ret(isFloat ? nullptr : builder.constant(0));
+        }
+        if (builder.tailCallTarget != nullptr) {
+            builder.sealBlock(builder.tailCallTarget);
+        }
+        builder.finish();
+    } catch (const IRUnsupported &e) {
+        delete fn;
+        return nullptr;
+    }
+    return fn;
 }
 
-AST* AST_FunDeclaration::getType(){
+void AST_FunDeclaration::lower(IRBuilder &builder) {
+    // declarations of other functions inside the body
+    if (body != nullptr) {
+        throw IRUnsupported("AST_FunDeclaration: function defined inside a function.\n");
+    }
+}
+
+AST* AST_FunDeclaration::computeType(){
     return type;
 }
 
@@ -276,30 +331,35 @@ int AST_FunDeclaration::getBytes(){
     return type->getBytes();
 }
 
-std::string AST_FunDeclaration::getTypeName(){
+std::string AST_FunDeclaration::computeTypeName(){
     return type->getTypeName();
 }
 
-AST_FunDeclaration::~AST_FunDeclaration() {
-    delete type;
-    if (body != nullptr) {
-        delete body;
-    }
-    if (params != nullptr){
-        delete params;
+std::string AST_FunDeclaration::getName(){
+    return name;
+}
+
+std::vector<std::string> AST_FunDeclaration::getParamNames(){
+    std::vector<std::string> names;
+    if(params != nullptr){
+        for(auto param = params->rbegin(); param != params->rend(); param++){
+            names.push_back(param->second);
+        }
     }
+    return names;
 }
 
-AST_VarDeclaration::AST_VarDeclaration(AST* _type, std::string* _name, AST* _expr) :
+AST_VarDeclaration::AST_VarDeclaration(AST* _type, const std::string* _name, AST* _expr) :
     type(_type),
     name(*_name),
     expr(_expr)
 {}
 
 // Used for struct
-AST_VarDeclaration::AST_VarDeclaration(AST* _type, std::string* _name, const std::map<std::string, std::string> &_structAttributeNameTypeMap) :
+AST_VarDeclaration::AST_VarDeclaration(AST* _type, const std::string* _name, const std::map<std::string, std::string> &_structAttributeNameTypeMap) :
     type(_type),
     name(*_name),
+    expr(nullptr),
     structAttributeNameTypeMap(_structAttributeNameTypeMap)
 {}
 
@@ -311,6 +371,21 @@ void AST_VarDeclaration::generateFrames(Frame* _frame){
     }
     
     _frame->addVariable(name, type, type->getBytes());
+    if (RegisterAllocator::current != nullptr) {
+        RegisterAllocator::current->declareVariable(_frame, name, type);
+    }
+
+    if (isEnumConstant) {
+        _frame->addEnumConstant(name, expr->getIntValue());
+    }
+}
+
+AST* AST_VarDeclaration::fold(){
+    // global initializers are emitted as data so they must be folded to a constant
+    if (expr != nullptr) {
+        expr = expr->fold();
+    }
+    return this;
 }
 
 AST* AST_VarDeclaration::deepCopy(){
@@ -323,51 +398,38 @@ AST* AST_VarDeclaration::deepCopy(){
 }
 
 void AST_VarDeclaration::compile(std::ostream &assemblyOut) {
-    std::string varType = this->getType()->getTypeName();
+    TypeKind varType = this->getType()->getTypeKind();
     if (expr != nullptr) {
 
-        assemblyOut << std::endl << "# start " << varType << " var dec with definition " << name << std::endl;
+        assemblyOut << std::endl << "# start " << this->getType()->getTypeName() << " var dec with definition " << name << std::endl;
 
         if (this->frame->isGlobal) {
-            if (varType == "float") {
+            // folded even with -fno-fold, the data has to be a constant
+            expr = expr->fold();
+            if (varType == TypeKind::FLOAT) {
                 valueToVarLabel(assemblyOut, this->name, expr->getFloatValue());
-            } else if (varType == "double") {
+            } else if (varType == TypeKind::DOUBLE) {
                 valueToVarLabel(assemblyOut, this->name, expr->getDoubleValue());
-            } else if (varType == "char") {
+            } else if (varType == TypeKind::CHAR) {
                 valueToVarLabel(assemblyOut, this->name, (char)expr->getIntValue());
             } else {
                 valueToVarLabel(assemblyOut, this->name, expr->getIntValue());
             }
         } else {
-            expr->compile(assemblyOut);
-
-            // load top of stack into register
-            if (varType == "float") {
-                assemblyOut << "l.s $f4, 8($sp)" << std::endl;
-                assemblyOut << "addiu $sp, $sp, 8" << std::endl;
-
-                regToVar(assemblyOut, frame, "$f4", name);
-            } else if (varType == "double") {
-                assemblyOut << "l.d $f4, 8($sp)" << std::endl;
-                assemblyOut << "addiu $sp, $sp, 8" << std::endl;
-
-                regToVar(assemblyOut, frame, "$f4", name);
-            } else {
-                assemblyOut << "lw $t0, 8($sp)" << std::endl;
-                assemblyOut << "addiu $sp, $sp, 8" << std::endl;
-
-                regToVar(assemblyOut, frame, "$t0", name);
-            }
+            std::string reg = allocateReg(usesFloatReg(expr));
+            expr->compileToReg(assemblyOut, reg);
+            regToVar(assemblyOut, frame, reg, name);
+            freeReg(reg);
         }
         
-        assemblyOut << "# end " << varType << " var dec with definition " << name << std::endl << std::endl;
+        assemblyOut << "# end " << this->getType()->getTypeName() << " var dec with definition " << name << std::endl << std::endl;
     }
     else if(this->frame->isGlobal){
-        if (varType == "float") {
+        if (varType == TypeKind::FLOAT) {
             valueToVarLabel(assemblyOut, this->name, (double)0);
-        } else if (varType == "double") {
+        } else if (varType == TypeKind::DOUBLE) {
             valueToVarLabel(assemblyOut, this->name, (float)0);
-        } else if (varType == "char"){
+        } else if (varType == TypeKind::CHAR){
             valueToVarLabel(assemblyOut, this->name, (char)0);
         } else {
             valueToVarLabel(assemblyOut, this->name, (int)0);
@@ -375,7 +437,13 @@ void AST_VarDeclaration::compile(std::ostream &assemblyOut) {
     }
 }
 
-AST* AST_VarDeclaration::getType() {
+void AST_VarDeclaration::lower(IRBuilder &builder) {
+    if (expr != nullptr) {
+        builder.writeVariable(frame, name, expr->lowerToValue(builder));
+    }
+}
+
+AST* AST_VarDeclaration::computeType() {
     return type;
 }
 
@@ -391,25 +459,21 @@ std::string AST_VarDeclaration::getStructName() {
     return this->structName;
 }
 
-AST_VarDeclaration::~AST_VarDeclaration() {
-    delete type;
-    if(expr != nullptr)
-        delete expr; 
-}
-
-AST_ArrayDeclaration::AST_ArrayDeclaration(AST* _type, std::string* _name) :
+AST_ArrayDeclaration::AST_ArrayDeclaration(AST* _type, const std::string* _name) :
     type(_type),
-    name(*_name)
+    name(*_name),
+    initializerList1D(nullptr),
+    initializerList2D(nullptr)
 {}
 
-AST_ArrayDeclaration::AST_ArrayDeclaration(AST* _type, std::string* _name, std::vector<AST*>* initializerList) :
+AST_ArrayDeclaration::AST_ArrayDeclaration(AST* _type, const std::string* _name, std::vector<AST*>* initializerList) :
     type(_type),
     name(*_name),
     initializerList1D(initializerList),
     initializerList2D({})
 {}
 
-AST_ArrayDeclaration::AST_ArrayDeclaration(AST* _type, std::string* _name, std::vector<std::vector<AST*>*>* initializerList) :
+AST_ArrayDeclaration::AST_ArrayDeclaration(AST* _type, const std::string* _name, std::vector<std::vector<AST*>*>* initializerList) :
     type(_type),
     name(*_name),
     initializerList1D({}),
@@ -429,6 +493,24 @@ void AST_ArrayDeclaration::generateFrames(Frame* _frame){
     _frame->addVariable(name, type, pointer_size);
 }
 
+AST* AST_ArrayDeclaration::fold(){
+    // the elements are shared with the assignments generated by the parser, which give them their frames
+    // global arrays are initialized from these lists so they have to be constants
+    if (initializerList1D != nullptr) {
+        for (AST*& element : *initializerList1D) {
+            element = element->fold();
+        }
+    }
+    if (initializerList2D != nullptr) {
+        for (std::vector<AST*>* row : *initializerList2D) {
+            for (AST*& element : *row) {
+                element = element->fold();
+            }
+        }
+    }
+    return this;
+}
+
 AST* AST_ArrayDeclaration::deepCopy(){
     AST* new_type = type->deepCopy();
     return new AST_ArrayDeclaration(new_type, &name);
@@ -438,9 +520,10 @@ void AST_ArrayDeclaration::compile(std::ostream &assemblyOut) {
     // get pointer to start of allocated memory space
     // always a double word away from allocated memory space
     if (this->frame->isGlobal){
-            std::string varType = this->getType()->getType()->getTypeName();
-            if (varType == "pointer") {
-                varType = this->getType()->getType()->getType()->getTypeName();
+            fold();
+            TypeKind varType = this->getType()->getType()->getTypeKind();
+            if (varType == TypeKind::POINTER) {
+                varType = this->getType()->getType()->getType()->getTypeKind();
             }
             
             assemblyOut << ".data" << std::endl;
@@ -450,18 +533,18 @@ void AST_ArrayDeclaration::compile(std::ostream &assemblyOut) {
 
             assemblyOut << name << ":" << std::endl;
             if (initializerList1D != nullptr && !initializerList1D->empty()) {
-                    if (varType == "float") {
+                    if (varType == TypeKind::FLOAT) {
                         for (int i = 0; i < type->getBytes(); i+=4) {
                             ieee754Float.fnum = initializerList1D->at(i/4)->getFloatValue();
                             assemblyOut << ".word " << ieee754Float.num << std::endl;
                         }
-                    } else if (varType == "double") {
+                    } else if (varType == TypeKind::DOUBLE) {
                         for (int i = 0; i < type->getBytes(); i+=8) {
                             ieee754Double.dnum = initializerList1D->at(i/8)->getDoubleValue();
                             assemblyOut << ".word " << (ieee754Double.num >> 32) << std::endl;
                             assemblyOut << ".word " << (ieee754Double.num & 0xFFFFFFFF) << std::endl;
                         }
-                    } else if (varType == "char") {
+                    } else if (varType == TypeKind::CHAR) {
                         for (int i = 0; i < type->getBytes(); i++) {
                             assemblyOut << ".byte " << initializerList1D->at(i)->getIntValue() << std::endl;
                         }
@@ -471,14 +554,14 @@ void AST_ArrayDeclaration::compile(std::ostream &assemblyOut) {
                         }
                     }
                 } else if(initializerList2D != nullptr && !initializerList2D->empty()) {
-                    if (varType == "float") {
+                    if (varType == TypeKind::FLOAT) {
                         for (int i=0; i<initializerList2D->size(); i++) {
                             for (int j=0; j<initializerList2D->at(0)->size(); j++) {
                                 ieee754Float.fnum = initializerList2D->at(i)->at(j)->getFloatValue();
                                 assemblyOut << ".word " << ieee754Float.num << std::endl;
                             }
                         }
-                    } else if (varType == "double") {
+                    } else if (varType == TypeKind::DOUBLE) {
                         for (int i=0; i<initializerList2D->size(); i++) {
                             for (int j=0; j<initializerList2D->at(0)->size(); j++) {
                                 ieee754Double.dnum = initializerList2D->at(i)->at(j)->getDoubleValue();
@@ -486,7 +569,7 @@ void AST_ArrayDeclaration::compile(std::ostream &assemblyOut) {
                                 assemblyOut << ".word " << (ieee754Double.num & 0xFFFFFFFF) << std::endl;
                             }
                         }
-                    } else if (varType == "char") {
+                    } else if (varType == TypeKind::CHAR) {
                         for (int i=0; i<initializerList2D->size(); i++) {
                             for (int j=0; j<initializerList2D->at(0)->size(); j++) {
                                 assemblyOut << ".byte " << initializerList2D->at(i)->at(j)->getIntValue() << std::endl;
@@ -514,7 +597,14 @@ void AST_ArrayDeclaration::compile(std::ostream &assemblyOut) {
     }
 }
 
-AST* AST_ArrayDeclaration::getType() {
+void AST_ArrayDeclaration::lower(IRBuilder &builder) {
+    // the variable holds the address of the elements
+    IRInstr* elements = builder.emit(IROp::SLOT, IRType::WORD);
+    elements->imm = builder.fn->newSlot(type->getBytes());
+    builder.writeVariable(frame, name, elements);
+}
+
+AST* AST_ArrayDeclaration::computeType() {
     return this->type;
 }
 
@@ -522,6 +612,3 @@ std::string AST_ArrayDeclaration::getName() {
     return this->name;
 }
 
-AST_ArrayDeclaration::~AST_ArrayDeclaration(){
-    delete type;
-}
@@ -20,11 +20,11 @@ public:
     void generateFrames(Frame* _frame = nullptr) override;
     AST* deepCopy() override;
     void compile(std::ostream &assemblyOut) override;
+    void lower(IRBuilder &builder) override;
+    AST* fold() override;
 
     void setStructName(std::string newName) override;
     std::string getStructName() override;
-
-    ~AST_Sequence();
 };
 
 class AST_FunDeclaration
@@ -32,27 +32,40 @@ class AST_FunDeclaration
 {
 private:
     AST* type;
-    std::string name;
+    const std::string &name;
     AST* body;
     int parity;
     // first in params is type, second is variable name
     std::vector<std::pair<AST*, std::string>>* params;
 
+    // code of a function with a body, before it is optimised (see assembly.hpp)
+    void compileFunction(std::ostream &assemblyOut);
+    // directives before and after the code of the function
+    void compileHeader(std::ostream &assemblyOut);
+    void compileFooter(std::ostream &assemblyOut);
+
 public:
     /*
         Function body is optional and can be provided in a function definition later on.
     */
-    AST_FunDeclaration(AST* type, std::string* _name, AST* _body = nullptr, std::vector<std::pair<AST*,std::string>>* _params = nullptr);
+    AST_FunDeclaration(AST* type, const std::string* _name, AST* _body = nullptr, std::vector<std::pair<AST*,std::string>>* _params = nullptr);
 
     void generateFrames(Frame* _frame = nullptr) override;
     AST* deepCopy() override;
     void compile(std::ostream &assemblyOut) override;
+    void lower(IRBuilder &builder) override;
+    AST* fold() override;
 
-    AST* getType() override;
+    AST* computeType() override;
     int getBytes() override;
-    std::string getTypeName() override;
+    std::string computeTypeName() override;
+    std::string getName() override;
+
+    // in argument order
+    std::vector<std::string> getParamNames();
 
-    ~AST_FunDeclaration();
+    // IR of the function, nullptr if it has no body or uses something the IR doesn't support
+    IRFunction* lowerFunction();
 };
 
 /*
@@ -63,7 +76,7 @@ class AST_VarDeclaration
 {
 private:
     AST* type;
-    std::string name;
+    const std::string &name;
     AST* expr;
 
     // Used for struct
@@ -71,22 +84,25 @@ private:
     std::map<std::string, std::string> structAttributeNameTypeMap;
 
 public:
-    AST_VarDeclaration(AST* _type, std::string* _name, AST* _expr = nullptr);
+    // set by the parser for the constants of an enum
+    bool isEnumConstant = false;
+
+    AST_VarDeclaration(AST* _type, const std::string* _name, AST* _expr = nullptr);
 
     // Used for struct
-    AST_VarDeclaration(AST* _type, std::string* _name, const std::map<std::string, std::string> &_structAttributeNameTypeMap);
+    AST_VarDeclaration(AST* _type, const std::string* _name, const std::map<std::string, std::string> &_structAttributeNameTypeMap);
 
     void generateFrames(Frame* _frame = nullptr) override;
     AST* deepCopy() override;
     void compile(std::ostream &assemblyOut) override;
-    AST* getType() override;
+    void lower(IRBuilder &builder) override;
+    AST* fold() override;
+    AST* computeType() override;
 
     std::string getName() override;
 
     void setStructName(std::string newName) override;
     std::string getStructName() override;
-
-    ~AST_VarDeclaration();
 };
 
 class AST_ArrayDeclaration
@@ -94,25 +110,25 @@ class AST_ArrayDeclaration
 {
 private:
     AST* type;
-    std::string name;
+    const std::string &name;
 
     std::vector<AST*>* initializerList1D;
     std::vector<std::vector<AST*>*>* initializerList2D;
 public:
-    AST_ArrayDeclaration(AST* _type, std::string* _name);
+    AST_ArrayDeclaration(AST* _type, const std::string* _name);
 
     // 1D array initializer list
-    AST_ArrayDeclaration(AST* _type, std::string* _name, std::vector<AST*>* initializerList);
+    AST_ArrayDeclaration(AST* _type, const std::string* _name, std::vector<AST*>* initializerList);
 
     // 2D array initializer list
-    AST_ArrayDeclaration(AST* _type, std::string* _name, std::vector<std::vector<AST*>*>* initializerList);
+    AST_ArrayDeclaration(AST* _type, const std::string* _name, std::vector<std::vector<AST*>*>* initializerList);
 
     void generateFrames(Frame* _frame = nullptr) override;
     AST* deepCopy() override;
     void compile(std::ostream &assemblyOut) override;
-    AST* getType() override;
+    void lower(IRBuilder &builder) override;
+    AST* fold() override;
+    AST* computeType() override;
 
     std::string getName() override;
-
-    ~AST_ArrayDeclaration();
 };
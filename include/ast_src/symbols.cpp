@@ -0,0 +1,17 @@
+#include "symbols.hpp"
+
+Symbols::Pool& Symbols::pool() {
+    static Pool pool;
+    return pool;
+}
+
+const std::string* Symbols::intern(std::string_view spelling) {
+    Pool& symbols = pool();
+    auto it = symbols.index.find(spelling);
+    if (it != symbols.index.end()) {
+        return it->second;
+    }
+    const std::string* interned = &symbols.spellings.emplace_back(spelling);
+    symbols.index.emplace(*interned, interned);
+    return interned;
+}
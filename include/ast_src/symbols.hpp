@@ -0,0 +1,29 @@
+#pragma once
+
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/*
+    Pool of the identifiers, type names and string literals of the program.
+
+    Every spelling is stored once and never moves or gets freed, so tokens and AST nodes refer
+    to the interned string instead of owning a copy of it. Interning a spelling that is already
+    in the pool doesn't allocate.
+*/
+class Symbols
+{
+public:
+    static const std::string* intern(std::string_view spelling);
+
+private:
+    struct Pool {
+        // a deque doesn't move its elements when it grows
+        std::deque<std::string> spellings;
+        std::unordered_map<std::string_view, const std::string*> index;
+    };
+
+    // created on first use, globals of other files intern while they are initialised
+    static Pool& pool();
+};
@@ -7,17 +7,47 @@ std::string generateUniqueLabel(const std::string &labelName) {
 
 void regToVar(std::ostream &assemblyOut, Frame* frame, const std::string& reg, const std::string& var, const std::string& reg_2){
     std::pair<int, int> varAddress = frame->getVarAddress(var);
-    std::string varType = frame->getVarType(var)->getTypeName();
+    TypeKind varType = frame->getVarType(var)->getTypeKind();
+
+    // check if variable is held in a register
+    std::string varReg = frame->getVarReg(var);
+    if (varReg != "") {
+        if (varType == TypeKind::FLOAT) {
+            if(reg[1] == 'f'){
+                assemblyOut << "mov.s " << varReg << ", " << reg << std::endl;
+            }
+            else{
+                assemblyOut << "mtc1 " << reg << ", " << varReg << std::endl;
+            }
+        } else if (varType == TypeKind::DOUBLE) {
+            if(reg[1] == 'f'){
+                assemblyOut << "mov.d " << varReg << ", " << reg << std::endl;
+            }
+            else{
+                // reg holds the most significant word
+                int varRegNum = std::stoi(varReg.substr(2));
+                assemblyOut << "mtc1 " << reg << ", $f" << varRegNum + 1 << std::endl;
+                assemblyOut << "mtc1 " << reg_2 << ", " << varReg << std::endl;
+            }
+        } else if (varType == TypeKind::CHAR) {
+            // truncate the same way sb would
+            assemblyOut << "sll " << varReg << ", " << reg << ", 24" << std::endl;
+            assemblyOut << "sra " << varReg << ", " << varReg << ", 24" << std::endl;
+        } else {
+            assemblyOut << "move " << varReg << ", " << reg << std::endl;
+        }
+        return;
+    }
 
     // check if global variable => cannot be reached using stack
     if (varAddress.first == -1 && varAddress.second == -1) {
-        if (varType == "float") {
+        if (varType == TypeKind::FLOAT) {
             assemblyOut << "la $t6, " << var << std::endl;
             assemblyOut << "s.s " << reg << ", 0($t6)" << std::endl;
-        } else if (varType == "double") {
+        } else if (varType == TypeKind::DOUBLE) {
             assemblyOut << "la $t6, " << var << std::endl;
             assemblyOut << "s.d " << reg << ", 0($t6)" << std::endl;
-        } else if (varType == "char") {
+        } else if (varType == TypeKind::CHAR) {
             assemblyOut << "la $t6, " << var << std::endl;
             assemblyOut << "sb " << reg << ", 0($t6)" << std::endl;
         } else {
@@ -27,48 +57,56 @@ void regToVar(std::ostream &assemblyOut, Frame* frame, const std::string& reg, c
         return;
     }
     
-    // coppy frame pointer to t6 and recurse back expected number of frames
-    assemblyOut << "move $t6, $fp" << std::endl;
-    for(int i = 0; i < varAddress.first; i++){
-        assemblyOut << "lw $t6, 12($t6)" << std::endl;
-    }
-    
+    // all scopes of a function share the frame of the function so $fp can be used directly
     // store register data into variable's memory address
-    if (varType == "float") {
+    if (varType == TypeKind::FLOAT) {
         if(reg[1] == 'f'){
-            assemblyOut << "s.s " << reg << ", -" << varAddress.second << "($t6)" << std::endl;
+            assemblyOut << "s.s " << reg << ", -" << varAddress.second << "($fp)" << std::endl;
         }
         else{
-            assemblyOut << "sw " << reg << ", -" << varAddress.second << "($t6)" << std::endl;
+            assemblyOut << "sw " << reg << ", -" << varAddress.second << "($fp)" << std::endl;
         }
-    } else if (varType == "double") {
+    } else if (varType == TypeKind::DOUBLE) {
         if(reg[1] == 'f'){
-            assemblyOut << "s.d " << reg << ", -" << varAddress.second << "($t6)" << std::endl;
+            assemblyOut << "s.d " << reg << ", -" << varAddress.second << "($fp)" << std::endl;
         }
         else{
-            assemblyOut << "sw " << reg << ", -" << varAddress.second << "($t6)" << std::endl;
-            assemblyOut << "sw " << reg_2 << ", -" << varAddress.second - 4 << "($t6)" << std::endl;
+            assemblyOut << "sw " << reg << ", -" << varAddress.second << "($fp)" << std::endl;
+            assemblyOut << "sw " << reg_2 << ", -" << varAddress.second - 4 << "($fp)" << std::endl;
         }
-    } else if (varType == "char"){
-        assemblyOut << "sb " << reg << ", -" << varAddress.second << "($t6)" << std::endl;
+    } else if (varType == TypeKind::CHAR){
+        assemblyOut << "sb " << reg << ", -" << varAddress.second << "($fp)" << std::endl;
     } else {
-        assemblyOut << "sw " << reg << ", -" << varAddress.second << "($t6)" << std::endl;
+        assemblyOut << "sw " << reg << ", -" << varAddress.second << "($fp)" << std::endl;
     }
 }
 
 void varToReg(std::ostream &assemblyOut, Frame* frame, const std::string& reg, const std::string& var){
     std::pair<int, int> varAddress = frame->getVarAddress(var);
-    std::string varType = frame->getVarType(var)->getTypeName();
+    TypeKind varType = frame->getVarType(var)->getTypeKind();
+
+    // check if variable is held in a register
+    std::string varReg = frame->getVarReg(var);
+    if (varReg != "") {
+        if (varType == TypeKind::FLOAT) {
+            assemblyOut << "mov.s " << reg << ", " << varReg << std::endl;
+        } else if (varType == TypeKind::DOUBLE) {
+            assemblyOut << "mov.d " << reg << ", " << varReg << std::endl;
+        } else {
+            assemblyOut << "move " << reg << ", " << varReg << std::endl;
+        }
+        return;
+    }
 
     // check if global variable => cannot be reached using stack
     if (varAddress.first == -1 && varAddress.second == -1) {
-        if (varType == "float") {
+        if (varType == TypeKind::FLOAT) {
             assemblyOut << "la $t6, " << var << std::endl;
             assemblyOut << "l.s " << reg << ", 0($t6)" << std::endl;
-        } else if (varType == "double") {
+        } else if (varType == TypeKind::DOUBLE) {
             assemblyOut << "la $t6, " << var << std::endl;
             assemblyOut << "l.d " << reg << ", 0($t6)" << std::endl;
-        } else if (varType == "char") {
+        } else if (varType == TypeKind::CHAR) {
             assemblyOut << "la $t6, " << var << std::endl;
             assemblyOut << "lb " << reg << ", 0($t6)" << std::endl;
         } else {
@@ -78,41 +116,33 @@ void varToReg(std::ostream &assemblyOut, Frame* frame, const std::string& reg, c
         return;
     }
     
-    // coppy frame pointer to t6 and recurse back expected number of frames
-    assemblyOut << "move $t6, $fp" << std::endl;
-    for(int i = 0; i < varAddress.first; i++){
-        assemblyOut << "lw $t6, 12($t6)" << std::endl;
-    }
-    
     // load from memory into register
-    if (varType == "float") {
-        assemblyOut << "l.s " << reg << ", -" << varAddress.second << "($t6)" << std::endl;
-    } else if (varType == "double") {
-        assemblyOut << "l.d " << reg << ", -" << varAddress.second << "($t6)" << std::endl;
-    } else if (varType == "char") {
-        assemblyOut << "lb " << reg << ", -" << varAddress.second << "($t6)" << std::endl;
+    if (varType == TypeKind::FLOAT) {
+        assemblyOut << "l.s " << reg << ", -" << varAddress.second << "($fp)" << std::endl;
+    } else if (varType == TypeKind::DOUBLE) {
+        assemblyOut << "l.d " << reg << ", -" << varAddress.second << "($fp)" << std::endl;
+    } else if (varType == TypeKind::CHAR) {
+        assemblyOut << "lb " << reg << ", -" << varAddress.second << "($fp)" << std::endl;
     } else {
-        assemblyOut << "lw " << reg << ", -" << varAddress.second << "($t6)" << std::endl;
+        assemblyOut << "lw " << reg << ", -" << varAddress.second << "($fp)" << std::endl;
     }
 }
 
 void varAddressToReg(std::ostream &assemblyOut, Frame* frame, const std::string& reg, const std::string& var){
     std::pair<int, int> varAddress = frame->getVarAddress(var);
 
+    if (frame->getVarReg(var) != "") {
+        throw std::runtime_error("varAddressToReg: Variable " + var + " is held in a register.\n");
+    }
+
     // check if global variable => cannot be reached using stack
     if (varAddress.first == -1 && varAddress.second == -1) {
         assemblyOut << "la " << reg << ", " << var << std::endl;
         return;
     }
     
-    // coppy frame pointer to t6 and recurse back expected number of frames
-    assemblyOut << "move $t6, $fp" << std::endl;
-    for(int i = 0; i < varAddress.first; i++){
-        assemblyOut << "lw $t6, 12($t6)" << std::endl;
-    }
-    
     // store variable address into register
-    assemblyOut << "addiu " << reg << ", $t6, -" << varAddress.second << std::endl;
+    assemblyOut << "addiu " << reg << ", $fp, -" << varAddress.second << std::endl;
 }
 
 void valueToVarLabel(std::ostream &assemblyOut, std::string varLabel, char value) {
@@ -169,3 +199,458 @@ bool hasEnding(const std::string &fullString, const std::string &ending) {
         return false;
     }
 }
+
+// $t6 is left out on purpose (see util.hpp)
+static const std::vector<std::string> intRegs = {"$t0", "$t1", "$t2", "$t3", "$t4", "$t5", "$t7", "$t8", "$t9"};
+static const std::vector<std::string> floatRegs = {"$f4", "$f6", "$f8", "$f10", "$f12", "$f14", "$f16", "$f18"};
+static std::unordered_map<std::string, bool> usedRegs;
+
+std::string allocateReg(bool isFloat) {
+    for (const std::string &reg : isFloat ? floatRegs : intRegs) {
+        if (!usedRegs[reg]) {
+            usedRegs[reg] = true;
+            return reg;
+        }
+    }
+    throw std::runtime_error("allocateReg: Ran out of registers.\n");
+}
+
+void reserveReg(const std::string& reg) {
+    usedRegs[reg] = true;
+}
+
+void freeReg(const std::string& reg) {
+    usedRegs[reg] = false;
+}
+
+bool isRegFree(const std::string& reg) {
+    return !usedRegs[reg];
+}
+
+int availableRegs(bool isFloat) {
+    int count = 0;
+    for (const std::string &reg : isFloat ? floatRegs : intRegs) {
+        if (!usedRegs[reg]) {
+            count++;
+        }
+    }
+    return count;
+}
+
+bool enoughRegs(int need) {
+    // need does not distinguish between register types so check both
+    return availableRegs(false) >= need && availableRegs(true) >= need;
+}
+
+bool usesFloatReg(AST* expr) {
+    if (expr->returnPtr) {
+        return false;
+    }
+    TypeKind kind = expr->getType()->getTypeKind();
+    return kind == TypeKind::FLOAT || kind == TypeKind::DOUBLE;
+}
+
+void pushReg(std::ostream &assemblyOut, const std::string& reg) {
+    // unlike compile, the stack pointer is moved first so that nothing above it is
+    // overwritten (outgoing arguments of a call being set up live right at $sp)
+    assemblyOut << "addiu $sp, $sp, -8" << std::endl;
+
+    // s.d also works for floats and keeps spill slots uniform
+    if (reg[1] == 'f') {
+        assemblyOut << "s.d " << reg << ", 0($sp)" << std::endl;
+    } else {
+        assemblyOut << "sw " << reg << ", 0($sp)" << std::endl;
+    }
+}
+
+void popReg(std::ostream &assemblyOut, const std::string& reg) {
+    if (reg[1] == 'f') {
+        assemblyOut << "l.d " << reg << ", 0($sp)" << std::endl;
+    } else {
+        assemblyOut << "lw " << reg << ", 0($sp)" << std::endl;
+    }
+    assemblyOut << "addiu $sp, $sp, 8" << std::endl;
+}
+
+void reclaimReg(std::ostream &assemblyOut, const std::string& reg, std::string& other) {
+    // only "other" can have been given reg since everything else has been freed again
+    if (!isRegFree(reg)) {
+        other = allocateReg(reg[1] == 'f');
+        if (reg[1] == 'f') {
+            assemblyOut << "mov.d " << other << ", " << reg << std::endl;
+        } else {
+            assemblyOut << "move " << other << ", " << reg << std::endl;
+        }
+    }
+    reserveReg(reg);
+    popReg(assemblyOut, reg);
+}
+
+std::vector<std::string> saveLiveRegs(std::ostream &assemblyOut, const std::string& except) {
+    std::vector<std::string> live;
+    for (const std::vector<std::string> *regs : {&intRegs, &floatRegs}) {
+        for (const std::string &reg : *regs) {
+            if (usedRegs[reg] && reg != except) {
+                live.push_back(reg);
+            }
+        }
+    }
+    freeReg(except);
+
+    if (live.empty()) {
+        return live;
+    }
+
+    assemblyOut << "# (saving " << live.size() << " live registers)" << std::endl;
+    assemblyOut << "addiu $sp, $sp, -" << 8 * live.size() << std::endl;
+    for (int i = 0; i < (int)live.size(); i++) {
+        std::string store = live[i][1] == 'f' ? "s.d " : "sw ";
+        assemblyOut << store << live[i] << ", " << 8 * i << "($sp)" << std::endl;
+        freeReg(live[i]);
+    }
+
+    return live;
+}
+
+void restoreLiveRegs(std::ostream &assemblyOut, const std::vector<std::string>& regs, const std::string& except) {
+    reserveReg(except);
+
+    if (regs.empty()) {
+        return;
+    }
+
+    assemblyOut << "# (restoring " << regs.size() << " live registers)" << std::endl;
+    for (int i = 0; i < (int)regs.size(); i++) {
+        std::string load = regs[i][1] == 'f' ? "l.d " : "lw ";
+        assemblyOut << load << regs[i] << ", " << 8 * i << "($sp)" << std::endl;
+        reserveReg(regs[i]);
+    }
+    assemblyOut << "addiu $sp, $sp, " << 8 * regs.size() << std::endl;
+}
+
+int argumentLocations(const std::vector<TypeKind>& kinds, std::vector<int>& offsets, std::vector<std::string>& regs) {
+    offsets.clear();
+    regs.clear();
+
+    // floating point registers can only be used until the first integer argument
+    bool allowFReg = true;
+    int availableFReg = 12;
+    int argMemSize = 0;
+    for (TypeKind kind : kinds) {
+        bool isFloat = kind == TypeKind::FLOAT || kind == TypeKind::DOUBLE;
+        if (kind == TypeKind::DOUBLE && argMemSize % 8) {
+            argMemSize += 4;
+        }
+
+        std::string reg = "";
+        if (isFloat && allowFReg) {
+            reg = "$f" + std::to_string(availableFReg);
+            availableFReg += 2;
+            allowFReg = availableFReg < 16;
+        } else if (argMemSize < 16) {
+            reg = "$a" + std::to_string(argMemSize / 4);
+        }
+        if (!isFloat) {
+            allowFReg = false;
+        }
+
+        offsets.push_back(argMemSize);
+        regs.push_back(reg);
+        argMemSize += kind == TypeKind::DOUBLE ? 8 : 4;
+    }
+
+    // space for the argument registers is always reserved
+    // stack frame must be doubleword aligned
+    if (argMemSize < 16) {
+        argMemSize = 16;
+    }
+    if (argMemSize % 8) {
+        argMemSize += 4;
+    }
+    return argMemSize;
+}
+
+void compileCondToReg(std::ostream &assemblyOut, AST* cond, const std::string& reg) {
+    if (!usesFloatReg(cond)) {
+        cond->compileToReg(assemblyOut, reg);
+        return;
+    }
+
+    // floating point conditions are tested on the bits of their (most significant) word
+    std::string fReg = allocateReg(true);
+    cond->compileToReg(assemblyOut, fReg);
+    if (cond->getType()->getTypeKind() == TypeKind::DOUBLE) {
+        assemblyOut << "mfc1 " << reg << ", $f" << std::stoi(fReg.substr(2)) + 1 << std::endl;
+    } else {
+        assemblyOut << "mfc1 " << reg << ", " << fReg << std::endl;
+    }
+    freeReg(fReg);
+}
+
+TypeKind constantKind(AST* node) {
+    if (dynamic_cast<AST_ConstInt*>(node) != nullptr || dynamic_cast<AST_ConstChar*>(node) != nullptr) {
+        return TypeKind::INT;
+    } else if (dynamic_cast<AST_ConstFloat*>(node) != nullptr) {
+        return TypeKind::FLOAT;
+    } else if (dynamic_cast<AST_ConstDouble*>(node) != nullptr) {
+        return TypeKind::DOUBLE;
+    }
+    return TypeKind::VOID;
+}
+
+AST* makeConstant(AST* replaced, int value) {
+    AST* constant = new AST_ConstInt(value);
+    constant->generateFrames(replaced->frame);
+    return constant;
+}
+
+AST* makeConstant(AST* replaced, float value) {
+    AST* constant = new AST_ConstFloat(value);
+    constant->generateFrames(replaced->frame);
+    return constant;
+}
+
+AST* makeConstant(AST* replaced, double value) {
+    AST* constant = new AST_ConstDouble(value);
+    constant->generateFrames(replaced->frame);
+    return constant;
+}
+
+static bool isPowerOfTwo(uint32_t value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+static int floorLog2(uint32_t value) {
+    int n = 0;
+    while (value > 1) {
+        value >>= 1;
+        n++;
+    }
+    return n;
+}
+
+void multiplyByConstant(std::ostream &assemblyOut, const std::string& dst, const std::string& src, int factor) {
+    // x*-c is -(x*c), INT32_MIN is its own absolute value and a power of two
+    bool negate = factor < 0 && factor != INT32_MIN;
+    uint32_t c = negate ? 0u - (uint32_t)factor : (uint32_t)factor;
+
+    // c = 2^high + 2^low or 2^high - 2^low
+    uint32_t lowBit = c & (0u - c);
+    uint32_t rest = c - lowBit;
+    bool sum = isPowerOfTwo(rest);
+    bool difference = !sum && isPowerOfTwo(c + lowBit);
+    int low = floorLog2(lowBit);
+    int high = floorLog2(sum ? rest : c + lowBit);
+
+    if (c == 0) {
+        assemblyOut << "move " << dst << ", $0" << std::endl;
+        return;
+    } else if (c == 1) {
+        assemblyOut << "move " << dst << ", " << src << std::endl;
+    } else if (isPowerOfTwo(c)) {
+        assemblyOut << "sll " << dst << ", " << src << ", " << floorLog2(c) << std::endl;
+    } else if ((sum || difference) && high < 32) {
+        // src is read by the second shift before dst is written
+        std::string op = sum ? "addu " : "subu ";
+        assemblyOut << "sll $t6, " << src << ", " << high << std::endl;
+        if (low == 0) {
+            assemblyOut << op << dst << ", $t6, " << src << std::endl;
+        } else {
+            assemblyOut << "sll " << dst << ", " << src << ", " << low << std::endl;
+            assemblyOut << op << dst << ", $t6, " << dst << std::endl;
+        }
+    } else {
+        assemblyOut << "li $t6, " << factor << std::endl;
+        assemblyOut << "mul " << dst << ", " << src << ", $t6" << std::endl;
+        return;
+    }
+
+    if (negate) {
+        assemblyOut << "subu " << dst << ", $0, " << dst << std::endl;
+    }
+}
+
+bool canDivideByConstant(int divisor, bool isUnsigned) {
+    if (isUnsigned) {
+        return isPowerOfTwo(divisor);
+    }
+    return divisor != 0 && divisor != INT32_MIN;
+}
+
+/*
+    Magic number and shift for signed division by d >= 2 such that
+    x/d = (hi(x * magic) + x if magic < 0) >> shift, plus one if x is negative.
+    See Hacker's Delight, chapter 10.
+*/
+static void signedMagic(uint32_t d, int32_t &magic, int &shift) {
+    const uint32_t two31 = 0x80000000u;
+    uint32_t anc = two31 - 1 - two31 % d;
+    uint32_t q1 = two31 / anc, r1 = two31 - q1 * anc;
+    uint32_t q2 = two31 / d, r2 = two31 - q2 * d;
+    int p = 31;
+    uint32_t delta;
+    do {
+        p++;
+        q1 *= 2; r1 *= 2;
+        if (r1 >= anc) { q1++; r1 -= anc; }
+        q2 *= 2; r2 *= 2;
+        if (r2 >= d) { q2++; r2 -= d; }
+        delta = d - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+    magic = (int32_t)(q2 + 1);
+    shift = p - 32;
+}
+
+void divideByConstant(std::ostream &assemblyOut, const std::string& dst, const std::string& src, int divisor, bool isUnsigned, bool remainder) {
+    if (isUnsigned) {
+        uint32_t d = divisor;
+        if (!remainder) {
+            assemblyOut << "srl " << dst << ", " << src << ", " << floorLog2(d) << std::endl;
+        } else if (d - 1 <= 0xffff) {
+            assemblyOut << "andi " << dst << ", " << src << ", " << d - 1 << std::endl;
+        } else {
+            assemblyOut << "li $t6, " << d - 1 << std::endl;
+            assemblyOut << "and " << dst << ", " << src << ", $t6" << std::endl;
+        }
+        return;
+    }
+
+    // x/-d is -(x/d) and x%-d is x%d
+    uint32_t d = divisor < 0 ? 0u - (uint32_t)divisor : divisor;
+    bool negate = divisor < 0 && !remainder;
+
+    if (d == 1) {
+        if (remainder) {
+            assemblyOut << "move " << dst << ", $0" << std::endl;
+            return;
+        }
+        assemblyOut << "move " << dst << ", " << src << std::endl;
+    } else if (isPowerOfTwo(d)) {
+        // negative values are rounded towards zero by adding d-1 before shifting
+        int k = floorLog2(d);
+        if (k > 1) {
+            assemblyOut << "sra $t6, " << src << ", 31" << std::endl;
+            assemblyOut << "srl $t6, $t6, " << 32 - k << std::endl;
+        } else {
+            assemblyOut << "srl $t6, " << src << ", 31" << std::endl;
+        }
+        assemblyOut << "addu $t6, " << src << ", $t6" << std::endl;
+        if (remainder) {
+            // x - (x rounded towards zero to a multiple of d)
+            assemblyOut << "sra $t6, $t6, " << k << std::endl;
+            assemblyOut << "sll $t6, $t6, " << k << std::endl;
+            assemblyOut << "subu " << dst << ", " << src << ", $t6" << std::endl;
+            return;
+        }
+        assemblyOut << "sra " << dst << ", $t6, " << k << std::endl;
+    } else if (remainder) {
+        // x - x/d*d, src is still needed after the quotient is known
+        std::string quotient = allocateReg(false);
+        divideByConstant(assemblyOut, quotient, src, d, false, false);
+        multiplyByConstant(assemblyOut, quotient, quotient, d);
+        assemblyOut << "subu " << dst << ", " << src << ", " << quotient << std::endl;
+        freeReg(quotient);
+        return;
+    } else {
+        int32_t magic;
+        int shift;
+        signedMagic(d, magic, shift);
+        assemblyOut << "li $t6, " << magic << std::endl;
+        assemblyOut << "mult " << src << ", $t6" << std::endl;
+        assemblyOut << "mfhi $t6" << std::endl;
+        if (magic < 0) {
+            assemblyOut << "addu $t6, $t6, " << src << std::endl;
+        }
+        if (shift > 0) {
+            assemblyOut << "sra $t6, $t6, " << shift << std::endl;
+        }
+        assemblyOut << "srl " << dst << ", " << src << ", 31" << std::endl;
+        assemblyOut << "addu " << dst << ", $t6, " << dst << std::endl;
+    }
+
+    if (negate) {
+        assemblyOut << "subu " << dst << ", $0, " << dst << std::endl;
+    }
+}
+
+static void compileJumpTable(std::ostream& assemblyOut, const std::string& valueReg, const std::string& indexReg, const std::vector<std::pair<int, std::string>>& cases, const std::string& defaultLabel) {
+    std::string tableLabel = generateUniqueLabel("jumpTable");
+    int min = cases.front().first;
+    int range = cases.back().first - min + 1;
+
+    // index into the table, values below the minimum wrap around to large unsigned values
+    assemblyOut << "# " << tableLabel << " covers " << min << " to " << cases.back().first << std::endl;
+    if (min >= -32767 && min <= 32768) {
+        assemblyOut << "addiu " << indexReg << ", " << valueReg << ", " << -min << std::endl;
+    } else {
+        assemblyOut << "li $t6, " << min << std::endl;
+        assemblyOut << "subu " << indexReg << ", " << valueReg << ", $t6" << std::endl;
+    }
+    if (range <= 32767) {
+        assemblyOut << "sltiu $t6, " << indexReg << ", " << range << std::endl;
+    } else {
+        assemblyOut << "li $t6, " << range << std::endl;
+        assemblyOut << "sltu $t6, " << indexReg << ", $t6" << std::endl;
+    }
+    assemblyOut << "beq $t6, $0, " << defaultLabel << std::endl;
+    assemblyOut << "nop" << std::endl;
+
+    assemblyOut << "sll " << indexReg << ", " << indexReg << ", 2" << std::endl;
+    assemblyOut << "la $t6, " << tableLabel << std::endl;
+    assemblyOut << "addu " << indexReg << ", " << indexReg << ", $t6" << std::endl;
+    assemblyOut << "lw " << indexReg << ", 0(" << indexReg << ")" << std::endl;
+    assemblyOut << "jr " << indexReg << std::endl;
+    assemblyOut << "nop" << std::endl;
+
+    // values without a case go to default
+    assemblyOut << ".rdata" << std::endl;
+    assemblyOut << ".align 2" << std::endl;
+    assemblyOut << tableLabel << ":" << std::endl;
+    auto it = cases.begin();
+    for (int i = 0; i < range; i++) {
+        if (it != cases.end() && it->first == min + i) {
+            assemblyOut << ".word " << it->second << std::endl;
+            it++;
+        } else {
+            assemblyOut << ".word " << defaultLabel << std::endl;
+        }
+    }
+    assemblyOut << ".text" << std::endl;
+}
+
+static void compileBinarySearch(std::ostream& assemblyOut, const std::string& valueReg, const std::vector<std::pair<int, std::string>>& cases, int lo, int hi, const std::string& defaultLabel) {
+    // compare one by one once there are only a few cases left
+    if (hi - lo < 3) {
+        for (int i = lo; i <= hi; i++) {
+            assemblyOut << "li $t6, " << cases[i].first << std::endl;
+            assemblyOut << "beq " << valueReg << ", $t6, " << cases[i].second << std::endl;
+            assemblyOut << "nop" << std::endl;
+        }
+        assemblyOut << "j " << defaultLabel << std::endl;
+        assemblyOut << "nop" << std::endl;
+        return;
+    }
+
+    int mid = (lo + hi) / 2;
+    std::string lessLabel = generateUniqueLabel("switchLess");
+    assemblyOut << "li $t6, " << cases[mid].first << std::endl;
+    assemblyOut << "beq " << valueReg << ", $t6, " << cases[mid].second << std::endl;
+    assemblyOut << "nop" << std::endl;
+    assemblyOut << "slt $t6, " << valueReg << ", $t6" << std::endl;
+    assemblyOut << "bne $t6, $0, " << lessLabel << std::endl;
+    assemblyOut << "nop" << std::endl;
+
+    compileBinarySearch(assemblyOut, valueReg, cases, mid + 1, hi, defaultLabel);
+    assemblyOut << lessLabel << ":" << std::endl;
+    compileBinarySearch(assemblyOut, valueReg, cases, lo, mid - 1, defaultLabel);
+}
+
+void compileSwitchDispatch(std::ostream& assemblyOut, const std::string& valueReg, const std::string& indexReg, const std::vector<std::pair<int, std::string>>& cases, const std::string& defaultLabel) {
+    // use a jump table if at least a third of the range of values has a case
+    long long range = cases.empty() ? 0 : (long long)cases.back().first - cases.front().first + 1;
+    if (cases.size() >= 4 && range <= 3 * (long long)cases.size()) {
+        compileJumpTable(assemblyOut, valueReg, indexReg, cases, defaultLabel);
+    } else {
+        compileBinarySearch(assemblyOut, valueReg, cases, 0, (int)cases.size() - 1, defaultLabel);
+    }
+}
@@ -16,6 +16,7 @@ union {
 
 std::string generateUniqueLabel(const std::string &labelName);
 
+// variables held in a register (see regalloc.hpp) are moved directly
 // uses t6 as temporary
 void regToVar(std::ostream &assemblyOut, Frame* frame, const std::string& reg, const std::string& var, const std::string& reg_2 = "");
 
@@ -32,3 +33,80 @@ void valueToVarLabel(std::ostream &assemblyOut, std::string varLabel, double val
 
 // check if string ends with suffix
 bool hasEnding(const std::string &fullString, const std::string &ending);
+
+/*
+    Register pool used by compileToReg.
+
+    Integer values and pointers live in $t registers, floats and doubles in even $f registers.
+    $t6 is never handed out since it is the temporary of the helpers above.
+    The caller of compileToReg owns the destination register, everything else is
+    allocated and freed by the expression nodes themselves.
+*/
+std::string allocateReg(bool isFloat);
+void reserveReg(const std::string& reg);
+void freeReg(const std::string& reg);
+bool isRegFree(const std::string& reg);
+int availableRegs(bool isFloat);
+
+// true if an expression needing "need" registers can be evaluated without spilling
+bool enoughRegs(int need);
+
+// check if the value of an expression is held in a floating point register
+bool usesFloatReg(AST* expr);
+
+// spill register to the top of the stack and get it back
+void pushReg(std::ostream &assemblyOut, const std::string& reg);
+void popReg(std::ostream &assemblyOut, const std::string& reg);
+/*
+    Pops a register that was spilled and freed while another expression was evaluated into "other".
+    If reg has been handed out to "other" in the meantime, "other" is moved to a new register first.
+*/
+void reclaimReg(std::ostream &assemblyOut, const std::string& reg, std::string& other);
+
+/*
+    Temporary registers are not preserved over function calls.
+    saveLiveRegs stores every allocated register except "except" on the stack and frees them
+    (including "except") so they can be used for the arguments of the call.
+    restoreLiveRegs loads them back and reserves them again.
+*/
+std::vector<std::string> saveLiveRegs(std::ostream &assemblyOut, const std::string& except);
+void restoreLiveRegs(std::ostream &assemblyOut, const std::vector<std::string>& regs, const std::string& except);
+
+/*
+    Locations of the arguments of a call (o32 calling convention), given their types in argument order.
+    offsets are relative to the start of the argument area, regs is "" for arguments passed in memory only.
+    A double passed in integer registers uses regs[i] for its most significant word and the next one for the other.
+    Returns the size of the argument area.
+*/
+int argumentLocations(const std::vector<TypeKind>& kinds, std::vector<int>& offsets, std::vector<std::string>& regs);
+
+// evaluates the controlling expression of a statement into the integer register reg
+void compileCondToReg(std::ostream &assemblyOut, AST* cond, const std::string& reg);
+
+/*
+    Arithmetic with a constant operand without going through hi and lo where possible.
+    Multiplications become shifts and additions, divisions by powers of two become shifts
+    and other signed divisions a multiplication by the reciprocal.
+    dst and src can be the same register, uses t6 as temporary.
+*/
+void multiplyByConstant(std::ostream &assemblyOut, const std::string& dst, const std::string& src, int factor);
+// false if the division has to be done with div (divisor 0 or unsigned divisor that isn't a power of two)
+bool canDivideByConstant(int divisor, bool isUnsigned);
+void divideByConstant(std::ostream &assemblyOut, const std::string& dst, const std::string& src, int divisor, bool isUnsigned, bool remainder);
+
+/*
+    Jumps to the label of the case matching the value in valueReg, cases are sorted by value.
+    Dense switches use a jump table indexed through indexReg, sparse ones a binary search
+    and tiny ones a chain of compares. Jumps to defaultLabel if no case matches.
+*/
+void compileSwitchDispatch(std::ostream& assemblyOut, const std::string& valueReg, const std::string& indexReg, const std::vector<std::pair<int, std::string>>& cases, const std::string& defaultLabel);
+
+/*
+    Constant folding helpers.
+    constantKind is INT for integer and character constants, FLOAT, DOUBLE, or VOID if node is not a constant.
+    makeConstant creates a constant that takes the place of the node "replaced" in the tree.
+*/
+TypeKind constantKind(AST* node);
+AST* makeConstant(AST* replaced, int value);
+AST* makeConstant(AST* replaced, float value);
+AST* makeConstant(AST* replaced, double value);
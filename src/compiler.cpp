@@ -18,9 +18,47 @@ void printAssemblyFooter(std::ostream &assemblyOut) {
     assemblyOut << ".ident	\"GCC: (Ubuntu 5.4.0-6ubuntu1~16.04.9) 5.4.0 20160609\"" << std::endl;
 }
 
-int main()
+// -O<level> chooses the passes that run, -f<pass> and -fno-<pass> turn one on or off (see pipeline.hpp)
+// -fno-peephole-<rule> disables a single peephole rule, -fdump-ir prints the IR of every function
+// -finline-threshold=<n> sets the cost up to which calls are inlined (see inliner.hpp)
+// -Rpass=<pass> and -Rpass-missed=<pass> report the decisions of a pass
+// --print-pipeline prints the passes instead of compiling
+bool parseOptions(int argc, char* argv[]) {
+    bool printPipeline = false;
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "--print-pipeline") {
+            printPipeline = true;
+        } else if (option.rfind("-O", 0) == 0) {
+            Pipeline::setLevel(option.substr(1));
+        } else if (option == "-fdump-ir") {
+            IRFunction::dump = true;
+        } else if (option.rfind("-finline-threshold=", 0) == 0) {
+            Inliner::threshold = std::stoi(option.substr(19));
+        } else if (option.rfind("-Rpass=", 0) == 0) {
+            Pipeline::enableRemarks(option.substr(7), false);
+        } else if (option.rfind("-Rpass-missed=", 0) == 0) {
+            Pipeline::enableRemarks(option.substr(14), true);
+        } else if (option.rfind("-fno-peephole-", 0) == 0) {
+            Peephole::disabledRules.insert(option.substr(14));
+        } else if (option.rfind("-fno-", 0) == 0) {
+            Pipeline::setPass(option.substr(5), false);
+        } else if (option.rfind("-f", 0) == 0) {
+            Pipeline::setPass(option.substr(2), true);
+        } else {
+            throw std::runtime_error("Unknown option " + option + "\n");
+        }
+    }
+    return printPipeline;
+}
+
+int main(int argc, char* argv[])
 {
     try {
+        if (parseOptions(argc, argv)) {
+            Pipeline::print(std::cout);
+            return 0;
+        }
 
         // parse the AST
         AST *ast = parseAST();
@@ -36,10 +74,18 @@ int main()
         // pre-process AST to generate Frame objects
         ast->generateFrames(globalFrame);
         std::cerr << "Frame Generation Works!" << std::endl;
+
+        // evaluate constant expressions at compile time
+        if (Pipeline::isEnabled("fold")) {
+            ast = ast->fold();
+            std::cerr << "Folding Works!" << std::endl;
+        }
                 
         ast->compile(std::cout);
         printAssemblyFooter(std::cout);
         std::cerr << "Compiling Works!" << std::endl;
+
+        Peephole::reportStats();
     }
     
     // general exception handler
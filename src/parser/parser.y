@@ -4,13 +4,19 @@
   #include <vector>
   #include <utility>
   #include <map>
+  #include <string_view>
   #include <unordered_map>
   #include <unordered_set>
 
   extern AST *g_root; // A way of getting the AST out
 
-  extern std::unordered_map<std::string, std::unordered_set<std::string>> lexer_types;
-  extern std::unordered_map<std::string, std::unordered_set<std::string>> lexer_pointerTypes;
+  // an identifier naming a type is lexed as token (T_TYPE or T_POINTERTYPE) with the built in type as value
+  struct LexerTypeName {
+    int token;
+    const std::string *type;
+  };
+  extern std::unordered_map<std::string_view, LexerTypeName> lexer_typeNames;
+  void lexer_addTypedef(const std::string &name, int token, const std::string *type);
   extern std::unordered_map<std::string, std::map<std::string, std::string>> lexer_structs;
 
   //! This is to fix problems when generating C++
@@ -32,7 +38,7 @@
   float FLOAT;
   double DOUBLE;
   char CHAR;
-  std::string *STR;
+  const std::string *STR; // interned (see symbols.hpp)
   std::vector<std::pair<AST*,std::string>> *FDP; // function declaration parameters
   std::vector<AST*> *FCP; // function call parameters
   std::vector<int> *SCP; // square chain parameters
@@ -138,22 +144,22 @@ STRUCT_DECLARATION : T_STRUCT T_IDENTIFIER T_IDENTIFIER T_SEMI_COLON {
                                          throw std::runtime_error("PARSER: STRUCT_DECLARATION: Failed to find struct type in lexer_structs.\n");
                                 }
 
-                                AST *type = new AST_Type(new std::string("struct"), declarations);
+                                AST *type = new AST_Type(Symbols::intern("struct"), declarations);
                                 AST* seq = new AST_VarDeclaration(type, $3, declarations);
 
                                 std::string varNameStructPrefix = *$3 + ".";
                                 auto decIt = declarations.begin();
                                 while (decIt != declarations.end()) {
-                                        std::string *varNamePtr = new std::string(varNameStructPrefix + decIt->first);
+                                        const std::string *varNamePtr = Symbols::intern(varNameStructPrefix + decIt->first);
 
                                         AST* declaration;
                                         if (decIt->second.find("*") != std::string::npos) {
-                                                AST* type = new AST_Type(new std::string(decIt->second.substr(0, decIt->second.find("*"))));
+                                                AST* type = new AST_Type(Symbols::intern(decIt->second.substr(0, decIt->second.find("*"))));
                                                 int size = std::stoi(decIt->second.substr(decIt->second.find("*")+1));
                                                 AST* arrayType = new AST_ArrayType(type, size);
                                                 declaration = new AST_ArrayDeclaration(arrayType, varNamePtr);
                                         } else {
-                                                AST* type = new AST_Type(new std::string(decIt->second));
+                                                AST* type = new AST_Type(Symbols::intern(decIt->second));
                                                 declaration = new AST_VarDeclaration(type, varNamePtr);
                                         }
                                         seq = new AST_Sequence(declaration, seq);
@@ -239,22 +245,22 @@ STRUCT_DEFINITION : T_STRUCT T_IDENTIFIER T_BRACE_L STRUCT_INTERNAL_DECLARATION_
 
                                 lexer_structs[*$5 + "unnamedStruct"] = declarations;
                                 
-                                AST *type = new AST_Type(new std::string("struct"), declarations);
+                                AST *type = new AST_Type(Symbols::intern("struct"), declarations);
                                 AST* seq = new AST_VarDeclaration(type, $5, declarations);
 
                                 std::string varNameStructPrefix = *$5 + ".";
                                 auto decIt = declarations.begin();
                                 while (decIt != declarations.end()) {
-                                        std::string *varNamePtr = new std::string(varNameStructPrefix + decIt->first);
+                                        const std::string *varNamePtr = Symbols::intern(varNameStructPrefix + decIt->first);
 
                                         AST* declaration;
                                         if (decIt->second.find("*") != std::string::npos) {
-                                                AST* type = new AST_Type(new std::string(decIt->second.substr(0, decIt->second.find("*"))));
+                                                AST* type = new AST_Type(Symbols::intern(decIt->second.substr(0, decIt->second.find("*"))));
                                                 int size = std::stoi(decIt->second.substr(decIt->second.find("*")+1));
                                                 AST* arrayType = new AST_ArrayType(type, size);
                                                 declaration = new AST_ArrayDeclaration(arrayType, varNamePtr);
                                         } else {
-                                                AST* type = new AST_Type(new std::string(decIt->second));
+                                                AST* type = new AST_Type(Symbols::intern(decIt->second));
                                                 declaration = new AST_VarDeclaration(type, varNamePtr);
                                         }
                                         seq = new AST_Sequence(declaration, seq);
@@ -388,45 +394,30 @@ SIZEOF : T_SIZEOF T_BRACK_L TYPE T_BRACK_R    { $$ = new AST_Sizeof($3); }
 
 TYPEDEF : T_TYPEDEF T_TYPE T_IDENTIFIER T_SEMI_COLON {
                         // Using the lexer hack
-                        auto it = lexer_types.find(*$2);
-                        if(it != lexer_types.end()) {
-                                it->second.insert(*$3);
-                        } else {
-                                throw std::runtime_error("PARSER: TYPEDEF: Failed to find typedef type in lexer_types.\n");
-                        }
-                        
+                        lexer_addTypedef(*$3, T_TYPE, $2);
+
                         // Assign something that has no effect
                         $$ = new AST_NoEffect();
                 }
         | T_TYPEDEF T_TYPE T_STAR T_IDENTIFIER T_SEMI_COLON {
                         // Using the lexer hack
-                        auto it = lexer_pointerTypes.find(*$2);
-                        if(it != lexer_pointerTypes.end()) {
-                                it->second.insert(*$4);
-                        } else {
-                                throw std::runtime_error("PARSER: TYPEDEF: Failed to find typedef type in lexer_pointerTypes.\n");
-                        }
-                        
+                        lexer_addTypedef(*$4, T_POINTERTYPE, $2);
+
                         // Assign something that has no effect
                         $$ = new AST_NoEffect();
                 }
         | T_TYPEDEF T_POINTERTYPE T_IDENTIFIER T_SEMI_COLON {
                         // Using the lexer hack
-                        auto it = lexer_pointerTypes.find(*$2);
-                        if(it != lexer_pointerTypes.end()) {
-                                it->second.insert(*$3);
-                        } else {
-                                throw std::runtime_error("PARSER: TYPEDEF: Failed to find typedef type in lexer_pointerTypes.\n");
-                        }
-                        
+                        lexer_addTypedef(*$3, T_POINTERTYPE, $2);
+
                         // Assign something that has no effect
                         $$ = new AST_NoEffect();
                 }
         ;
 
-TYPE : T_TYPE        { $$ = new AST_Type($1); }
+TYPE : T_TYPE        { $$ = AST_Type::get(AST_Type::kindOf(*$1)); }
      | TYPE T_STAR   { $$ = new AST_Pointer($1); }
-     | T_POINTERTYPE { $$ = new AST_Pointer(new AST_Type($1)); }
+     | T_POINTERTYPE { $$ = new AST_Pointer(AST_Type::get(AST_Type::kindOf(*$1))); }
      ;
 
 ENUM_DECLARATION : T_ENUM T_IDENTIFIER T_BRACE_L ENUM_LIST T_BRACE_R T_SEMI_COLON {
@@ -436,10 +427,10 @@ ENUM_DECLARATION : T_ENUM T_IDENTIFIER T_BRACE_L ENUM_LIST T_BRACE_R T_SEMI_COLO
                                         if (el.second != 0) {
                                                 count = el.second;
                                         }
-                                        std::string* intTypeName = new std::string("int");
-                                        AST* intType = new AST_Type(intTypeName);
+                                        AST* intType = AST_Type::get(TypeKind::INT);
                                         AST* val = new AST_ConstInt(count);
-                                        AST* dec = new AST_VarDeclaration(intType, &el.first, val);
+                                        AST_VarDeclaration* dec = new AST_VarDeclaration(intType, Symbols::intern(el.first), val);
+                                        dec->isEnumConstant = true;
                                         declarations.push_back(dec);
                                         count++;
                                 }
@@ -451,8 +442,7 @@ ENUM_DECLARATION : T_ENUM T_IDENTIFIER T_BRACE_L ENUM_LIST T_BRACE_R T_SEMI_COLO
                                 $$ = seq;
                         }
                  | T_ENUM T_IDENTIFIER T_IDENTIFIER T_SEMI_COLON {
-                                std::string* intTypeName = new std::string("int");
-                                AST* intType = new AST_Type(intTypeName);
+                                AST* intType = AST_Type::get(TypeKind::INT);
                                 AST* zero = new AST_ConstInt(0);
                                 $$ = new AST_VarDeclaration(intType, $3, zero); 
                         }
@@ -463,10 +453,10 @@ ENUM_DECLARATION : T_ENUM T_IDENTIFIER T_BRACE_L ENUM_LIST T_BRACE_R T_SEMI_COLO
                                         if (el.second != 0) {
                                                 count = el.second;
                                         }
-                                        std::string* intTypeName = new std::string("int");
-                                        AST* intType = new AST_Type(intTypeName);
+                                        AST* intType = AST_Type::get(TypeKind::INT);
                                         AST* val = new AST_ConstInt(count);
-                                        AST* dec = new AST_VarDeclaration(intType, &el.first, val);
+                                        AST_VarDeclaration* dec = new AST_VarDeclaration(intType, Symbols::intern(el.first), val);
+                                        dec->isEnumConstant = true;
                                         declarations.push_back(dec);
                                         count++;
                                 }
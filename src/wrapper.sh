@@ -1,7 +1,25 @@
 #!/bin/bash
 set -e
 
+# bin/c_compiler [options] -S <input> -o <output>, other options are passed on to bin/compiler
+input=""
+output=""
+options=()
+while [ $# -gt 0 ]; do
+    case "$1" in
+        -S) input="$2"; shift 2 ;;
+        -o) output="$2"; shift 2 ;;
+        *) options+=("$1"); shift ;;
+    esac
+done
+
+# nothing to compile, e.g. --print-pipeline
+if [ -z "$input" ]; then
+    ./bin/compiler "${options[@]}"
+    exit
+fi
+
 echo "Compiling to MIPS..."
-cat $2 | ./bin/compiler 2> bin/log.txt 1> $4
+cat "$input" | ./bin/compiler "${options[@]}" 2> bin/log.txt 1> "$output"
 
 echo "Compiling finished!"